@@ -41,15 +41,12 @@ const std::vector<std::string> g_filter_name_vec = {
 };
 
 
-static std::string g_str_pipe_desc = std::string("null");
 static std::string g_str_server_uri = std::string("null");
-static std::string g_str_algopipeline = std::string("null");
 static std::string g_str_default_server_uri = std::string("wss://localhost:8123/binaryEchoWithSize?id=3");
-static std::string g_str_srtp_desc = std::string("null");
-static std::string g_str_helper_desc = std::string("null");
 
 static gint g_pipe_id = 0;
 static gint g_loop_times = 1;
+static gboolean g_host_mode = FALSE;
 
 #define DEFAULT_ALGO_PIPELINE "yolov1tiny ! opticalflowtrack ! googlenetv2"
 
@@ -72,17 +69,19 @@ static gint g_loop_times = 1;
         " -u --specify uri of ipc server.\n"
         " -i --specify id of ipc client.\n"
         " -l --specify the loop times.\n"
+        " -m --host mode, run all pipes created by server in this process.\n"
          "-h --help Display this usage information.\n");
     exit (exit_code);
   }
 
 static gboolean  parse_cmdline (int argc, char *argv[])
 {
-     const char* const brief = "hu:i:l:";
+     const char* const brief = "hu:i:l:m";
       const struct option details[] = {
                 { "serveruri", 1, NULL, 'u'},
                 { "clientid", 1, NULL, 'i',},
                 { "looptimes", 1, NULL, 'l'},
+                { "hostmode", 0, NULL, 'm'},
                 { "help", 0, NULL, 'h'},
                 { NULL, 0, NULL, 0 }
        };
@@ -103,6 +102,9 @@ static gboolean  parse_cmdline (int argc, char *argv[])
                 if(g_loop_times<1)
                     g_loop_times = 1;
                 break;
+            case 'm':
+                g_host_mode = TRUE;
+                break;
             case 'h': /* help */
                 print_usage (argv[0], 0);
                 break;
@@ -144,8 +146,11 @@ static int set_property(struct json_object *parent, HddlsPipe *hp, const char *f
                     str_property_name = std::string(property_name);
                     if(!str_property_name.compare(0, 12, "algopipeline")) {
                         property_string = json_object_get_string (property);
-                        g_str_algopipeline =  std::string(property_string);
-                        GST_INFO("g_algopipeline = %s\n ",g_str_algopipeline.c_str());
+                        g_free(hp->algopipeline);
+                        hp->algopipeline = g_strdup(property_string);
+                        GST_INFO("algopipeline = %s\n ",hp->algopipeline);
+                        // cvdlfilter swaps its algo pipeline in background, the pipe keeps running
+                        HDDLSPIPE_SET_PROPERTY( hp, filter_name, property_name, property_string, NULL);
                         ret = 1;
                         json_object_iter_next (&iter);
                         continue;
@@ -205,8 +210,8 @@ static void process_commands(HddlsPipe *hp, char *desc)
                  break;
         case eCommand_PipeDestroy:
                 g_print("Receive command: destroy pipeline....\n");
-                hddlspipe_stop (hp);
                 hp->state = ePipeState_Null;
+                hddlspipe_stop (hp);
                 break;
         case eCommand_SetProperty:
                 GST_INFO("Receive command: set pipeline....\n");
@@ -220,27 +225,26 @@ static void process_commands(HddlsPipe *hp, char *desc)
                 break;
       }
       if(ret==1) {
-         g_loop_times++;
-         //update g_pipe_desc
+         //update pipe_desc, so that a replayed pipe runs the new algopipeline
          // filesrc location=~/1600x1200_concat.mp4  ! qtdemux  ! h264parse
          // ! mfxh264dec  ! cvdlfilter name=cvdlfilter0 algopipeline="yolov1tiny ! opticalflowtrack ! googlenetv2"
          // ! resconvert name=resconvert0  resconvert0.src_pic ! mfxjpegenc
          // ! ipcsink name=ipcsink0 ipcclientid=13   resconvert0.src_txt ! ipcsink0.
-         gchar* begin = g_strstr_len(g_str_pipe_desc.c_str(), 1024, "algopipeline=" );
+         gchar* begin = g_strstr_len(hp->pipe_desc, 1024, "algopipeline=" );
          gchar* end = NULL;
          gchar *secA = NULL, *secC=NULL;
          if(begin) {
                 begin = begin+14;
                 end = g_strstr_len(begin,64, "\"" );
                 if(end) {
-                    secA = g_strndup(g_str_pipe_desc.c_str(), begin - g_str_pipe_desc.c_str());
+                    secA = g_strndup(hp->pipe_desc, begin - hp->pipe_desc);
                     secC = end;//g_strndup(end, strnlen_s(end, 1024));
-                    // replace g_pipe_desc
-                    GST_INFO("old g_pipe_desc = %s\n", g_str_pipe_desc.c_str());
-                    g_str_pipe_desc = std::string(secA) + g_str_algopipeline + std::string(secC);
-                    GST_INFO("new g_pipe_desc = %s\n", g_str_pipe_desc.c_str());
-                    if(secA && secC)
-                        hddlspipe_stop (hp);
+                    // replace pipe_desc
+                    GST_INFO("old pipe_desc = %s\n", hp->pipe_desc);
+                    gchar *new_desc = g_strconcat(secA, hp->algopipeline, secC, NULL);
+                    g_free(hp->pipe_desc);
+                    hp->pipe_desc = new_desc;
+                    GST_INFO("new pipe_desc = %s\n", hp->pipe_desc);
                     if(secA) g_free(secA);
                 }
         }
@@ -264,7 +268,8 @@ static gpointer thread_handle_message(void *data)
         return NULL;
 }
 
-static const gchar* parse_create_command(char *desc,  gint pipe_id, IPCClientHandle ipc)
+// Generate the pipe desc from the create command, the caller should free it
+static gchar* parse_create_command(char *desc,  gint pipe_id, IPCClientHandle ipc, E_ERROR_CODE *err)
 {
       struct json_object *root = NULL;
       struct json_object *object = NULL;
@@ -276,15 +281,18 @@ static const gchar* parse_create_command(char *desc,  gint pipe_id, IPCClientHan
       E_CODEC_TYPE codec_type = eCodecTypeNone;
       int srtp_port = 5000;
       int output_type = 1;// 0 - meta_data; 1 - meta data + jpeg data  
+      std::string str_pipe_desc, str_srtp_desc, str_helper_desc;
 
      root = json_create(desc);
      if(!root) {
         g_print("%s() - failed to create json object!\n",__func__);
+        *err = eErrorInvalideJsonObject;
         return NULL;
      }
 
      if(json_get_command_type(root) != eCommand_PipeCreate) {
             g_print("%s() - failed to create pipeline due to invalid command from server!\n", __func__);
+            *err = eErrorInvalideJsonObject;
             json_destroy(&root);
             return NULL;
      }
@@ -320,15 +328,17 @@ static const gchar* parse_create_command(char *desc,  gint pipe_id, IPCClientHan
                          //   str_algo_pipeline_desc.c_str(),  algo_pipeline_desc);
                          g_print("warning - get empty algopipeline, exit!\n");
                          ipcclient_upload_error_info(ipc, "warning - get empty algopipeline, exit!\n");
-                         g_usleep(10000);
-                         exit(eErrorInvalideAlgopipeline);
+                         *err = eErrorInvalideAlgopipeline;
+                         json_destroy(&root);
+                         return NULL;
                      }
              } else { //default
                     algo_pipeline_desc = DEFAULT_ALGO_PIPELINE;
                     g_print("warning - failed to get algopipeline, exit!\n");
                     ipcclient_upload_error_info(ipc, "warning - failed to get algopipeline, exit!\n");
-                    g_usleep(10000);
-                    exit(eErrorInvalideAlgopipeline);
+                    *err = eErrorInvalideAlgopipeline;
+                    json_destroy(&root);
+                    return NULL;
              }
     }
     if(!stream_source || !stream_codec_type) {
@@ -342,6 +352,7 @@ static const gchar* parse_create_command(char *desc,  gint pipe_id, IPCClientHan
                 std::string(", stream_codec_type=") + std::string(stream_codec_type) + std::string("\n");
             ipcclient_upload_error_info(ipc, err_info.c_str());
             g_print("%s",err_info.c_str());
+            *err = eErrorInvalideJsonObject;
             json_destroy(&root);
             return NULL;
      }
@@ -361,67 +372,68 @@ static const gchar* parse_create_command(char *desc,  gint pipe_id, IPCClientHan
             std::string err_info = std::string("error- failed to get valid codec type : ") + str_stream_codec_type + std::string("\n");
             ipcclient_upload_error_info(ipc, err_info.c_str());
             g_print("%s",err_info.c_str());
+            *err = eErrorInvalideJsonObject;
             json_destroy(&root);
             return NULL;
      }
      if(output_type) {
         // meta data + jpeg data
-        g_str_helper_desc = std::string(" ! cvdlfilter name=cvdlfilter0 algopipeline=\"") + std::string(algo_pipeline_desc) + std::string("\" ") +
+        str_helper_desc = std::string(" ! cvdlfilter name=cvdlfilter0 algopipeline=\"") + std::string(algo_pipeline_desc) + std::string("\" ") +
                           std::string(" ! resconvert name=resconvert0 resconvert0.src_pic ! mfxjpegenc ! ipcsink name=ipcsink0 ipcclientid=") +
                           std::to_string(pipe_id)  + std::string("  resconvert0.src_txt ! ipcsink0.");
      }else {
        // meta data
-       g_str_helper_desc = std::string(" ! cvdlfilter name=cvdlfilter0 algopipeline=\"") + std::string(algo_pipeline_desc) + std::string("\" ") +
+       str_helper_desc = std::string(" ! cvdlfilter name=cvdlfilter0 algopipeline=\"") + std::string(algo_pipeline_desc) + std::string("\" ") +
                           std::string(" ! resconvert name=resconvert0 resconvert0.src_txt ! ipcsink name=ipcsink0 ipcclientid=") +
                           std::to_string(pipe_id);
      }
 
     if( ((std::string(stream_source).compare("srtp")) || (std::string(stream_source).compare("SRTP"))) && srtp_caps) {
-        g_str_srtp_desc = std::string("udpsrc") + std::string(" port=") + std::to_string(srtp_port) +
+        str_srtp_desc = std::string("udpsrc") + std::string(" port=") + std::to_string(srtp_port) +
                                          std::string(" caps=\"") + std::string(srtp_caps) + std::string("\" ") +  std::string(" ! srtpdec ! ");
 
         if(codec_type == eCodecTypeH264) {
-             g_str_pipe_desc = g_str_srtp_desc +
-                                               std::string(" rtph264depay  ! h264parse ! mfxh264dec ") + g_str_helper_desc;
+             str_pipe_desc = str_srtp_desc +
+                                               std::string(" rtph264depay  ! h264parse ! mfxh264dec ") + str_helper_desc;
         } else if(codec_type == eCodecTypeH265) {
-             g_str_pipe_desc =g_str_srtp_desc +
-                                             std::string("  rtph265depay  ! h265parse ! mfxhevcdec ") +  g_str_helper_desc;
+             str_pipe_desc =str_srtp_desc +
+                                             std::string("  rtph265depay  ! h265parse ! mfxhevcdec ") +  str_helper_desc;
          }
 
-        g_print("pipeline: %s\n",g_str_pipe_desc.c_str() );
+        g_print("pipeline: %s\n",str_pipe_desc.c_str() );
         json_destroy(&root);
 
-        return g_str_pipe_desc.c_str();
+        return g_strdup(str_pipe_desc.c_str());
     }
 
      // 2.2 get source type: rtsp or local file
      if( g_strrstr_len(stream_source, 256, "rtsp")  || g_strrstr_len(stream_source, 256, "RTSP")) {
            // rtsp
            if(codec_type == eCodecTypeH264) {
-                g_str_pipe_desc = std::string("rtspsrc location=") + std::string(stream_source)
+                str_pipe_desc = std::string("rtspsrc location=") + std::string(stream_source)
                                                 +std::string(" udp-buffer-size=1000000 ! rtph264depay  ! h264parse ! mfxh264dec ")
-                                                +g_str_helper_desc;
+                                                +str_helper_desc;
            } else if(codec_type == eCodecTypeH265) {
-                g_str_pipe_desc = std::string("rtspsrc location=") + std::string(stream_source)
+                str_pipe_desc = std::string("rtspsrc location=") + std::string(stream_source)
                                                 +std::string(" udp-buffer-size=1000000 ! rtph265depay  ! h265parse ! mfxhevcdec ")
-                                                +g_str_helper_desc;
+                                                +str_helper_desc;
             }
      } else {
           // local files
            if(codec_type == eCodecTypeH264) {
-                g_str_pipe_desc = std::string("filesrc location=") + std::string(stream_source)
+                str_pipe_desc = std::string("filesrc location=") + std::string(stream_source)
                                                 +std::string("  ! qtdemux  ! h264parse ! mfxh264dec ")
-                                                +g_str_helper_desc;
+                                                +str_helper_desc;
            } else if(codec_type == eCodecTypeH265) {
-                 g_str_pipe_desc = std::string("filesrc location=") + std::string(stream_source)
+                 str_pipe_desc = std::string("filesrc location=") + std::string(stream_source)
                                                 +std::string("  ! qtdemux  ! h265parse ! mfxhevcdec ")
-                                                +g_str_helper_desc;
+                                                +str_helper_desc;
             }
     }
-    g_print("pipeline: %s\n",g_str_pipe_desc.c_str() );
+    g_print("pipeline: %s\n",str_pipe_desc.c_str() );
     json_destroy(&root);
 
-    return g_str_pipe_desc.c_str();
+    return g_strdup(str_pipe_desc.c_str());
 }
 
 static gboolean bus_callback (GstBus* bus, GstMessage* msg, gpointer data)
@@ -453,6 +465,17 @@ static gboolean bus_callback (GstBus* bus, GstMessage* msg, gpointer data)
         //ipcclient_upload_error_info(hp->ipc, "Got EOS");
         hddlspipe_stop (hp);
         break;
+    case GST_MESSAGE_ELEMENT: {
+        // an algo of cvdlfilter is over its SLO, report it but keep the pipe running
+        const GstStructure *s = gst_message_get_structure (msg);
+        if (s && gst_structure_has_name (s, "cvdl-stall")) {
+            gchar *info = gst_structure_to_string (s);
+            g_print ("WARNING: %s\n", info);
+            ipcclient_upload_error_info(hp->ipc, info);
+            g_free (info);
+        }
+        break;
+    }
     default:
         /* unhandled message */
         //LOG_DEBUG ("unhandled message");
@@ -472,76 +495,132 @@ void hddlspipe_prepare(int argc, char **argv)
         gst_init (&argc, &argv);
 }
 
+gboolean hddlspipe_is_host_mode()
+{
+    return g_host_mode;
+}
+
+static IPCClientHandle hddlspipe_ipc_setup(gint id)
+{
+   if(!g_str_server_uri.compare("null"))
+        return ipcclient_setup(g_str_default_server_uri.c_str(),  id);
+   else
+        return ipcclient_setup(g_str_server_uri.c_str(),  id);
+}
+
+// Build gst pipeline based on hp->pipe_desc
+static gboolean hddlspipe_build(HddlsPipe *hp)
+{
+    GError     *error = NULL;
+
+    hp->pipeline = gst_parse_launch (hp->pipe_desc, &error);
+    if (error || ! hp->pipeline) {
+        g_print ("failed to build pipeline, error message: %s\n",(error) ? error->message : NULL);
+        if(hp->host)
+            ipcclient_upload_error_info(hp->ipc, (error) ? error->message : "failed to build pipeline");
+        if(error)
+            g_error_free (error);
+        if(hp->pipeline)
+            gst_object_unref (hp->pipeline);
+        hp->pipeline = NULL;
+        return FALSE;
+    }
+    HDDLSPIPE_SET_PROPERTY( hp, IPCSINK_NAME, "ipcclientproxy", hp->ipc, NULL);
+
+    // set watch bus
+    GstBus *bus = gst_element_get_bus (hp->pipeline);
+    hp->bus_watch_id = gst_bus_add_watch (bus, bus_callback,hp);
+    gst_object_unref (bus);
+
+    // pipes in host mode run in the main loop of host
+    if(!hp->host)
+        hp->loop = g_main_loop_new (NULL, FALSE);
+    hp->state = ePipeState_Ready;
+    return TRUE;
+}
+
+// Create a pipe from the create command
+static HddlsPipe *hddlspipe_new(IPCClientHandle ipc, gint pipe_id, char *desc,
+        HddlsPipeHost *host, E_ERROR_CODE *err)
+{
+    HddlsPipe *hp = g_new0(HddlsPipe, 1);
+    hp->ipc = ipc;
+    hp->pipe_id = pipe_id;
+    hp->host = host;
+    hp->loop_times = g_loop_times;
+    hp->state = ePipeState_Null;
+
+    // parse pipeline_create command
+    hp->pipe_desc = parse_create_command(desc, hp->pipe_id, hp->ipc, err);
+    if(!hp->pipe_desc) {
+        g_print("Failed to get pipeline description!\n");
+        g_free(hp);
+        return NULL;
+    }
+    hp->algopipeline = g_strdup("null");
+
+    //create pipeline
+    if(!hddlspipe_build(hp)) {
+        *err = eErrorInvalidPipeline;
+        g_free(hp->pipe_desc);
+        g_free(hp->algopipeline);
+        g_free(hp);
+        return NULL;
+    }
+
+    // start command thread
+    hp->message_handle_thread = g_thread_new("message_thread",thread_handle_message, (void *)hp);
+    return hp;
+}
+
 /**
   *   1. create hddls-pipe, connet to ipc server
   *   2. wait to receive pipe desc from server, and setup pipe based on desc
   **/
  HddlsPipe*   hddlspipe_create( )
 {
-    HddlsPipe *hp = g_new0(HddlsPipe, 1);
+    HddlsPipe *hp = NULL;
     MessageItem *item = NULL;
-    const gchar* pipeline_desc = NULL;
-    GError     *error = NULL;
+    IPCClientHandle ipc = NULL;
+    E_ERROR_CODE err = eErrorNone;
 
    // 1. create ipc client
-   //if(!strcmp_s(g_server_uri, 4, "null", &indicator)) {
-   if(!g_str_server_uri.compare("null")) {
-        hp->ipc = ipcclient_setup(g_str_default_server_uri.c_str(),  g_pipe_id);
-   } else {
-         hp->ipc = ipcclient_setup(g_str_server_uri.c_str(),  g_pipe_id);
-    }
-   hp->pipe_id = g_pipe_id;
+   ipc = hddlspipe_ipc_setup(g_pipe_id);
     //it has connected to ipc server.
 
    // Block wait until get desc data from ipc server
-    item = (MessageItem *)ipcclient_get_data(hp->ipc);
+    item = (MessageItem *)ipcclient_get_data(ipc);
     if(!item) {
         g_print("Failed to get MessageItem!\n");
         return NULL;
     }
-    GST_INFO("%s() -pipe %d  received message: %s\n", __func__, hp->pipe_id, item->data);
-    hp->state = ePipeState_Null;
+    GST_INFO("%s() -pipe %d  received message: %s\n", __func__, g_pipe_id, item->data);
 
-    // parse pipeline_create command
-    pipeline_desc = parse_create_command(item->data, hp->pipe_id, hp->ipc);
+    hp = hddlspipe_new(ipc, g_pipe_id, item->data, NULL, &err);
     ipcclient_free_item(item);
-    if(!pipeline_desc) {
-        g_print("Failed to get pipeline description!\n");
-        return NULL;
+    if(!hp && err == eErrorInvalideAlgopipeline) {
+        g_usleep(10000);
+        exit(eErrorInvalideAlgopipeline);
     }
-    //create pipeline
-    hp->pipeline = gst_parse_launch (pipeline_desc, &error);
-   if (error || ! hp->pipeline) {
-       g_print ("failed to build pipeline, error message: %s\n",(error) ? error->message : NULL);
-       return NULL;
-   }
-    HDDLSPIPE_SET_PROPERTY( hp, IPCSINK_NAME, "ipcclientproxy", hp->ipc, NULL);
-
-    // set watch bus
-    GstBus *bus = gst_element_get_bus (hp->pipeline);
-    hp->bus_watch_id = gst_bus_add_watch (bus, bus_callback,hp);
-    gst_object_unref (bus);
-
-    hp->loop = g_main_loop_new (NULL, FALSE);
-    hp->state = ePipeState_Ready;
-
-    // start command thread
-    hp->message_handle_thread = g_thread_new("message_thread",thread_handle_message, (void *)hp);
     return hp;
 }
 
 
 /**
  *  Thread will loop in this function until calling hddlspipe_stop().
+ *  In host mode, it returns directly and the pipe runs in the main loop of host.
  **/
  void  hddlspipe_start(HddlsPipe * hp)
 {
      g_assert (hp);
      gst_element_set_state (hp->pipeline, GST_STATE_PLAYING);
      hp->state = ePipeState_Running;
-     g_main_loop_run (hp->loop);
+     if(!hp->host)
+         g_main_loop_run (hp->loop);
 }
 
+static gboolean host_pipe_stopped(gpointer data);
+
 /**
  *  Stop hddlspipe.
  **/
@@ -549,8 +628,14 @@ void hddlspipe_prepare(int argc, char **argv)
 {
      g_assert (hp);
      gst_element_set_state (hp->pipeline, GST_STATE_NULL);
-     hp->state = ePipeState_Ready;
-     g_main_loop_quit (hp->loop);
+     // keep the destroyed state
+     if(hp->state != ePipeState_Null)
+         hp->state = ePipeState_Ready;
+     if(!hp->host)
+         g_main_loop_quit (hp->loop);
+     else if(g_atomic_int_compare_and_exchange(&hp->stop_pending, FALSE, TRUE))
+         // replay or destroy it in main loop, other pipes are not affected
+         g_idle_add(host_pipe_stopped, hp);
 }
 
 /**
@@ -575,41 +660,32 @@ void hddlspipe_prepare(int argc, char **argv)
      hp->state = ePipeState_Ready;
 }
 
-static void hddlspipes_replay(HddlsPipe *hp)
+static gboolean hddlspipes_replay(HddlsPipe *hp)
 {
-      GError     *error = NULL;
       if(!hp) {
         g_print("Error: hp==null!\n");
-        return;
+        return FALSE;
       }
 
       g_source_remove (hp->bus_watch_id);
       gst_object_unref (hp->pipeline);
-      g_main_loop_unref (hp->loop);
-
-      hp->pipeline = gst_parse_launch (g_str_pipe_desc.c_str(), &error);
-      if (error) {
-          g_print ("ERROR: %s\n", error->message);
-          //g_error_free (error);
-      }
-       HDDLSPIPE_SET_PROPERTY( hp, IPCSINK_NAME, "ipcclientproxy", hp->ipc, NULL);
-
-        // set watch bus
-       GstBus *bus = gst_element_get_bus (hp->pipeline);
-       hp->bus_watch_id = gst_bus_add_watch (bus, bus_callback,hp);
-       gst_object_unref (bus);
-
-       hp->loop = g_main_loop_new (NULL, FALSE);
-       hp->state = ePipeState_Ready;
-
-       hddlspipe_start(hp);
+      hp->pipeline = NULL;
+      if(hp->loop)
+          g_main_loop_unref (hp->loop);
+      hp->loop = NULL;
+
+      if(!hddlspipe_build(hp))
+          return FALSE;
+      hddlspipe_start(hp);
+      return TRUE;
 }
 
 void  hddlspipes_replay_if_need(HddlsPipe *hp)
 {
-     while( --g_loop_times > 0) {
+     while( --hp->loop_times > 0) {
           if( hp && hp->state != ePipeState_Null)
-                hddlspipes_replay(hp);
+                if(!hddlspipes_replay(hp))
+                    break;
      }
 }
 
@@ -627,9 +703,201 @@ void hddlspipe_destroy(HddlsPipe *hp)
         ipcclient_destroy(hp->ipc);
     hp->ipc = NULL;
 
-    g_source_remove (hp->bus_watch_id);
-    gst_object_unref (hp->pipeline);
-    g_main_loop_unref (hp->loop);
+    if(hp->pipeline) {
+        g_source_remove (hp->bus_watch_id);
+        gst_object_unref (hp->pipeline);
+    }
+    if(hp->loop)
+        g_main_loop_unref (hp->loop);
 
+    g_free(hp->pipe_desc);
+    g_free(hp->algopipeline);
     g_free(hp);
 }
+
+// A pipe of host has been stopped: replay it if need, otherwise destroy it
+static gboolean host_pipe_stopped(gpointer data)
+{
+    HddlsPipe *hp = (HddlsPipe*)data;
+    HddlsPipeHost *host = hp->host;
+
+    g_atomic_int_set(&hp->stop_pending, FALSE);
+    if(hp->state != ePipeState_Null && --hp->loop_times > 0) {
+        if(hddlspipes_replay(hp))
+            return G_SOURCE_REMOVE;
+    }
+
+    g_mutex_lock(&host->lock);
+    host->pipes = g_list_remove(host->pipes, hp);
+    gboolean quit = host->quitting && !host->pipes;
+    g_mutex_unlock(&host->lock);
+
+    g_print("host %d: pipe %d is done\n", host->host_id, hp->pipe_id);
+    hddlspipe_destroy(hp);
+    if(quit)
+        g_main_loop_quit (host->loop);
+    return G_SOURCE_REMOVE;
+}
+
+// Create pipes with the create command, the pipes get ids from "client_id" of the command,
+// or are assigned the ids after host id. Each pipe has its own ipc client with its id.
+static void host_create_pipes(HddlsPipeHost *host, char *desc, struct json_object *root)
+{
+    int client_id = -1;
+    int pipe_num = 1;
+    int i;
+
+    json_get_int(root, "client_id", &client_id);
+    json_get_int_d2(root, "command_create", "pipe_num", &pipe_num);
+    if(pipe_num < 1)
+        pipe_num = 1;
+
+    for(i = 0; i < pipe_num; i++) {
+        E_ERROR_CODE err = eErrorNone;
+        gint pipe_id;
+
+        g_mutex_lock(&host->lock);
+        if(client_id >= 0) {
+            pipe_id = client_id + i;
+            if(pipe_id >= host->next_pipe_id)
+                host->next_pipe_id = pipe_id + 1;
+        } else {
+            pipe_id = host->next_pipe_id++;
+        }
+        g_mutex_unlock(&host->lock);
+
+        IPCClientHandle ipc = hddlspipe_ipc_setup(pipe_id);
+        HddlsPipe *hp = hddlspipe_new(ipc, pipe_id, desc, host, &err);
+        if(!hp) {
+            // only this pipe fails
+            std::string err_info = std::string("error - host failed to create pipe ") +
+                std::to_string(pipe_id) + std::string(", error code = ") + std::to_string(err);
+            g_print("%s\n", err_info.c_str());
+            ipcclient_upload_error_info(host->ipc, err_info.c_str());
+            ipcclient_destroy(ipc);
+            continue;
+        }
+
+        g_mutex_lock(&host->lock);
+        host->pipes = g_list_append(host->pipes, hp);
+        g_mutex_unlock(&host->lock);
+        g_print("host %d: pipe %d is created\n", host->host_id, pipe_id);
+        hddlspipe_start(hp);
+    }
+}
+
+// Destroy the pipe with "client_id", or all pipes if it is -1
+static void host_destroy_pipes(HddlsPipeHost *host, struct json_object *root)
+{
+    int client_id = -1;
+    GList *l = NULL;
+
+    json_get_int(root, "client_id", &client_id);
+
+    g_mutex_lock(&host->lock);
+    if(client_id < 0) {
+        host->quitting = TRUE;
+        if(!host->pipes)
+            g_main_loop_quit (host->loop);
+    }
+    for(l = host->pipes; l; l = l->next) {
+        HddlsPipe *hp = (HddlsPipe *)l->data;
+        if(client_id < 0 || hp->pipe_id == client_id) {
+            hp->state = ePipeState_Null;
+            hddlspipe_stop (hp);
+        }
+    }
+    g_mutex_unlock(&host->lock);
+}
+
+static gpointer thread_handle_host_message(void *data)
+{
+    HddlsPipeHost *host = (HddlsPipeHost*)data;
+    MessageItem *item = NULL;
+    struct json_object *root = NULL;
+
+    while(host->running) {
+        item = ipcclient_get_data_timed(host->ipc);
+        if(!item)
+            continue;
+        if(item->len<=0) {
+            ipcclient_free_item(item);
+            continue;
+        }
+
+        g_print("host %d has got message: %s\n", host->host_id, item->data);
+        root = json_create(item->data);
+        if(!root) {
+            g_print("%s() - failed to create json object from description!\n",__func__);
+            ipcclient_free_item(item);
+            continue;
+        }
+        switch(json_get_command_type(root)){
+            case eCommand_PipeCreate:
+                host_create_pipes(host, item->data, root);
+                break;
+            case eCommand_PipeDestroy:
+                host_destroy_pipes(host, root);
+                break;
+            default:
+                // properties are set by the ipc client of each pipe
+                g_print("Receive invalid message for host: %s\n", item->data);
+                break;
+        }
+        json_destroy(&root);
+        ipcclient_free_item(item);
+    }
+    return NULL;
+}
+
+/**
+  *   Create pipe host, connect to ipc server with the control connection
+  **/
+HddlsPipeHost *hddlspipes_host_create()
+{
+    HddlsPipeHost *host = g_new0(HddlsPipeHost, 1);
+
+    host->host_id = g_pipe_id;
+    host->next_pipe_id = g_pipe_id + 1;
+    host->ipc = hddlspipe_ipc_setup(g_pipe_id);
+    if(!host->ipc) {
+        g_free(host);
+        return NULL;
+    }
+    g_mutex_init(&host->lock);
+    host->loop = g_main_loop_new (NULL, FALSE);
+    host->running = TRUE;
+    host->message_handle_thread = g_thread_new("host_message_thread",
+        thread_handle_host_message, (void *)host);
+    return host;
+}
+
+/**
+ *  Thread will loop in this function until all pipes are destroyed.
+ **/
+void hddlspipes_host_run(HddlsPipeHost *host)
+{
+    g_assert (host);
+    g_main_loop_run (host->loop);
+}
+
+void hddlspipes_host_destroy(HddlsPipeHost *host)
+{
+    host->running = FALSE;
+    if(host->message_handle_thread)
+        g_thread_join(host->message_handle_thread);
+    host->message_handle_thread = NULL;
+
+    while(host->pipes) {
+        HddlsPipe *hp = (HddlsPipe *)host->pipes->data;
+        host->pipes = g_list_remove(host->pipes, hp);
+        gst_element_set_state (hp->pipeline, GST_STATE_NULL);
+        hddlspipe_destroy(hp);
+    }
+
+    if(host->ipc)
+        ipcclient_destroy(host->ipc);
+    g_main_loop_unref (host->loop);
+    g_mutex_clear(&host->lock);
+    g_free(host);
+}
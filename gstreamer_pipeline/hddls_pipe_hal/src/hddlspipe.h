@@ -54,6 +54,8 @@ enum E_CODEC_TYPE{
     eCodecTypeH265 = 1,
 };
 
+typedef struct _HddlsPipeHost HddlsPipeHost;
+
 typedef struct _HddlsPipe {
     enum E_PIPE_STATE      state;
     GMainLoop           *loop;
@@ -63,8 +65,28 @@ typedef struct _HddlsPipe {
     IPCClientHandle ipc;
     GThread              *message_handle_thread;
     gint pipe_id;
+    gchar *pipe_desc;
+    gchar *algopipeline;
+    gint loop_times;
+    // not NULL if it runs in host mode
+    HddlsPipeHost *host;
+    gint stop_pending;
 }HddlsPipe;
 
+// Host mode: one process runs all pipes created by the commands from one control connection,
+// the pipes share the main context, OpenCL device and IE networks in this process.
+struct _HddlsPipeHost {
+    GMainLoop           *loop;
+    IPCClientHandle ipc;
+    GThread              *message_handle_thread;
+    GMutex lock;
+    GList *pipes;
+    gint host_id;
+    gint next_pipe_id;
+    gboolean running;
+    gboolean quitting;
+};
+
 void hddlspipe_prepare(int argc, char **argv);
 HddlsPipe*   hddlspipe_create( );
 void  hddlspipe_start(HddlsPipe * hp);
@@ -73,4 +95,9 @@ void hddlspipe_resume(HddlsPipe *pipe);
 void hddlspipe_pause(HddlsPipe *pipe);
 void hddlspipe_destroy(HddlsPipe *pipe);
  void hddlspipes_replay_if_need(HddlsPipe *pipe);
+
+gboolean hddlspipe_is_host_mode();
+HddlsPipeHost *hddlspipes_host_create();
+void hddlspipes_host_run(HddlsPipeHost *host);
+void hddlspipes_host_destroy(HddlsPipeHost *host);
 #endif
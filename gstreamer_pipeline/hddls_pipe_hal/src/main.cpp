@@ -28,6 +28,18 @@ int  main(int argc, char **argv)
     HddlsPipe*   pipe = NULL;
     hddlspipe_prepare(argc, argv);
 
+    if(hddlspipe_is_host_mode()) {
+        HddlsPipeHost *host = hddlspipes_host_create();
+        if(!host) {
+            g_print("Error: failed to create pipe host!\n");
+            return eErrorInvalidPipeline;
+        }
+        // blocked until all pipes are destroyed
+        hddlspipes_host_run(host);
+        hddlspipes_host_destroy(host);
+        return eErrorNone;
+    }
+
     pipe = hddlspipe_create( );
     if(!pipe) {
         g_print("Error: failed to create pipeline!\n");
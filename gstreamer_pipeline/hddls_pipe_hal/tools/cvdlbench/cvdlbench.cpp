@@ -0,0 +1,576 @@
+/*Copyright (C) 2018 Intel Corporation
+  *
+  *SPDX-License-Identifier: MIT
+  *
+  *MIT License
+  *
+  *Copyright (c) 2018 Intel Corporation
+  *
+  *Permission is hereby granted, free of charge, to any person obtaining a copy of
+  *this software and associated documentation files (the "Software"),
+  *to deal in the Software without restriction, including without limitation the rights to
+  *use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+  *and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+  *
+  *The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+  *
+  *THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+  *INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+  *AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+  *DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  *OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+  */
+
+// cvdlbench - offline benchmark of algo pipeline
+//
+// It drives algo pipelines directly with NV12 frames in system memory, no decoder,
+// VA display or IPC server is needed. Every stream is an algo pipeline, like a cvdlfilter.
+// It sweeps stream number, object number per frame and algo chain, and reports
+// fps, end to end and per algo latency percentiles, CPU usage as json.
+//
+// The models are loaded from $HDDLS_CVDL_MODEL_PATH, the same as cvdlfilter.
+//
+// Example:
+//   cvdlbench -a "mobilenetssd ! opticalflowtrack ! googlenetv2" -s 1,2,4 -o 0,8 -d CPU
+//
+// The algo threads can be pinned, and where they ran is reported in the stages:
+//   cvdlbench -a "mobilenetssd ! opticalflowtrack ! googlenetv2" -c "node0;googlenetv2=node1"
+//
+// A track or post process algo can be benchmarked without inference, by recording the output
+// of its upstream algo, and replaying it with the same input frames:
+//   cvdlbench -a "mobilenetssd" -r 0:ssd.rec
+//   cvdlbench -a "opticalflowtrack" -p ssd.rec -s 1,4
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <getopt.h>
+#include <sys/resource.h>
+#include <glib.h>
+#include <gst/gst.h>
+#include <json-c/json.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <algopipeline.h>
+
+using namespace std;
+
+#define DEFAULT_WIDTH 1920
+#define DEFAULT_HEIGHT 1080
+#define DEFAULT_FRAMES 300
+#define DEFAULT_DEPTH 8
+#define SYNTHETIC_FRAMES 30
+// wait for the frames in algo pipeline to be done
+#define DRAIN_TIMEOUT_MS 30000
+
+typedef struct _BenchConfig{
+    vector<string> algos;
+    vector<int> streams;
+    vector<int> objects;
+    int frames;
+    int width;
+    int height;
+    // max frames in one algo pipeline
+    int depth;
+    const char *device;
+    // CPUs of algo threads, see algo_pipeline_set_placement()
+    const char *placement;
+    const char *input;
+    const char *output;
+    // record the output of algo recordIndex of stream 0
+    int recordIndex;
+    const char *recordFile;
+    const char *replayFile;
+}BenchConfig;
+
+class BenchStream{
+public:
+    BenchStream() : handle(NULL), element(NULL), replay(NULL), inFrames(0), outFrames(0), eos(false) {}
+    AlgoPipelineHandle handle;
+    GstElement *element;
+    AlgoReplayHandle replay;
+    std::mutex mutex;
+    // when a frame is put into algo pipeline, index by pts
+    vector<gint64> putTime;
+    vector<gint64> latency;
+    int inFrames;
+    int outFrames;
+    std::atomic<bool> eos;
+    std::thread feeder;
+    std::thread consumer;
+};
+
+static vector<vector<guint8>> gFrames;
+
+static void print_usage (const char* program_name, gint exit_code)
+{
+    g_print ("Usage: %s...\n", program_name);
+    g_print (
+        " -a --algo algo pipeline description, it can be set multiple times.\n"
+        " -s --streams stream numbers, such as 1,2,4. Default: 1.\n"
+        " -o --objects object numbers per frame, 0 is the whole frame, such as 0,8. Default: 0.\n"
+        " -n --frames frames per stream. Default: %d.\n"
+        " -W --width frame width. Default: %d.\n"
+        " -H --height frame height. Default: %d.\n"
+        " -q --depth max frames in one algo pipeline. Default: %d.\n"
+        " -d --device HDDL, CPU or GPU. Default: CPU.\n"
+        " -c --cpus placement of algo threads, such as \"0-3;googlenetv2=node1\".\n"
+        " -i --input NV12 raw file, synthetic frames are used if not set.\n"
+        " -j --json output json file. Default: stdout.\n"
+        " -r --record <algo index>:<file>, record the output of an algo in stream 0.\n"
+        " -p --replay record file, which is put into the first algo.\n"
+        " -h --help Display this usage information.\n",
+        DEFAULT_FRAMES, DEFAULT_WIDTH, DEFAULT_HEIGHT, DEFAULT_DEPTH);
+    exit (exit_code);
+}
+
+static vector<int> parse_int_list(const char *str)
+{
+    vector<int> values;
+    gchar **items = g_strsplit(str, ",", -1);
+    for(int i=0; items[i]; i++) {
+        if(strlen(items[i])>0)
+            values.push_back(atoi(items[i]));
+    }
+    g_strfreev(items);
+    return values;
+}
+
+static gboolean load_frames(BenchConfig *config)
+{
+    size_t size = config->width * config->height * 3 / 2;
+
+    if(config->input) {
+        FILE *fp = fopen(config->input, "rb");
+        if(!fp) {
+            g_print("Failed to open %s\n", config->input);
+            return FALSE;
+        }
+        vector<guint8> frame(size);
+        while(fread(frame.data(), 1, size, fp) == size)
+            gFrames.push_back(frame);
+        fclose(fp);
+        if(gFrames.empty()) {
+            g_print("No %dx%d NV12 frame in %s\n", config->width, config->height, config->input);
+            return FALSE;
+        }
+        return TRUE;
+    }
+
+    // moving gradient, so that track algo sees motion
+    for(int k=0; k<SYNTHETIC_FRAMES; k++) {
+        vector<guint8> frame(size, 128);
+        for(int y=0; y<config->height; y++)
+            for(int x=0; x<config->width; x++)
+                frame[y * config->width + x] = (guint8)((x + y + 8 * k) & 0xff);
+        gFrames.push_back(frame);
+    }
+    return TRUE;
+}
+
+// objects are laid out in a grid
+static vector<VideoRect> make_rois(int num, int width, int height)
+{
+    vector<VideoRect> rois;
+    if(num<=0)
+        return rois;
+    int cols = 1;
+    while(cols * cols < num)
+        cols++;
+    int rows = (num + cols - 1) / cols;
+    int w = width / cols, h = height / rows;
+    for(int i=0; i<num; i++) {
+        VideoRect rect = {(uint32_t)((i % cols) * w), (uint32_t)((i / cols) * h),
+                          (uint32_t)w, (uint32_t)h};
+        rois.push_back(rect);
+    }
+    return rois;
+}
+
+static gint64 percentile(vector<gint64> &samples, double p)
+{
+    if(samples.empty())
+        return 0;
+    size_t index = (size_t)(p / 100.0 * (samples.size() - 1) + 0.5);
+    return samples[index];
+}
+
+static json_object *latency_to_json(vector<gint64> &samples)
+{
+    json_object *obj = json_object_new_object();
+    std::sort(samples.begin(), samples.end());
+    json_object_object_add(obj, "count", json_object_new_int((int)samples.size()));
+    json_object_object_add(obj, "p50", json_object_new_int64(percentile(samples, 50)));
+    json_object_object_add(obj, "p90", json_object_new_int64(percentile(samples, 90)));
+    json_object_object_add(obj, "p99", json_object_new_int64(percentile(samples, 99)));
+    json_object_object_add(obj, "max", json_object_new_int64(samples.empty() ? 0 : samples.back()));
+    return obj;
+}
+
+static void feeder_func(BenchStream *stream, BenchConfig *config, int objects)
+{
+    vector<VideoRect> rois = make_rois(objects, config->width, config->height);
+
+    for(int i=0; i<config->frames; i++) {
+        while(algo_pipeline_get_all_queue_size(stream->handle) >= config->depth)
+            g_usleep(1000);
+
+        vector<guint8> &data = gFrames[i % gFrames.size()];
+        GstBuffer *buf = gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY, data.data(),
+                                                     data.size(), 0, data.size(), NULL, NULL);
+        GST_BUFFER_PTS(buf) = i;
+        stream->mutex.lock();
+        stream->putTime[i] = g_get_monotonic_time();
+        stream->mutex.unlock();
+        if(stream->replay) {
+            // end of the record
+            if(!algo_pipeline_put_replay_buffer(stream->handle, stream->replay, buf))
+                break;
+        } else {
+            algo_pipeline_put_buffer_rois(stream->handle, buf, config->width, config->height,
+                                          rois.empty() ? NULL : rois.data(), rois.size());
+        }
+        stream->inFrames++;
+    }
+}
+
+static void consumer_func(BenchStream *stream)
+{
+    GstBuffer *buf = NULL;
+
+    while(true) {
+        algo_pipeline_get_buffer(stream->handle, &buf);
+        if(!buf) {
+            if(stream->eos)
+                break;
+            continue;
+        }
+        guint64 index = GST_BUFFER_PTS(buf);
+        stream->mutex.lock();
+        if(index < stream->putTime.size())
+            stream->latency.push_back(g_get_monotonic_time() - stream->putTime[index]);
+        stream->outFrames++;
+        stream->mutex.unlock();
+        gst_buffer_unref(buf);
+    }
+}
+
+static gboolean stream_create(BenchStream *stream, BenchConfig *config, const string &algo,
+                              GstCaps *caps, int id)
+{
+    gchar *name = g_strdup_printf("stream%d", id);
+    stream->element = gst_bin_new(name);
+    g_free(name);
+
+    // description will be stripped in place
+    gchar *desc = g_strdup(algo.c_str());
+    int num = 0;
+    AlgoPipelineConfig *algoConfig = algo_pipeline_config_create(desc, &num, stream->element);
+    g_free(desc);
+    if(!algoConfig)
+        return FALSE;
+    stream->handle = algo_pipeline_create(algoConfig, num, stream->element);
+    algo_pipeline_config_destroy(algoConfig);
+    if(!stream->handle)
+        return FALSE;
+
+    if(algo_pipeline_set_device(stream->handle, config->device))
+        return FALSE;
+    algo_pipeline_set_warmup(stream->handle, TRUE);
+    if(algo_pipeline_set_placement(stream->handle, config->placement))
+        return FALSE;
+    algo_pipeline_set_latency_stat(stream->handle, TRUE);
+    algo_pipeline_start(stream->handle);
+    if(algo_pipeline_set_caps_all(stream->handle, caps))
+        return FALSE;
+
+    if(config->recordFile && id==0 &&
+       algo_pipeline_set_record(stream->handle, config->recordIndex, config->recordFile))
+        return FALSE;
+    if(config->replayFile) {
+        stream->replay = algo_replay_open(config->replayFile);
+        if(!stream->replay)
+            return FALSE;
+    }
+
+    stream->putTime.assign(config->frames, 0);
+    return TRUE;
+}
+
+static void stream_destroy(BenchStream *stream)
+{
+    if(stream->handle) {
+        algo_pipeline_stop(stream->handle);
+        algo_pipeline_destroy(stream->handle);
+    }
+    algo_replay_close(stream->replay);
+    if(stream->element)
+        gst_object_unref(stream->element);
+}
+
+static gint64 cpu_time_us()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return (usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000000LL +
+           usage.ru_utime.tv_usec + usage.ru_stime.tv_usec;
+}
+
+// run one case, return NULL if the algo pipeline can not be created
+static json_object *bench_run(BenchConfig *config, const string &algo, int streamNum, int objects)
+{
+    GstCaps *caps = gst_caps_new_simple("video/x-raw", "format", G_TYPE_STRING, "NV12",
+                                        "width", G_TYPE_INT, config->width,
+                                        "height", G_TYPE_INT, config->height,
+                                        "framerate", GST_TYPE_FRACTION, 30, 1, NULL);
+    vector<BenchStream *> streams;
+    json_object *result = NULL;
+    gboolean ok = TRUE;
+    int i;
+
+    g_print("cvdlbench: algo=\"%s\" streams=%d objects=%d\n", algo.c_str(), streamNum, objects);
+    for(i=0; i<streamNum && ok; i++) {
+        streams.push_back(new BenchStream);
+        ok = stream_create(streams.back(), config, algo, caps, i);
+    }
+    gst_caps_unref(caps);
+
+    if(ok) {
+        gint64 cpuStart = cpu_time_us();
+        gint64 start = g_get_monotonic_time();
+        for(auto stream : streams) {
+            stream->consumer = std::thread(consumer_func, stream);
+            stream->feeder = std::thread(feeder_func, stream, config, objects);
+        }
+        for(auto stream : streams)
+            stream->feeder.join();
+
+        // all frames are done, or some frames are stuck
+        gint64 deadline = g_get_monotonic_time() + DRAIN_TIMEOUT_MS * 1000;
+        for(auto stream : streams) {
+            while(algo_pipeline_get_all_queue_size(stream->handle) > 0 &&
+                  g_get_monotonic_time() < deadline)
+                g_usleep(1000);
+        }
+        gint64 elapsed = g_get_monotonic_time() - start + 1;
+        gint64 cpu = cpu_time_us() - cpuStart;
+
+        for(auto stream : streams) {
+            stream->eos = true;
+            algo_pipeline_flush_buffer(stream->handle);
+            stream->consumer.join();
+        }
+
+        // merge the latency of all streams
+        vector<gint64> latency;
+        int inFrames = 0, outFrames = 0;
+        for(auto stream : streams) {
+            latency.insert(latency.end(), stream->latency.begin(), stream->latency.end());
+            inFrames += stream->inFrames;
+            outFrames += stream->outFrames;
+        }
+        json_object *stages = json_object_new_array();
+        int algoNum = algo_pipeline_get_algo_num(streams[0]->handle);
+        for(int index=0; index<algoNum; index++) {
+            GArray *samples = g_array_new(FALSE, FALSE, sizeof(gint64));
+            const char *name = NULL;
+            for(auto stream : streams)
+                name = algo_pipeline_get_latency(stream->handle, index, samples);
+            vector<gint64> stageLatency((gint64 *)samples->data,
+                                        (gint64 *)samples->data + samples->len);
+            g_array_free(samples, TRUE);
+
+            json_object *stage = json_object_new_object();
+            json_object_object_add(stage, "name", json_object_new_string(name ? name : ""));
+            json_object_object_add(stage, "latency_us", latency_to_json(stageLatency));
+            // the threads of all streams have the same placement, report stream 0
+            AlgoPlacementReport placement;
+            if(algo_pipeline_get_placement(streams[0]->handle, index, &placement)) {
+                json_object_object_add(stage, "cpus", json_object_new_string(placement.cpus));
+                json_object_object_add(stage, "numa_node", json_object_new_int(placement.node));
+                json_object_object_add(stage, "last_cpu", json_object_new_int(placement.cpu));
+                json_object_object_add(stage, "workers", json_object_new_int(placement.workers));
+            }
+            json_object_array_add(stages, stage);
+        }
+
+        result = json_object_new_object();
+        json_object_object_add(result, "algo", json_object_new_string(algo.c_str()));
+        json_object_object_add(result, "streams", json_object_new_int(streamNum));
+        json_object_object_add(result, "objects", json_object_new_int(objects));
+        json_object_object_add(result, "frames", json_object_new_int(inFrames));
+        json_object_object_add(result, "output_frames", json_object_new_int(outFrames));
+        json_object_object_add(result, "elapsed_ms", json_object_new_int64(elapsed / 1000));
+        json_object_object_add(result, "fps", json_object_new_double(inFrames * 1000000.0 / elapsed));
+        json_object_object_add(result, "fps_per_stream",
+            json_object_new_double(inFrames * 1000000.0 / streamNum / elapsed));
+        // 100% is one core
+        json_object_object_add(result, "cpu_usage", json_object_new_double(100.0 * cpu / elapsed));
+        json_object_object_add(result, "latency_us", latency_to_json(latency));
+        json_object_object_add(result, "stages", stages);
+        g_print("cvdlbench: fps=%.2f cpu=%.1f%%\n", inFrames * 1000000.0 / elapsed, 100.0 * cpu / elapsed);
+    } else {
+        g_print("cvdlbench: failed to create algo pipeline: %s\n", algo.c_str());
+    }
+
+    for(auto stream : streams) {
+        stream_destroy(stream);
+        delete stream;
+    }
+    return result;
+}
+
+int main(int argc, char **argv)
+{
+     const char* const brief = "ha:s:o:n:W:H:q:d:c:i:j:r:p:";
+     const struct option details[] = {
+                { "algo", 1, NULL, 'a'},
+                { "streams", 1, NULL, 's'},
+                { "objects", 1, NULL, 'o'},
+                { "frames", 1, NULL, 'n'},
+                { "width", 1, NULL, 'W'},
+                { "height", 1, NULL, 'H'},
+                { "depth", 1, NULL, 'q'},
+                { "device", 1, NULL, 'd'},
+                { "cpus", 1, NULL, 'c'},
+                { "input", 1, NULL, 'i'},
+                { "json", 1, NULL, 'j'},
+                { "record", 1, NULL, 'r'},
+                { "replay", 1, NULL, 'p'},
+                { "help", 0, NULL, 'h'},
+                { NULL, 0, NULL, 0 }
+       };
+    BenchConfig config;
+    int opt = 0;
+
+    config.frames = DEFAULT_FRAMES;
+    config.width = DEFAULT_WIDTH;
+    config.height = DEFAULT_HEIGHT;
+    config.depth = DEFAULT_DEPTH;
+    config.device = "CPU";
+    config.placement = NULL;
+    config.input = NULL;
+    config.output = NULL;
+    config.recordIndex = 0;
+    config.recordFile = NULL;
+    config.replayFile = NULL;
+
+    gst_init(&argc, &argv);
+
+    while (opt != -1) {
+        opt = getopt_long (argc, argv, brief, details, NULL);
+        switch (opt) {
+            case 'a':
+                config.algos.push_back(string(optarg));
+                break;
+            case 's':
+                config.streams = parse_int_list(optarg);
+                break;
+            case 'o':
+                config.objects = parse_int_list(optarg);
+                break;
+            case 'n':
+                config.frames = atoi(optarg);
+                break;
+            case 'W':
+                config.width = atoi(optarg) & ~1;
+                break;
+            case 'H':
+                config.height = atoi(optarg) & ~1;
+                break;
+            case 'q':
+                config.depth = atoi(optarg);
+                break;
+            case 'd':
+                config.device = optarg;
+                break;
+            case 'c':
+                config.placement = optarg;
+                break;
+            case 'i':
+                config.input = optarg;
+                break;
+            case 'j':
+                config.output = optarg;
+                break;
+            case 'r':
+                // <algo index>:<file>
+                config.recordIndex = atoi(optarg);
+                config.recordFile = strchr(optarg, ':');
+                if(!config.recordFile)
+                    print_usage (argv[0], 1);
+                config.recordFile++;
+                break;
+            case 'p':
+                config.replayFile = optarg;
+                break;
+            case 'h': /* help */
+                print_usage (argv[0], 0);
+                break;
+            case '?': /* an invalid option. */
+                print_usage (argv[0], 1);
+                break;
+            case -1: /* Done with options. */
+                break;
+             default: /* unexpected. */
+                print_usage (argv[0], 1);
+                abort ();
+         }
+     }
+
+    if(config.algos.empty() || config.frames<=0 || config.width<=0 || config.height<=0)
+        print_usage (argv[0], 1);
+    if(config.streams.empty())
+        config.streams.push_back(1);
+    if(config.objects.empty())
+        config.objects.push_back(0);
+    if(config.depth<=0)
+        config.depth = 1;
+    if(!load_frames(&config))
+        return 1;
+
+    json_object *report = json_object_new_object();
+    json_object *results = json_object_new_array();
+    json_object_object_add(report, "device", json_object_new_string(config.device));
+    if(config.placement)
+        json_object_object_add(report, "placement", json_object_new_string(config.placement));
+    json_object_object_add(report, "width", json_object_new_int(config.width));
+    json_object_object_add(report, "height", json_object_new_int(config.height));
+    json_object_object_add(report, "frames_per_stream", json_object_new_int(config.frames));
+    json_object_object_add(report, "cpu_cores", json_object_new_int(g_get_num_processors()));
+    if(config.replayFile)
+        json_object_object_add(report, "replay", json_object_new_string(config.replayFile));
+
+    int failed = 0;
+    for(auto &algo : config.algos)
+        for(auto streamNum : config.streams)
+            for(auto objects : config.objects) {
+                json_object *result = bench_run(&config, algo, MAX(streamNum, 1), objects);
+                if(result)
+                    json_object_array_add(results, result);
+                else
+                    failed++;
+            }
+    json_object_object_add(report, "results", results);
+
+    const char *str = json_object_to_json_string_ext(report, JSON_C_TO_STRING_PRETTY);
+    if(config.output) {
+        FILE *fp = fopen(config.output, "w");
+        if(fp) {
+            fprintf(fp, "%s\n", str);
+            fclose(fp);
+        } else {
+            g_print("Failed to write %s\n", config.output);
+            failed++;
+        }
+    } else {
+        printf("%s\n", str);
+    }
+    json_object_put(report);
+    return failed ? 1 : 0;
+}
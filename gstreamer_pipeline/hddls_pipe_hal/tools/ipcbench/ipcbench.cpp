@@ -0,0 +1,766 @@
+/*Copyright (C) 2018 Intel Corporation
+  *
+  *SPDX-License-Identifier: MIT
+  *
+  *MIT License
+  *
+  *Copyright (c) 2018 Intel Corporation
+  *
+  *Permission is hereby granted, free of charge, to any person obtaining a copy of
+  *this software and associated documentation files (the "Software"),
+  *to deal in the Software without restriction, including without limitation the rights to
+  *use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of the Software,
+  *and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+  *
+  *The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+  *
+  *THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED,
+  *INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE
+  *AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM,
+  *DAMAGES OR OTHER LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  *OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+  */
+
+// ipcbench - stand-in of the hddls server for the ipc output path
+//
+// It listens on a unix socket and speaks the AppProtocol framing like hddl_server.js, so that
+// hddlspipes or ipcsinks can be run without the Node.js controller. Every connection is a pipe,
+// its meta data and jpeg payloads are counted and validated, and throughput and latency are
+// reported per pipe as json.
+//
+// The server can also send commands to the pipes, and read slowly to put backpressure on them:
+//   ipcbench -u /tmp/hddls.sock -c create_hddlspipe.config -e 10:set_hddlspipe.config -x 20
+//   ipcbench -u /tmp/hddls.sock -n 4 -l 1000000
+//
+// Without any pipeline, the ipcclient path can be loaded by synthetic pipes in the same process.
+// Their pts is the monotonic clock, so the real end to end latency is reported:
+//   ipcbench -g 8 -f 30 -k 900 -o 16 -s 65536
+
+#include <string.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <errno.h>
+#include <getopt.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <glib.h>
+#include <gst/gst.h>
+#include <json-c/json.h>
+#include <algorithm>
+#include <atomic>
+#include <list>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <AppProtocol.h>
+#include <ipcclient.h>
+#include <ocl/metadata.h>
+
+using namespace std;
+
+#define DEFAULT_URI "/tmp/ipcbench.sock"
+#define DEFAULT_FPS 30
+#define DEFAULT_FRAMES 300
+#define DEFAULT_OBJECTS 8
+#define READ_CHUNK (64 * 1024)
+// period of read budget refill and command schedule
+#define TICK_MS 10
+#define MAX_EVENTS 64
+
+typedef struct _BenchConfig{
+    const char *uri;
+    // exit after so many pipes have disconnected, 0 to run until -t or Ctrl+C
+    int pipes;
+    int duration;
+    // commands sent to each pipe
+    const char *createFile;
+    int propertyDelay;
+    const char *propertyFile;
+    int destroyDelay;
+    // read bytes per second of each pipe, 0 is unlimited
+    gint64 readRate;
+    int rcvBuf;
+    // synthetic pipes
+    int generators;
+    int fps;
+    int frames;
+    int objects;
+    int jpegSize;
+    const char *output;
+    gboolean verbose;
+}BenchConfig;
+
+class BenchConn{
+public:
+    BenchConn(int sock, gint64 now) : fd(sock), pipeId(-1), connectTime(now), firstTime(0),
+        lastTime(0), bytes(0), budget(0), throttled(false), propertySent(false),
+        destroySent(false), invalidJson(0), invalidJpeg(0), frameGaps(0), lastFrame(-1),
+        objects(0), jpegBytes(0), firstPts(-1), firstArrival(0)
+    {
+        memset(msgNum, 0, sizeof(msgNum));
+    }
+    int fd;
+    int pipeId;
+    string recvBuf;
+    gint64 connectTime;
+    gint64 firstTime;
+    gint64 lastTime;
+    gint64 bytes;
+    // read budget in bytes when the read rate is limited
+    gint64 budget;
+    bool throttled;
+    bool propertySent;
+    bool destroySent;
+    gint64 msgNum[eErrorInfo + 2];
+    gint64 invalidJson;
+    gint64 invalidJpeg;
+    gint64 frameGaps;
+    gint64 lastFrame;
+    gint64 objects;
+    gint64 jpegBytes;
+    // pts of the first meta data and its arrival time
+    gint64 firstPts;
+    gint64 firstArrival;
+    vector<gint64> interval;
+    vector<gint64> delay;
+    vector<gint64> latency;
+};
+
+static std::atomic<bool> gQuit(false);
+
+static void print_usage (const char* program_name, gint exit_code)
+{
+    g_print ("Usage: %s...\n", program_name);
+    g_print (
+        " -u --uri unix socket path to listen on. Default: %s.\n"
+        " -n --pipes exit after so many pipes have disconnected. Default: 0, run until -t or Ctrl+C.\n"
+        " -t --time exit after so many seconds. Default: 0.\n"
+        " -c --create create command file, sent to a pipe when it sends its id.\n"
+        " -e --property <seconds>:<file>, set property command sent to each pipe after connected.\n"
+        " -x --destroy seconds, destroy command sent to each pipe after connected.\n"
+        " -l --limit read bytes per second of each pipe, to apply backpressure. Default: 0, unlimited.\n"
+        " -b --rcvbuf socket receive buffer size of each pipe.\n"
+        " -g --generate synthetic pipes in this process. Default: 0.\n"
+        " -f --fps frame rate of synthetic pipes. Default: %d.\n"
+        " -k --frames frames of synthetic pipes. Default: %d.\n"
+        " -o --objects objects per frame of synthetic pipes. Default: %d.\n"
+        " -s --jpeg jpeg size of synthetic pipes, 0 for meta data only. Default: 0.\n"
+        " -j --json output json file. Default: stdout.\n"
+        " -v --verbose print every message.\n"
+        " -h --help Display this usage information.\n",
+        DEFAULT_URI, DEFAULT_FPS, DEFAULT_FRAMES, DEFAULT_OBJECTS);
+    exit (exit_code);
+}
+
+static void handle_signal(int sig)
+{
+    gQuit = true;
+}
+
+static gint64 percentile(vector<gint64> &samples, double p)
+{
+    if(samples.empty())
+        return 0;
+    size_t index = (size_t)(p / 100.0 * (samples.size() - 1) + 0.5);
+    return samples[index];
+}
+
+static json_object *latency_to_json(vector<gint64> &samples)
+{
+    json_object *obj = json_object_new_object();
+    std::sort(samples.begin(), samples.end());
+    json_object_object_add(obj, "count", json_object_new_int((int)samples.size()));
+    json_object_object_add(obj, "p50", json_object_new_int64(percentile(samples, 50)));
+    json_object_object_add(obj, "p90", json_object_new_int64(percentile(samples, 90)));
+    json_object_object_add(obj, "p99", json_object_new_int64(percentile(samples, 99)));
+    json_object_object_add(obj, "max", json_object_new_int64(samples.empty() ? 0 : samples.back()));
+    return obj;
+}
+
+static gboolean read_file(const char *path, string &content)
+{
+    gchar *data = NULL;
+    gsize len = 0;
+    if(!g_file_get_contents(path, &data, &len, NULL)) {
+        g_print("Failed to read %s\n", path);
+        return FALSE;
+    }
+    content = string(data, len);
+    g_free(data);
+    return TRUE;
+}
+
+static int listen_socket(const char *uri)
+{
+    struct sockaddr_un addr;
+    int fd;
+
+    if(strlen(uri) >= sizeof(addr.sun_path)) {
+        g_print("Socket path is too long: %s\n", uri);
+        return -1;
+    }
+    fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if(fd < 0) {
+        g_print("Failed to open socket: %s\n", strerror(errno));
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    g_strlcpy(addr.sun_path, uri, sizeof(addr.sun_path));
+    unlink(uri);
+    if(bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen(fd, SOMAXCONN) < 0) {
+        g_print("Failed to listen on %s: %s\n", uri, strerror(errno));
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void send_message(BenchConn *conn, uint32_t type, const string &payload)
+{
+    ipcProtocol tMsg;
+    string sBuf;
+    tMsg.iType = type;
+    tMsg.sPayload = payload;
+    AppProtocol::format(tMsg, sBuf);
+
+    // commands are small, the socket buffer is not expected to be full
+    size_t pos = 0;
+    while(pos < sBuf.size()) {
+        ssize_t n = send(conn->fd, sBuf.c_str() + pos, sBuf.size() - pos, MSG_NOSIGNAL);
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n <= 0) {
+            g_print("pipe %d: failed to send command: %s\n", conn->pipeId, strerror(errno));
+            return;
+        }
+        pos += n;
+    }
+    g_print("pipe %d: sent command type %d, %ld bytes\n", conn->pipeId, type, payload.size());
+}
+
+static void send_destroy(BenchConn *conn)
+{
+    json_object *root = json_object_new_object();
+    json_object *cmd = json_object_new_object();
+    json_object_object_add(cmd, "pipe_id", json_object_new_int(conn->pipeId));
+    json_object_object_add(root, "client_id", json_object_new_int(conn->pipeId));
+    json_object_object_add(root, "command_type", json_object_new_int(1));
+    json_object_object_add(root, "command_destroy", cmd);
+    send_message(conn, ePipeDestroy, string(json_object_to_json_string(root)));
+    json_object_put(root);
+}
+
+static gboolean json_has(json_object *obj, const char *key, json_type type, json_object **value)
+{
+    json_object *tmp = NULL;
+    if(!json_object_object_get_ex(obj, key, &tmp))
+        return FALSE;
+    // json-c keeps small numbers as int, whatever they are written as
+    if(type == json_type_double && json_object_is_type(tmp, json_type_int))
+        type = json_type_int;
+    if(!json_object_is_type(tmp, type))
+        return FALSE;
+    if(value)
+        *value = tmp;
+    return TRUE;
+}
+
+// The same format as covert_frame_result_to_json_string() in ipcclient
+static gboolean check_meta_text(BenchConn *conn, BenchConfig *config, const string &payload, gint64 now)
+{
+    json_object *root = json_tokener_parse(payload.c_str());
+    json_object *frame = NULL, *pts = NULL, *count = NULL, *objects = NULL, *rect = NULL;
+    gboolean valid = FALSE;
+
+    if(!root)
+        return FALSE;
+    if(!json_has(root, "frame_index", json_type_int, &frame) ||
+       !json_has(root, "infer_index", json_type_int, NULL) ||
+       !json_has(root, "pts", json_type_int, &pts) ||
+       !json_has(root, "obj_count", json_type_int, &count) ||
+       !json_has(root, "objects", json_type_array, &objects) ||
+       json_object_get_int(count) != (int)json_object_array_length(objects))
+        goto done;
+
+    for(size_t i = 0; i < json_object_array_length(objects); i++) {
+        json_object *obj = json_object_array_get_idx(objects, i);
+        if(!json_object_is_type(obj, json_type_object) ||
+           !json_has(obj, "prob", json_type_double, NULL) ||
+           !json_has(obj, "label", json_type_string, NULL) ||
+           !json_has(obj, "rect", json_type_object, &rect) ||
+           !json_has(rect, "x", json_type_int, NULL) || !json_has(rect, "y", json_type_int, NULL) ||
+           !json_has(rect, "w", json_type_int, NULL) || !json_has(rect, "h", json_type_int, NULL))
+            goto done;
+    }
+    valid = TRUE;
+
+    {
+        gint64 frameIndex = json_object_get_int64(frame);
+        gint64 ptsUs = json_object_get_int64(pts) / 1000;
+        if(conn->lastFrame >= 0 && frameIndex != conn->lastFrame + 1)
+            conn->frameGaps++;
+        conn->lastFrame = frameIndex;
+        conn->objects += json_object_get_int(count);
+
+        // The pts of a pipeline is stream time, only the growth of the delay against the first
+        // frame is known. It shows how much the output falls behind, e.g. under backpressure.
+        if(conn->firstPts < 0) {
+            conn->firstPts = ptsUs;
+            conn->firstArrival = now;
+        } else {
+            conn->delay.push_back((now - conn->firstArrival) - (ptsUs - conn->firstPts));
+        }
+        // synthetic pipes put the monotonic clock into pts
+        if(config->generators > 0)
+            conn->latency.push_back(now - ptsUs);
+    }
+
+done:
+    json_object_put(root);
+    return valid;
+}
+
+// A jpeg starts with SOI and ends with EOI, padding bytes may follow EOI
+static gboolean check_jpeg(const string &payload)
+{
+    const guint8 *data = (const guint8 *)payload.data();
+    size_t size = payload.size();
+
+    if(size < 4 || data[0] != 0xFF || data[1] != 0xD8)
+        return FALSE;
+    while(size > 2 && data[size - 1] != 0xD9)
+        size--;
+    return data[size - 2] == 0xFF && data[size - 1] == 0xD9;
+}
+
+static void handle_message(BenchConn *conn, BenchConfig *config, ipcProtocol &msg,
+                           const string &createCmd, gint64 now)
+{
+    uint32_t type = msg.iType <= eErrorInfo ? msg.iType : eErrorInfo + 1;
+    conn->msgNum[type]++;
+    if(config->verbose)
+        g_print("pipe %d: type %d, %ld bytes\n", conn->pipeId, msg.iType, msg.sPayload.size());
+
+    switch(msg.iType) {
+        case ePipeID:
+            conn->pipeId = atoi(msg.sPayload.c_str());
+            g_print("pipe %d connected\n", conn->pipeId);
+            if(!createCmd.empty())
+                send_message(conn, ePipeCreate, createCmd);
+            break;
+        case eMetaText:
+            if(conn->msgNum[eMetaText] > 1)
+                conn->interval.push_back(now - conn->lastTime);
+            conn->lastTime = now;
+            if(!check_meta_text(conn, config, msg.sPayload, now)) {
+                conn->invalidJson++;
+                if(conn->invalidJson == 1)
+                    g_print("pipe %d: invalid meta data: %s\n", conn->pipeId, msg.sPayload.c_str());
+            }
+            break;
+        case eMetaJPG:
+            conn->jpegBytes += msg.sPayload.size();
+            if(!check_jpeg(msg.sPayload))
+                conn->invalidJpeg++;
+            break;
+        case eErrorInfo:
+            g_print("pipe %d: error info: %s\n", conn->pipeId, msg.sPayload.c_str());
+            break;
+        default:
+            g_print("pipe %d: unexpected message type %d\n", conn->pipeId, msg.iType);
+            break;
+    }
+}
+
+// Read what the budget allows, return FALSE when the pipe is disconnected
+static gboolean read_conn(BenchConn *conn, BenchConfig *config, const string &createCmd)
+{
+    char buf[READ_CHUNK];
+
+    while(!config->readRate || conn->budget > 0) {
+        size_t want = sizeof(buf);
+        if(config->readRate)
+            want = MIN(want, (size_t)conn->budget);
+        ssize_t n = recv(conn->fd, buf, want, 0);
+        if(n < 0 && errno == EINTR)
+            continue;
+        if(n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            return TRUE;
+        if(n <= 0)
+            return FALSE;
+
+        gint64 now = g_get_monotonic_time();
+        if(!conn->firstTime)
+            conn->firstTime = now;
+        conn->bytes += n;
+        if(config->readRate)
+            conn->budget -= n;
+        conn->recvBuf.append(buf, n);
+
+        list<ipcProtocol> lMsgs;
+        size_t pos = AppProtocol::parse(conn->recvBuf.c_str(), conn->recvBuf.size(), lMsgs);
+        if(pos > 0)
+            conn->recvBuf.erase(0, pos);
+        for(auto &msg : lMsgs)
+            handle_message(conn, config, msg, createCmd, now);
+    }
+    return TRUE;
+}
+
+static json_object *conn_to_json(BenchConn *conn, gint64 now)
+{
+    json_object *obj = json_object_new_object();
+    gint64 elapsed = MAX(conn->lastTime - conn->firstTime, 1);
+    gint64 minDelay = 0;
+
+    json_object_object_add(obj, "pipe_id", json_object_new_int(conn->pipeId));
+    json_object_object_add(obj, "connected_ms", json_object_new_int64((now - conn->connectTime) / 1000));
+    json_object_object_add(obj, "bytes", json_object_new_int64(conn->bytes));
+    json_object_object_add(obj, "meta", json_object_new_int64(conn->msgNum[eMetaText]));
+    json_object_object_add(obj, "jpeg", json_object_new_int64(conn->msgNum[eMetaJPG]));
+    json_object_object_add(obj, "jpeg_bytes", json_object_new_int64(conn->jpegBytes));
+    json_object_object_add(obj, "error_info", json_object_new_int64(conn->msgNum[eErrorInfo]));
+    json_object_object_add(obj, "unknown", json_object_new_int64(conn->msgNum[eErrorInfo + 1]));
+    json_object_object_add(obj, "objects", json_object_new_int64(conn->objects));
+    json_object_object_add(obj, "invalid_meta", json_object_new_int64(conn->invalidJson));
+    json_object_object_add(obj, "invalid_jpeg", json_object_new_int64(conn->invalidJpeg));
+    json_object_object_add(obj, "frame_gaps", json_object_new_int64(conn->frameGaps));
+    json_object_object_add(obj, "pending_bytes", json_object_new_int64(conn->recvBuf.size()));
+    json_object_object_add(obj, "meta_per_sec",
+        json_object_new_double(conn->msgNum[eMetaText] * 1000000.0 / elapsed));
+    json_object_object_add(obj, "mbytes_per_sec",
+        json_object_new_double(conn->bytes / (double)MAX(now - conn->firstTime, 1)));
+
+    json_object_object_add(obj, "interval_us", latency_to_json(conn->interval));
+    if(!conn->delay.empty())
+        minDelay = MIN(*std::min_element(conn->delay.begin(), conn->delay.end()), 0);
+    for(auto &d : conn->delay)
+        d -= minDelay;
+    json_object_object_add(obj, "delay_us", latency_to_json(conn->delay));
+    if(!conn->latency.empty())
+        json_object_object_add(obj, "latency_us", latency_to_json(conn->latency));
+    return obj;
+}
+
+// A synthetic pipe, it sends meta data and jpeg through ipcclient like ipcsink
+static void generator_func(BenchConfig *config, int id)
+{
+    IPCClientHandle ipc = ipcclient_setup(config->uri, id);
+    if(!ipc) {
+        g_print("generator %d: failed to connect to %s\n", id, config->uri);
+        return;
+    }
+
+    string jpeg(config->jpegSize, (char)0x5A);
+    if(config->jpegSize >= 4) {
+        jpeg[0] = (char)0xFF; jpeg[1] = (char)0xD8;
+        jpeg[config->jpegSize - 2] = (char)0xFF; jpeg[config->jpegSize - 1] = (char)0xD9;
+    }
+    int label = cvdl_label_intern("generator");
+    gint64 frameDuration = 1000000 / MAX(config->fps, 1);
+    gint64 start = g_get_monotonic_time();
+    int inferIndex = 0;
+
+    for(int i = 0; i < config->frames && !gQuit; i++) {
+        gint64 wait = start + i * frameDuration - g_get_monotonic_time();
+        if(wait > 0)
+            g_usleep(wait);
+
+        CvdlFrameResult *result = cvdl_frame_result_new(config->objects, 0, 0);
+        for(int j = 0; j < result->object_count; j++) {
+            CvdlObject *object = &result->objects[j];
+            object->probility = 0.5f + (j % 50) / 100.0f;
+            object->rect.x = (j * 64) % 1920;
+            object->rect.y = (j * 48) % 1080;
+            object->rect.width = 64;
+            object->rect.height = 48;
+            object->label_id = label;
+        }
+        ipcclient_send_frame_result(ipc, result, i, (guint64)g_get_monotonic_time() * 1000, inferIndex);
+        inferIndex += result->object_count;
+        cvdl_frame_result_unref(result);
+
+        if(config->jpegSize > 0)
+            ipcclient_send_data(ipc, jpeg.data(), jpeg.size(), eMetaJPG);
+    }
+
+    // let the looper send out the queued messages
+    g_usleep(200000);
+    ipcclient_destroy(ipc);
+}
+
+static void run_server(BenchConfig *config, int listenFd, json_object *pipes)
+{
+    map<int, BenchConn*> conns;
+    struct epoll_event ev, events[MAX_EVENTS];
+    string createCmd, propertyCmd;
+    gint64 start = g_get_monotonic_time();
+    gint64 lastTick = start;
+    int closed = 0;
+
+    if(config->createFile)
+        read_file(config->createFile, createCmd);
+    if(config->propertyFile)
+        read_file(config->propertyFile, propertyCmd);
+
+    int epfd = epoll_create1(0);
+    ev.events = EPOLLIN;
+    ev.data.fd = listenFd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, listenFd, &ev);
+
+    auto close_conn = [&](BenchConn *conn) {
+        gint64 now = g_get_monotonic_time();
+        g_print("pipe %d disconnected, %ld meta, %ld jpeg\n", conn->pipeId,
+            conn->msgNum[eMetaText], conn->msgNum[eMetaJPG]);
+        json_object_array_add(pipes, conn_to_json(conn, now));
+        epoll_ctl(epfd, EPOLL_CTL_DEL, conn->fd, NULL);
+        close(conn->fd);
+        conns.erase(conn->fd);
+        delete conn;
+        closed++;
+    };
+
+    while(!gQuit) {
+        int n = epoll_wait(epfd, events, MAX_EVENTS, TICK_MS);
+        if(n < 0 && errno != EINTR)
+            break;
+
+        for(int i = 0; i < n; i++) {
+            if(events[i].data.fd == listenFd) {
+                int fd;
+                while((fd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK)) >= 0) {
+                    if(config->rcvBuf > 0)
+                        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &config->rcvBuf, sizeof(config->rcvBuf));
+                    BenchConn *conn = new BenchConn(fd, g_get_monotonic_time());
+                    conn->budget = config->readRate / (1000 / TICK_MS);
+                    conns[fd] = conn;
+                    ev.events = EPOLLIN;
+                    ev.data.fd = fd;
+                    epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+                }
+                continue;
+            }
+            auto it = conns.find(events[i].data.fd);
+            if(it == conns.end())
+                continue;
+            BenchConn *conn = it->second;
+            if(!read_conn(conn, config, createCmd)) {
+                close_conn(conn);
+                continue;
+            }
+            // out of budget, stop polling it until the next refill, the pipe will be blocked
+            // when the socket buffer is full
+            if(config->readRate && conn->budget <= 0 && !conn->throttled) {
+                ev.events = 0;
+                ev.data.fd = conn->fd;
+                epoll_ctl(epfd, EPOLL_CTL_MOD, conn->fd, &ev);
+                conn->throttled = true;
+            }
+        }
+
+        gint64 now = g_get_monotonic_time();
+        if(now - lastTick >= TICK_MS * 1000) {
+            for(auto &item : conns) {
+                BenchConn *conn = item.second;
+                gint64 since = (now - conn->connectTime) / 1000000;
+                if(config->readRate) {
+                    conn->budget = MIN(conn->budget + config->readRate * (now - lastTick) / 1000000,
+                        config->readRate / (1000 / TICK_MS) + READ_CHUNK);
+                    if(conn->throttled && conn->budget > 0) {
+                        ev.events = EPOLLIN;
+                        ev.data.fd = conn->fd;
+                        epoll_ctl(epfd, EPOLL_CTL_MOD, conn->fd, &ev);
+                        conn->throttled = false;
+                    }
+                }
+                if(!propertyCmd.empty() && !conn->propertySent && since >= config->propertyDelay) {
+                    send_message(conn, ePipeProperty, propertyCmd);
+                    conn->propertySent = true;
+                }
+                if(config->destroyDelay > 0 && !conn->destroySent && since >= config->destroyDelay) {
+                    send_destroy(conn);
+                    conn->destroySent = true;
+                }
+            }
+            lastTick = now;
+        }
+
+        if(config->pipes > 0 && closed >= config->pipes)
+            break;
+        if(config->duration > 0 && now - start >= config->duration * (gint64)1000000)
+            break;
+    }
+
+    // the pipes still connected are reported too
+    while(!conns.empty())
+        close_conn(conns.begin()->second);
+    close(epfd);
+}
+
+int main(int argc, char **argv)
+{
+     const char* const brief = "hu:n:t:c:e:x:l:b:g:f:k:o:s:j:v";
+     const struct option details[] = {
+                { "uri", 1, NULL, 'u'},
+                { "pipes", 1, NULL, 'n'},
+                { "time", 1, NULL, 't'},
+                { "create", 1, NULL, 'c'},
+                { "property", 1, NULL, 'e'},
+                { "destroy", 1, NULL, 'x'},
+                { "limit", 1, NULL, 'l'},
+                { "rcvbuf", 1, NULL, 'b'},
+                { "generate", 1, NULL, 'g'},
+                { "fps", 1, NULL, 'f'},
+                { "frames", 1, NULL, 'k'},
+                { "objects", 1, NULL, 'o'},
+                { "jpeg", 1, NULL, 's'},
+                { "json", 1, NULL, 'j'},
+                { "verbose", 0, NULL, 'v'},
+                { "help", 0, NULL, 'h'},
+                { NULL, 0, NULL, 0 }
+       };
+    BenchConfig config;
+    int opt = 0;
+
+    memset(&config, 0, sizeof(config));
+    config.uri = DEFAULT_URI;
+    config.fps = DEFAULT_FPS;
+    config.frames = DEFAULT_FRAMES;
+    config.objects = DEFAULT_OBJECTS;
+
+    gst_init(&argc, &argv);
+
+    while (opt != -1) {
+        opt = getopt_long (argc, argv, brief, details, NULL);
+        switch (opt) {
+            case 'u':
+                config.uri = optarg;
+                break;
+            case 'n':
+                config.pipes = atoi(optarg);
+                break;
+            case 't':
+                config.duration = atoi(optarg);
+                break;
+            case 'c':
+                config.createFile = optarg;
+                break;
+            case 'e':
+                // <seconds>:<file>
+                config.propertyDelay = atoi(optarg);
+                config.propertyFile = strchr(optarg, ':');
+                if(!config.propertyFile)
+                    print_usage (argv[0], 1);
+                config.propertyFile++;
+                break;
+            case 'x':
+                config.destroyDelay = atoi(optarg);
+                break;
+            case 'l':
+                config.readRate = g_ascii_strtoll(optarg, NULL, 10);
+                break;
+            case 'b':
+                config.rcvBuf = atoi(optarg);
+                break;
+            case 'g':
+                config.generators = atoi(optarg);
+                break;
+            case 'f':
+                config.fps = atoi(optarg);
+                break;
+            case 'k':
+                config.frames = atoi(optarg);
+                break;
+            case 'o':
+                config.objects = atoi(optarg);
+                break;
+            case 's':
+                config.jpegSize = atoi(optarg);
+                break;
+            case 'j':
+                config.output = optarg;
+                break;
+            case 'v':
+                config.verbose = TRUE;
+                break;
+            case 'h': /* help */
+                print_usage (argv[0], 0);
+                break;
+            case '?': /* an invalid option. */
+                print_usage (argv[0], 1);
+                break;
+            case -1: /* Done with options. */
+                break;
+             default: /* unexpected. */
+                print_usage (argv[0], 1);
+                abort ();
+         }
+     }
+
+    if(config.readRate < 0 || config.generators < 0 || config.frames <= 0 || config.objects < 0 ||
+       config.jpegSize < 0)
+        print_usage (argv[0], 1);
+    // synthetic pipes end by themselves
+    if(config.generators > 0 && config.pipes <= 0)
+        config.pipes = config.generators;
+
+    signal(SIGINT, handle_signal);
+    signal(SIGTERM, handle_signal);
+
+    int listenFd = listen_socket(config.uri);
+    if(listenFd < 0)
+        return 1;
+    g_print("Listening on %s\n", config.uri);
+
+    vector<std::thread> generators;
+    for(int i = 0; i < config.generators; i++)
+        generators.push_back(std::thread(generator_func, &config, i));
+
+    json_object *report = json_object_new_object();
+    json_object *pipes = json_object_new_array();
+    gint64 start = g_get_monotonic_time();
+    run_server(&config, listenFd, pipes);
+    gint64 elapsed = g_get_monotonic_time() - start;
+
+    gQuit = true;
+    for(auto &t : generators)
+        t.join();
+    close(listenFd);
+    unlink(config.uri);
+
+    int failed = 0;
+    for(size_t i = 0; i < json_object_array_length(pipes); i++) {
+        json_object *pipe = json_object_array_get_idx(pipes, i), *value = NULL;
+        json_object_object_get_ex(pipe, "invalid_meta", &value);
+        failed += json_object_get_int(value) > 0;
+        json_object_object_get_ex(pipe, "invalid_jpeg", &value);
+        failed += json_object_get_int(value) > 0;
+    }
+    json_object_object_add(report, "uri", json_object_new_string(config.uri));
+    json_object_object_add(report, "elapsed_ms", json_object_new_int64(elapsed / 1000));
+    json_object_object_add(report, "read_limit", json_object_new_int64(config.readRate));
+    json_object_object_add(report, "generators", json_object_new_int(config.generators));
+    json_object_object_add(report, "pipes", pipes);
+
+    const char *str = json_object_to_json_string_ext(report, JSON_C_TO_STRING_PRETTY);
+    if(config.output) {
+        FILE *fp = fopen(config.output, "w");
+        if(fp) {
+            fprintf(fp, "%s\n", str);
+            fclose(fp);
+        } else {
+            g_print("Failed to write %s\n", config.output);
+            failed++;
+        }
+    } else {
+        printf("%s\n", str);
+    }
+    json_object_put(report);
+    return failed ? 1 : 0;
+}
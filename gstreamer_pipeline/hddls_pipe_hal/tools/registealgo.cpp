@@ -65,7 +65,10 @@ int main(int argc, char **argv)
                 register_init();
                  id = register_get_free_algo_id();
                  g_print("register: id=%d, name=%s\n",id, optarg);
-                register_add_algo(id, optarg);
+                if(register_add_algo(id, optarg)) {
+                    g_print("Failed to register algo %s\n", optarg);
+                    return -1;
+                }
                 register_write();
                 register_dump();
                 break;
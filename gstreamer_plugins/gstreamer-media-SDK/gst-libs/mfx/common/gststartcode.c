@@ -0,0 +1,172 @@
+/*
+ *  gststartcode.c - start code scanner for byte-stream bitstreams
+ *
+ *  Copyright (C) 2018 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include "gststartcode.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define USE_X86_SIMD 1
+#include <immintrin.h>
+#endif
+
+/* Scanners return the offset of the first 00 00 01 sequence in @data,
+ * or @size if there is none */
+typedef gsize (*GstStartCodeScanFunc) (const guint8 * data, gsize size);
+
+static gsize
+scan_c (const guint8 * data, gsize size)
+{
+  gsize i = 0;
+
+  while (i + 2 < size) {
+    if (data[i + 2] == 0x01 && !data[i + 1] && !data[i])
+      return i;
+    /* no sequence can start at i, i + 1 or i + 2 */
+    if (data[i + 2])
+      i += 3;
+    else
+      i++;
+  }
+  return size;
+}
+
+#ifdef USE_X86_SIMD
+/* Compare 16 (32) positions at once: data[i] == 0, data[i + 1] == 0 and
+ * data[i + 2] == 1. The tail is left to the narrower scanner. */
+__attribute__ ((target ("sse2")))
+static gsize
+scan_sse2 (const guint8 * data, gsize size)
+{
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i code = _mm_set1_epi8 (0x01);
+  __m128i match;
+  gsize i;
+  gint mask;
+
+  for (i = 0; i + 18 <= size; i += 16) {
+    match = _mm_and_si128 (
+        _mm_cmpeq_epi8 (_mm_loadu_si128 ((const __m128i *) (data + i)), zero),
+        _mm_cmpeq_epi8 (_mm_loadu_si128 ((const __m128i *) (data + i + 1)),
+            zero));
+    match = _mm_and_si128 (match,
+        _mm_cmpeq_epi8 (_mm_loadu_si128 ((const __m128i *) (data + i + 2)),
+            code));
+    mask = _mm_movemask_epi8 (match);
+    if (mask)
+      return i + __builtin_ctz (mask);
+  }
+  return i + scan_c (data + i, size - i);
+}
+
+__attribute__ ((target ("avx2")))
+static gsize
+scan_avx2 (const guint8 * data, gsize size)
+{
+  const __m256i zero = _mm256_setzero_si256 ();
+  const __m256i code = _mm256_set1_epi8 (0x01);
+  __m256i match;
+  gsize i;
+  guint32 mask;
+
+  for (i = 0; i + 34 <= size; i += 32) {
+    match = _mm256_and_si256 (
+        _mm256_cmpeq_epi8 (
+            _mm256_loadu_si256 ((const __m256i *) (data + i)), zero),
+        _mm256_cmpeq_epi8 (
+            _mm256_loadu_si256 ((const __m256i *) (data + i + 1)), zero));
+    match = _mm256_and_si256 (match,
+        _mm256_cmpeq_epi8 (
+            _mm256_loadu_si256 ((const __m256i *) (data + i + 2)), code));
+    mask = (guint32) _mm256_movemask_epi8 (match);
+    if (mask)
+      return i + __builtin_ctz (mask);
+  }
+  return i + scan_sse2 (data + i, size - i);
+}
+#endif
+
+static GstStartCodeScanFunc
+get_scan_func (void)
+{
+  static gsize scan_func = 0;
+
+  if (g_once_init_enter (&scan_func)) {
+    GstStartCodeScanFunc func = scan_c;
+
+#ifdef USE_X86_SIMD
+    __builtin_cpu_init ();
+    if (__builtin_cpu_supports ("avx2"))
+      func = scan_avx2;
+    else if (__builtin_cpu_supports ("sse2"))
+      func = scan_sse2;
+#endif
+    g_once_init_leave (&scan_func, (gsize) func);
+  }
+  return (GstStartCodeScanFunc) scan_func;
+}
+
+/**
+ * gst_start_code_find:
+ * @data: byte-stream data
+ * @size: size of @data in bytes
+ *
+ * Looks for the first 00 00 01 start code prefix in @data. A four bytes
+ * start code is found at its second byte.
+ *
+ * Return value: the offset of the start code prefix, or @size if none
+ */
+gsize
+gst_start_code_find (const guint8 * data, gsize size)
+{
+  return get_scan_func ()(data, size);
+}
+
+/**
+ * gst_start_code_convert_avc:
+ * @data: AVC access unit, NAL units with 4 bytes length prefixes
+ * @size: size of @data in bytes
+ *
+ * Rewrites the length prefixes of @data into 00 00 00 01 start codes in
+ * place, so that it can be decoded as byte-stream without copying. @data
+ * is left untouched if a length prefix or a NAL unit crosses its end.
+ *
+ * Return value: %TRUE if @data was converted
+ */
+gboolean
+gst_start_code_convert_avc (guint8 * data, gsize size)
+{
+  gsize offset = 0;
+  guint32 nal_size = 0;
+
+  while (size - offset >= 4) {
+    nal_size = GST_READ_UINT32_BE (data + offset);
+    if (nal_size > size - offset - 4)
+      return FALSE;
+    offset += nal_size + 4;
+  }
+  if (offset != size)
+    return FALSE;
+
+  for (offset = 0; offset < size; offset += nal_size + 4) {
+    nal_size = GST_READ_UINT32_BE (data + offset);
+    GST_WRITE_UINT32_BE (data + offset, 1);
+  }
+  return TRUE;
+}
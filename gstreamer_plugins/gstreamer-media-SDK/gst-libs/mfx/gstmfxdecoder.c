@@ -29,12 +29,21 @@
 #include "gstmfxsurface.h"
 #include "gstmfxtask.h"
 #include "gstmfxutils_h264.h"
+#include "common/gststartcode.h"
 
 #define DEBUG 1
 #include "gstmfxdebug.h"
 
 #define NAL_UNITTYPE_BITS 0X1F
 
+/* A decode operation in flight, its surface is output once syncp is done.
+ * The surface is held in the pool until then */
+typedef struct
+{
+  mfxSyncPoint syncp;
+  GstMfxSurface *surface;
+} GstMfxDecodeOp;
+
 struct _GstMfxDecoder
 {
   /*< private > */
@@ -51,6 +60,8 @@ struct _GstMfxDecoder
   GQueue decoded_frames;
   GQueue pending_frames;
   GQueue discarded_frames;
+  GQueue decode_ops;
+  guint async_depth;
 
   mfxSession session;
   mfxVideoParam params;
@@ -66,6 +77,8 @@ struct _GstMfxDecoder
   gboolean enable_csc;
   gboolean enable_deinterlace;
   gboolean skip_corrupted_frames;
+  GstMfxDecoderSkipMode skip_mode;
+  gboolean skip_to_key;
   gboolean can_double_deinterlace;
   gboolean is_avc;
   gboolean sync_out_surf;
@@ -119,6 +132,17 @@ gst_mfx_decoder_skip_corrupted_frames (GstMfxDecoder * decoder)
   decoder->skip_corrupted_frames = TRUE;
 }
 
+void
+gst_mfx_decoder_set_skip_mode (GstMfxDecoder * decoder,
+    GstMfxDecoderSkipMode mode)
+{
+  g_return_if_fail (decoder != NULL);
+
+  if (decoder->skip_mode != mode)
+    GST_DEBUG ("skip mode %d -> %d", decoder->skip_mode, mode);
+  decoder->skip_mode = mode;
+}
+
 void
 gst_mfx_decoder_should_use_video_memory (GstMfxDecoder * decoder,
     gboolean memtype_is_video)
@@ -183,6 +207,17 @@ close_decoder (GstMfxDecoder * decoder)
   MFXVideoDECODE_Close (decoder->session);
 }
 
+static void
+gst_mfx_decoder_clear_ops (GstMfxDecoder * decoder)
+{
+  GstMfxDecodeOp *op;
+
+  while ((op = g_queue_pop_head (&decoder->decode_ops))) {
+    gst_mfx_surface_pool_unhold_surface (op->surface);
+    g_slice_free (GstMfxDecodeOp, op);
+  }
+}
+
 static void
 gst_mfx_decoder_finalize (GstMfxDecoder * decoder)
 {
@@ -200,6 +235,7 @@ gst_mfx_decoder_finalize (GstMfxDecoder * decoder)
   g_queue_clear (&decoder->pending_frames);
   g_queue_clear (&decoder->decoded_frames);
   g_queue_clear (&decoder->discarded_frames);
+  gst_mfx_decoder_clear_ops (decoder);
 
   if ((decoder->params.mfx.CodecId == MFX_CODEC_VP8)
 #ifdef USE_VP9_DECODER
@@ -416,23 +452,98 @@ gst_mfx_decoder_is_avc_intra (GstMfxDecoder * decoder, guint8 * cdata,
   return have_intra;
 }
 
+/* Check if all slices of an H.264 access unit have nal_ref_idc = 0. A corrupt
+ * NAL length is not trusted, the frame is decoded then */
+static gboolean
+gst_mfx_decoder_is_avc_non_ref (GstMfxDecoder * decoder, guint8 * cdata,
+    gint size)
+{
+  gboolean have_slice = FALSE;
+  gsize offset = 0, packet_size = 0;
+  guint8 header, nal_unit_type;
+
+  if (!cdata || size <= 4)
+    return FALSE;
+
+  while (offset < (gsize) size - 4) {
+    if (decoder->is_avc) {
+      packet_size = GST_READ_UINT32_BE (&cdata[offset]);
+      if (packet_size == 0 || packet_size > (gsize) size - offset - 4)
+        return FALSE;
+      offset += 4;
+    } else {
+      offset += gst_start_code_find (cdata + offset, size - offset);
+      if (offset >= (gsize) size - 4)
+        break;
+      offset += 3;
+      packet_size = 1;
+    }
+
+    header = cdata[offset];
+    nal_unit_type = header & NAL_UNITTYPE_BITS;
+    if (nal_unit_type >= GST_H264_NAL_SLICE
+        && nal_unit_type <= GST_H264_NAL_SLICE_IDR) {
+      if (header & 0x60)
+        return FALSE;
+      have_slice = TRUE;
+    }
+    offset += packet_size;
+  }
+
+  return have_slice;
+}
+
+/* Frames skipped under load are finished as decode-only by the element */
+static gboolean
+gst_mfx_decoder_should_skip (GstMfxDecoder * decoder,
+    GstVideoCodecFrame * frame, guint8 * data, gint size)
+{
+  if (GST_VIDEO_CODEC_FRAME_IS_SYNC_POINT (frame)) {
+    decoder->skip_to_key = FALSE;
+    return FALSE;
+  }
+  if (decoder->skip_to_key)
+    return TRUE;
+
+  switch (decoder->skip_mode) {
+    case GST_MFX_DECODER_SKIP_TO_KEY:
+      /* following frames lose their references until the next key frame */
+      decoder->skip_to_key = TRUE;
+      return TRUE;
+    case GST_MFX_DECODER_SKIP_NON_REF:
+      return MFX_CODEC_AVC == decoder->params.mfx.CodecId
+          && gst_mfx_decoder_is_avc_non_ref (decoder, data, size);
+    default:
+      return FALSE;
+  }
+}
+
 static gboolean
 gst_mfx_decoder_convert_avc_stream (GstMfxDecoder * decoder, guint8 * cdata,
     gint size, gboolean drop_ps)
 {
-  guint8 startcode[4] = {0, 0, 0, 1}, nal_unit_type = 0;
-  gint32 offset = 0, packet_size = 0;
+  guint8 nal_unit_type = 0, *start, *out;
+  guint32 offset = 0, packet_size = 0;
+  guint len;
 
   if (!decoder || !cdata || !size)
     return FALSE;
 
-  while (offset < size) {
+  /* The output is never larger than the input, reserve it at once */
+  len = decoder->bitstream->len;
+  decoder->bitstream = g_byte_array_set_size (decoder->bitstream, len + size);
+  start = out = decoder->bitstream->data + len;
+
+  while (offset < (guint32) size) {
+    /* a length prefix or a NAL unit crossing the end of the buffer */
+    if (size - offset <= 4)
+      break;
     packet_size = GST_READ_UINT32_BE(&cdata[offset]);
+    if (packet_size > size - offset - 4)
+      break;
     nal_unit_type = (GstH264NalUnitType)(GST_READ_UINT8(&cdata[offset += 4]) &
                                     NAL_UNITTYPE_BITS);
 
-    if (offset + packet_size > size) break;
-
     /* Avoid mutiple SPS/PPS NAL reinsertion when stream-format=avc. Forced
      * to insert only the first SPS/PPS to fix some video corruption issue.
      * Issue: Gst-play has all the multiple SPS/PPS inserted but not when
@@ -444,20 +555,21 @@ gst_mfx_decoder_convert_avc_stream (GstMfxDecoder * decoder, guint8 * cdata,
       case GST_H264_NAL_PPS:
        if (drop_ps)  break;
       default:
-        decoder->bitstream = g_byte_array_append (decoder->bitstream,
-            startcode, 4);
-        decoder->bitstream = g_byte_array_append (decoder->bitstream,
-            &cdata[offset], packet_size);
-
-        decoder->bs.DataLength += (packet_size + 4);
+        GST_WRITE_UINT32_BE (out, 1);
+        memcpy (out + 4, &cdata[offset], packet_size);
+        out += packet_size + 4;
         break;
     };
 
     offset += packet_size;
   }
 
-  if (offset != size) {
-    GST_ERROR ("AVC stream error, size %d, processed offset %d.", size, offset);
+  decoder->bs.DataLength += out - start;
+  decoder->bitstream = g_byte_array_set_size (decoder->bitstream,
+      len + (out - start));
+
+  if (offset != (guint32) size) {
+    GST_ERROR ("AVC stream error, size %d, processed offset %u.", size, offset);
     return FALSE;
   }
 
@@ -594,6 +706,8 @@ gst_mfx_decoder_init (GstMfxDecoder * decoder,
   decoder->params.IOPattern = MFX_IOPATTERN_OUT_VIDEO_MEMORY;
   decoder->inited = FALSE;
   decoder->sync_out_surf = FALSE;
+  decoder->skip_mode = GST_MFX_DECODER_SKIP_NONE;
+  decoder->skip_to_key = FALSE;
   decoder->bs.MaxLength = 1024 * 16;
   decoder->bitstream = g_byte_array_sized_new (decoder->bs.MaxLength);
   if (!decoder->bitstream)
@@ -608,6 +722,8 @@ gst_mfx_decoder_init (GstMfxDecoder * decoder,
   g_queue_init (&decoder->decoded_frames);
   g_queue_init (&decoder->pending_frames);
   g_queue_init (&decoder->discarded_frames);
+  g_queue_init (&decoder->decode_ops);
+  decoder->async_depth = MAX (decoder->params.AsyncDepth, 1);
 
   decoder->aggregator = gst_mfx_task_aggregator_ref (aggregator);
   if (!task_init(decoder))
@@ -877,12 +993,16 @@ gst_mfx_decoder_reset (GstMfxDecoder * decoder)
   decoder->pts_offset = GST_CLOCK_TIME_NONE;
   decoder->current_pts = 0;
 
+  /* Operations in flight are dropped by MFXVideoDECODE_Reset */
+  gst_mfx_decoder_clear_ops (decoder);
+
   if (decoder->bitstream->len)
     g_byte_array_remove_range (decoder->bitstream, 0,
       decoder->bitstream->len);
   memset(&decoder->bs, 0, sizeof(mfxBitstream));
 
   decoder->was_reset = TRUE;
+  decoder->skip_to_key = FALSE;
   decoder->has_ready_frames = FALSE;
   decoder->num_partial_frames = 0;
 
@@ -922,6 +1042,108 @@ queue_output_frame (GstMfxDecoder * decoder, GstMfxSurface * surface)
     GST_MFX_SURFACE_FRAME_SURFACE (surface)->Data.FrameOrder);
 }
 
+static GstMfxDecoderStatus
+gst_mfx_decoder_output_surface (GstMfxDecoder * decoder,
+    GstMfxSurface * surface)
+{
+  GstMfxFilterStatus filter_sts;
+  GstMfxSurface *filter_surface;
+
+  if (decoder->filter) {
+    do {
+      filter_sts = gst_mfx_filter_process (decoder->filter, surface,
+        &filter_surface);
+      queue_output_frame (decoder, filter_surface);
+    } while (GST_MFX_FILTER_STATUS_ERROR_MORE_SURFACE == filter_sts);
+
+    if (GST_MFX_FILTER_STATUS_SUCCESS != filter_sts) {
+      GST_ERROR ("MFX post-processing error while decoding.");
+      return GST_MFX_DECODER_STATUS_ERROR_UNKNOWN;
+    }
+  }
+  else {
+    queue_output_frame (decoder, surface);
+  }
+  return GST_MFX_DECODER_STATUS_SUCCESS;
+}
+
+/* Output the operations in flight in decoding order. It waits for the oldest
+ * ones until at most max_ops are left, the others are output only if they
+ * are done already. Return ERROR_MORE_DATA if nothing is output. */
+static GstMfxDecoderStatus
+gst_mfx_decoder_complete_ops (GstMfxDecoder * decoder, guint max_ops)
+{
+  GstMfxDecoderStatus ret = GST_MFX_DECODER_STATUS_ERROR_MORE_DATA;
+  GstMfxDecodeOp *op;
+  mfxStatus sts;
+  gboolean wait;
+
+  while ((op = g_queue_peek_head (&decoder->decode_ops))) {
+    wait = g_queue_get_length (&decoder->decode_ops) > max_ops;
+    do {
+      sts = MFXVideoCORE_SyncOperation (decoder->session, op->syncp,
+          wait ? 1000 : 0);
+      GST_DEBUG ("MFXVideoCORE_SyncOperation status: %d", sts);
+    } while (wait && MFX_WRN_IN_EXECUTION == sts);
+
+    /* The oldest one is still running, so are the others */
+    if (MFX_WRN_IN_EXECUTION == sts)
+      break;
+    if (MFX_ERR_NONE != sts)
+      GST_WARNING ("Status %d : Error during MFX sync operation", sts);
+
+    g_queue_pop_head (&decoder->decode_ops);
+    ret = gst_mfx_decoder_output_surface (decoder, op->surface);
+    gst_mfx_surface_pool_unhold_surface (op->surface);
+    g_slice_free (GstMfxDecodeOp, op);
+    if (GST_MFX_DECODER_STATUS_SUCCESS != ret)
+      break;
+  }
+  return ret;
+}
+
+/* Device is busy, wait for the oldest operation in flight instead of sleeping */
+static void
+gst_mfx_decoder_wait_device (GstMfxDecoder * decoder)
+{
+  guint n = g_queue_get_length (&decoder->decode_ops);
+
+  if (n > 0)
+    gst_mfx_decoder_complete_ops (decoder, n - 1);
+  else
+    g_usleep (100);
+}
+
+/* The decoded surface is output after async_depth - 1 operations */
+static GstMfxDecoderStatus
+gst_mfx_decoder_queue_op (GstMfxDecoder * decoder, mfxSyncPoint syncp,
+    mfxFrameSurface1 * outsurf)
+{
+  GstMfxDecodeOp *op;
+  GstMfxSurface *surface;
+
+  /* A peer encoder syncs the surface */
+  if (gst_mfx_task_has_type (decoder->decode, GST_MFX_TASK_ENCODER)) {
+    gst_mfx_decoder_complete_ops (decoder, 0);
+    surface = gst_mfx_surface_pool_find_surface (decoder->pool, outsurf);
+    return gst_mfx_decoder_output_surface (decoder, surface);
+  }
+
+  /* MFX may unlock a non-reference surface before it is output */
+  surface = gst_mfx_surface_pool_hold_surface (decoder->pool, outsurf);
+  if (!surface) {
+    GST_ERROR ("Decoded surface %p is not in the surface pool", outsurf);
+    return GST_MFX_DECODER_STATUS_ERROR_UNKNOWN;
+  }
+
+  op = g_slice_new (GstMfxDecodeOp);
+  op->syncp = syncp;
+  op->surface = surface;
+  g_queue_push_tail (&decoder->decode_ops, op);
+
+  return gst_mfx_decoder_complete_ops (decoder, decoder->async_depth - 1);
+}
+
 static gint
 sort_pts (gconstpointer frame1, gconstpointer frame2, gpointer data)
 {
@@ -937,11 +1159,11 @@ gst_mfx_decoder_decode (GstMfxDecoder * decoder,
 {
   GstMapInfo minfo;
   GstMfxDecoderStatus ret = GST_MFX_DECODER_STATUS_SUCCESS;
-  GstMfxFilterStatus filter_sts;
-  GstMfxSurface *surface, *filter_surface;
+  GstMfxSurface *surface;
   mfxFrameSurface1 *insurf, *outsurf = NULL;
   mfxSyncPoint syncp;
   mfxStatus sts = MFX_ERR_NONE;
+  gboolean in_place = FALSE, zero_copy = FALSE;
 
   if(!GST_CLOCK_TIME_IS_VALID(frame->pts)) {
    frame->pts = frame->dts;
@@ -952,11 +1174,25 @@ gst_mfx_decoder_decode (GstMfxDecoder * decoder,
       && GST_CLOCK_TIME_IS_VALID (frame->pts))
     decoder->pts_offset = frame->pts;
 
-  if (!gst_buffer_map (frame->input_buffer, &minfo, GST_MAP_READ)) {
+  /* An AVC access unit is decoded from the input buffer directly when MFX
+   * holds no data of previous frames, otherwise it's copied into bitstream */
+  if (MFX_CODEC_AVC == decoder->params.mfx.CodecId && decoder->is_avc
+      && decoder->inited && !decoder->was_reset && !decoder->bs.DataLength
+      && gst_buffer_is_writable (frame->input_buffer))
+    in_place = gst_buffer_map (frame->input_buffer, &minfo, GST_MAP_READWRITE);
+
+  if (!in_place && !gst_buffer_map (frame->input_buffer, &minfo, GST_MAP_READ)) {
     GST_ERROR ("Failed to map input buffer");
     return GST_MFX_DECODER_STATUS_ERROR_UNKNOWN;
   }
 
+  if (decoder->inited && !decoder->was_reset
+      && gst_mfx_decoder_should_skip (decoder, frame, minfo.data, minfo.size)) {
+    g_queue_push_head(&decoder->discarded_frames, frame);
+    ret = GST_MFX_DECODER_STATUS_ERROR_MORE_DATA;
+    goto end;
+  }
+
   if (decoder->was_reset) {
     if (GST_VIDEO_CODEC_FRAME_IS_SYNC_POINT (frame)) {
       /* Sequence header check for I-frames after MPEG2 video seeking */
@@ -1021,12 +1257,21 @@ gst_mfx_decoder_decode (GstMfxDecoder * decoder,
         decoder->bs.Data = decoder->bitstream->data;
       }
 
-      if (!gst_mfx_decoder_convert_avc_stream (
-            decoder, minfo.data, minfo.size, !decoder->inited))
-        GST_ERROR ("Error in %s !", __func__);
+      if (in_place
+          && gst_start_code_convert_avc (minfo.data, minfo.size)) {
+        g_byte_array_set_size (decoder->bitstream, 0);
+        decoder->bs.DataOffset = 0;
+        decoder->bs.DataLength = decoder->bs.MaxLength = minfo.size;
+        decoder->bs.Data = minfo.data;
+        zero_copy = TRUE;
+      } else {
+        if (!gst_mfx_decoder_convert_avc_stream (
+              decoder, minfo.data, minfo.size, !decoder->inited))
+          GST_ERROR ("Error in %s !", __func__);
 
-      decoder->bs.MaxLength = decoder->bitstream->len;
-      decoder->bs.Data = decoder->bitstream->data;
+        decoder->bs.MaxLength = decoder->bitstream->len;
+        decoder->bs.Data = decoder->bitstream->data;
+      }
     } else {
       decoder->bitstream = g_byte_array_append (decoder->bitstream,
           minfo.data, minfo.size);
@@ -1046,8 +1291,10 @@ gst_mfx_decoder_decode (GstMfxDecoder * decoder,
 
   do {
     surface = gst_mfx_surface_new_from_pool (decoder->pool);
-    if (!surface)
-      return GST_MFX_DECODER_STATUS_ERROR_ALLOCATION_FAILED;
+    if (!surface) {
+      ret = GST_MFX_DECODER_STATUS_ERROR_ALLOCATION_FAILED;
+      goto end;
+    }
 
     insurf = gst_mfx_surface_get_frame_surface (surface);
     sts = MFXVideoDECODE_DecodeFrameAsync (decoder->session, &decoder->bs,
@@ -1055,7 +1302,7 @@ gst_mfx_decoder_decode (GstMfxDecoder * decoder,
     GST_DEBUG ("MFXVideoDECODE_DecodeFrameAsync status: %d", sts);
 
     if (MFX_WRN_DEVICE_BUSY == sts)
-      g_usleep (100);
+      gst_mfx_decoder_wait_device (decoder);
   } while (sts > 0 || MFX_ERR_MORE_SURFACE == sts);
 
   if (MFX_ERR_MORE_DATA == sts) {
@@ -1105,14 +1352,6 @@ gst_mfx_decoder_decode (GstMfxDecoder * decoder,
     }
     decoder->has_ready_frames = TRUE;
 
-    if (!gst_mfx_task_has_type (decoder->decode, GST_MFX_TASK_ENCODER))
-      do {
-        sts = MFXVideoCORE_SyncOperation (decoder->session, syncp, 1000);
-        GST_DEBUG ("MFXVideoCORE_SyncOperation status: %d", sts);
-      } while (MFX_WRN_IN_EXECUTION == sts);
-
-    surface = gst_mfx_surface_pool_find_surface (decoder->pool, outsurf);
-
     /* Update stream properties if they have interlaced frames. An interlaced H264
      * can only be detected after decoding the first frame, hence the delayed VPP
      * initialization */
@@ -1156,6 +1395,11 @@ update:
      * another task type at this point. */
     if ((decoder->enable_csc || decoder->enable_deinterlace)
         && (gst_mfx_task_get_task_type (decoder->decode) == GST_MFX_TASK_DECODER)) {
+      /* frames decoded before are output with the old session */
+      gst_mfx_decoder_complete_ops (decoder, 0);
+      do {
+        sts = MFXVideoCORE_SyncOperation (decoder->session, syncp, 1000);
+      } while (MFX_WRN_IN_EXECUTION == sts);
       if (!gst_mfx_decoder_reinit (decoder, &outsurf->Info))
         ret = GST_MFX_DECODER_STATUS_ERROR_INIT_FAILED;
       else
@@ -1163,33 +1407,35 @@ update:
       goto end;
     }
 
-    if (decoder->filter) {
-      do {
-        filter_sts = gst_mfx_filter_process (decoder->filter, surface,
-          &filter_surface);
-        queue_output_frame (decoder, filter_surface);
-      } while (GST_MFX_FILTER_STATUS_ERROR_MORE_SURFACE == filter_sts);
-
-      if (GST_MFX_FILTER_STATUS_SUCCESS != filter_sts) {
-        GST_ERROR ("MFX post-processing error while decoding.");
-        ret = GST_MFX_DECODER_STATUS_ERROR_UNKNOWN;
-        goto end;
-      }
-    }
-    else {
-      queue_output_frame (decoder, surface);
+    ret = gst_mfx_decoder_queue_op (decoder, syncp, outsurf);
+    if (GST_MFX_DECODER_STATUS_SUCCESS != ret
+        && GST_MFX_DECODER_STATUS_ERROR_MORE_DATA != ret)
+      goto end;
+
+    if (!zero_copy) {
+      decoder->bitstream = g_byte_array_remove_range (decoder->bitstream, 0,
+        decoder->bs.DataOffset);
+      decoder->bs.DataOffset = 0;
+      decoder->bs.Data = decoder->bitstream->data;
+      decoder->bs.MaxLength = decoder->bitstream->len;
     }
+  }
 
-    decoder->bitstream = g_byte_array_remove_range (decoder->bitstream, 0,
-      decoder->bs.DataOffset);
+end:
+  /* Frames of the operations completed earlier */
+  if (GST_MFX_DECODER_STATUS_ERROR_MORE_DATA == ret
+      && !g_queue_is_empty (&decoder->decoded_frames))
+    ret = GST_MFX_DECODER_STATUS_SUCCESS;
+
+  if (zero_copy) {
+    /* Keep the data MFX has not consumed, the input buffer is unmapped */
+    if (decoder->bs.DataLength)
+      decoder->bitstream = g_byte_array_append (decoder->bitstream,
+          decoder->bs.Data + decoder->bs.DataOffset, decoder->bs.DataLength);
     decoder->bs.DataOffset = 0;
     decoder->bs.Data = decoder->bitstream->data;
     decoder->bs.MaxLength = decoder->bitstream->len;
-
-    ret = GST_MFX_DECODER_STATUS_SUCCESS;
   }
-
-end:
   gst_buffer_unmap (frame->input_buffer, &minfo);
 
   return ret;
@@ -1199,8 +1445,7 @@ GstMfxDecoderStatus
 gst_mfx_decoder_flush (GstMfxDecoder * decoder)
 {
   GstMfxDecoderStatus ret;
-  GstMfxFilterStatus filter_sts;
-  GstMfxSurface *surface, *filter_surface;
+  GstMfxSurface *surface;
   mfxFrameSurface1 *insurf, *outsurf = NULL;
   mfxSyncPoint syncp;
   mfxStatus sts = MFX_ERR_NONE;
@@ -1217,29 +1462,17 @@ gst_mfx_decoder_flush (GstMfxDecoder * decoder)
         insurf, &outsurf, &syncp);
     GST_DEBUG ("MFXVideoDECODE_DecodeFrameAsync status: %d", sts);
     if (sts == MFX_WRN_DEVICE_BUSY)
-      g_usleep (100);
+      gst_mfx_decoder_wait_device (decoder);
   } while (MFX_WRN_DEVICE_BUSY == sts);
 
   if (syncp) {
-    do {
-      sts = MFXVideoCORE_SyncOperation (decoder->session, syncp, 1000);
-      GST_DEBUG ("MFXVideoCORE_SyncOperation status: %d", sts);
-    } while (MFX_WRN_IN_EXECUTION == sts);
-
-    surface = gst_mfx_surface_pool_find_surface (decoder->pool, outsurf);
-
-    if (decoder->filter) {
-      do {
-        filter_sts = gst_mfx_filter_process (decoder->filter, surface,
-          &filter_surface);
-        queue_output_frame (decoder, filter_surface);
-      } while (GST_MFX_FILTER_STATUS_ERROR_MORE_SURFACE == filter_sts);
-    }
-    else {
-      queue_output_frame (decoder, surface);
-    }
-
-    ret = GST_MFX_DECODER_STATUS_SUCCESS;
+    ret = gst_mfx_decoder_queue_op (decoder, syncp, outsurf);
+    /* keep draining */
+    if (GST_MFX_DECODER_STATUS_ERROR_MORE_DATA == ret)
+      ret = GST_MFX_DECODER_STATUS_SUCCESS;
+  } else if (!g_queue_is_empty (&decoder->decode_ops)) {
+    /* No more frames in MFX, output the operations in flight */
+    ret = gst_mfx_decoder_complete_ops (decoder, 0);
   } else {
     ret = GST_MFX_DECODER_STATUS_FLUSHED;
   }
@@ -66,6 +66,20 @@ typedef enum {
   GST_MFX_DECODER_STATUS_ERROR_UNKNOWN = -1
 } GstMfxDecoderStatus;
 
+/**
+* GstMfxDecoderSkipMode:
+* @GST_MFX_DECODER_SKIP_NONE: Decode all frames.
+* @GST_MFX_DECODER_SKIP_NON_REF: Skip the frames which are not used for reference.
+* @GST_MFX_DECODER_SKIP_TO_KEY: Skip all frames until the next key frame.
+*
+* Frame skipping under load, see gst_mfx_decoder_set_skip_mode().
+*/
+typedef enum {
+  GST_MFX_DECODER_SKIP_NONE = 0,
+  GST_MFX_DECODER_SKIP_NON_REF,
+  GST_MFX_DECODER_SKIP_TO_KEY,
+} GstMfxDecoderSkipMode;
+
 GstMfxDecoder *
 gst_mfx_decoder_new (GstMfxTaskAggregator * aggregator,
     GstMfxProfile profile, const GstVideoInfo * info, mfxU16 async_depth,
@@ -97,6 +111,10 @@ gst_mfx_decoder_get_video_info (GstMfxDecoder * decoder);
 void
 gst_mfx_decoder_skip_corrupted_frames (GstMfxDecoder * decoder);
 
+void
+gst_mfx_decoder_set_skip_mode (GstMfxDecoder * decoder,
+    GstMfxDecoderSkipMode mode);
+
 void
 gst_mfx_decoder_should_use_video_memory (GstMfxDecoder * decoder,
     gboolean memtype_is_video);
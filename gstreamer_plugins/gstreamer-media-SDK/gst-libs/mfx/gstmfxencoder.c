@@ -465,6 +465,110 @@ init_encoder_task (GstMfxEncoder * encoder)
       encoder->encode);
 }
 
+/* Bitstream buffers are recycled through a pool once downstream releases
+ * them. The pool keeps the largest size needed so far, so the encoder only
+ * gets MFX_ERR_NOT_ENOUGH_BUFFER until it has seen the peak frame size. */
+static gboolean
+ensure_bitstream_pool (GstMfxEncoder * encoder, gsize size)
+{
+  GstStructure *config;
+
+  if (encoder->bitstream_pool && size <= encoder->bitstream_size)
+    return TRUE;
+
+  /* Buffers still held downstream are freed once released */
+  if (encoder->bitstream_pool) {
+    gst_buffer_pool_set_active (encoder->bitstream_pool, FALSE);
+    gst_object_unref (encoder->bitstream_pool);
+  }
+
+  encoder->bitstream_pool = gst_buffer_pool_new ();
+  config = gst_buffer_pool_get_config (encoder->bitstream_pool);
+  gst_buffer_pool_config_set_params (config, NULL, size, 0, 0);
+  if (!gst_buffer_pool_set_config (encoder->bitstream_pool, config)
+      || !gst_buffer_pool_set_active (encoder->bitstream_pool, TRUE)) {
+    GST_ERROR ("Failed to set up bitstream pool of %" G_GSIZE_FORMAT " bytes",
+        size);
+    gst_object_replace ((GstObject **) & encoder->bitstream_pool, NULL);
+    return FALSE;
+  }
+  encoder->bitstream_size = size;
+  return TRUE;
+}
+
+static gboolean
+acquire_bitstream (GstMfxEncoder * encoder)
+{
+  if (encoder->bitstream)
+    return TRUE;
+
+  if (!ensure_bitstream_pool (encoder, encoder->bitstream_size))
+    return FALSE;
+  if (gst_buffer_pool_acquire_buffer (encoder->bitstream_pool,
+          &encoder->bitstream, NULL) != GST_FLOW_OK)
+    return FALSE;
+  if (!gst_buffer_map (encoder->bitstream, &encoder->bitstream_map,
+          GST_MAP_WRITE)) {
+    gst_buffer_replace (&encoder->bitstream, NULL);
+    return FALSE;
+  }
+
+  encoder->bs.Data = encoder->bitstream_map.data;
+  encoder->bs.MaxLength = encoder->bitstream_map.size;
+  encoder->bs.DataOffset = 0;
+  encoder->bs.DataLength = 0;
+  return TRUE;
+}
+
+static void
+release_bitstream (GstMfxEncoder * encoder)
+{
+  if (!encoder->bitstream)
+    return;
+
+  gst_buffer_unmap (encoder->bitstream, &encoder->bitstream_map);
+  gst_buffer_replace (&encoder->bitstream, NULL);
+  encoder->bs.Data = NULL;
+  encoder->bs.MaxLength = 0;
+  encoder->bs.DataOffset = 0;
+  encoder->bs.DataLength = 0;
+}
+
+static gboolean
+grow_bitstream (GstMfxEncoder * encoder)
+{
+  gsize size = encoder->bitstream_size +
+      MAX (encoder->bitstream_size / 2, 1024 * 16);
+
+  GST_DEBUG ("Growing bitstream buffers from %" G_GSIZE_FORMAT " to %"
+      G_GSIZE_FORMAT " bytes", encoder->bitstream_size, size);
+
+  release_bitstream (encoder);
+  encoder->num_grows++;
+  return ensure_bitstream_pool (encoder, size) && acquire_bitstream (encoder);
+}
+
+/* Hand the encoded frame over, the next one gets another pool buffer */
+static GstBuffer *
+output_bitstream (GstMfxEncoder * encoder)
+{
+  GstBuffer *buffer = encoder->bitstream;
+
+  gst_buffer_unmap (buffer, &encoder->bitstream_map);
+  gst_buffer_resize (buffer, encoder->bs.DataOffset, encoder->bs.DataLength);
+
+  encoder->num_outputs++;
+  encoder->peak_output_size =
+      MAX (encoder->peak_output_size, encoder->bs.DataLength);
+
+  encoder->bitstream = NULL;
+  encoder->bs.Data = NULL;
+  encoder->bs.MaxLength = 0;
+  encoder->bs.DataOffset = 0;
+  encoder->bs.DataLength = 0;
+  return buffer;
+}
+
 static gboolean
 gst_mfx_encoder_init_properties (GstMfxEncoder * encoder,
     GstMfxTaskAggregator * aggregator, const GstVideoInfo * info,
@@ -525,11 +629,7 @@ gst_mfx_encoder_init_properties (GstMfxEncoder * encoder,
   if (!encoder->encode)
     return FALSE;
 
-  encoder->bs.MaxLength = info->width * info->height * 4;
-  encoder->bitstream = g_byte_array_sized_new (encoder->bs.MaxLength);
-  if (!encoder->bitstream)
-    return FALSE;
-  encoder->bs.Data = encoder->bitstream->data;
+  encoder->bitstream_size = info->width * info->height * 4;
   encoder->async_depth = DEFAULT_ASYNC_DEPTH;
 
   encoder->info = *info;
@@ -590,7 +690,15 @@ gst_mfx_encoder_finalize (GstMfxEncoder * encoder)
 
   klass->finalize (encoder);
 
-  g_byte_array_unref (encoder->bitstream);
+  release_bitstream (encoder);
+  if (encoder->bitstream_pool) {
+    GST_INFO ("Encoded %" G_GUINT64_FORMAT " frames, peak size %" G_GSIZE_FORMAT
+        " bytes, bitstream buffers of %" G_GSIZE_FORMAT " bytes grown %u times",
+        encoder->num_outputs, encoder->peak_output_size,
+        encoder->bitstream_size, encoder->num_grows);
+    gst_buffer_pool_set_active (encoder->bitstream_pool, FALSE);
+    gst_object_unref (encoder->bitstream_pool);
+  }
   gst_mfx_task_aggregator_unref (encoder->aggregator);
 
   if (encoder->properties) {
@@ -1022,6 +1130,11 @@ gst_mfx_encoder_start (GstMfxEncoder *encoder)
   memset (&encoder->params, 0, sizeof(mfxVideoParam));
   MFXVideoENCODE_GetVideoParam (encoder->session, &encoder->params);
 
+  /* Size bitstream buffers for what the rate control can produce */
+  if (encoder->params.mfx.BufferSizeInKB)
+    encoder->bitstream_size = (gsize) encoder->params.mfx.BufferSizeInKB *
+        1000 * MAX (encoder->params.mfx.BRCParamMultiplier, 1);
+
   GST_INFO ("Initialized MFX encoder task using input %s memory surfaces",
     memtype_is_system ? "system" : "video");
 
@@ -1069,6 +1182,9 @@ gst_mfx_encoder_encode (GstMfxEncoder * encoder, GstVideoCodecFrame * frame)
       gst_util_uint64_scale (encoder->current_pts, 90000, GST_SECOND);
   encoder->current_pts += encoder->duration;
 
+  if (!acquire_bitstream (encoder))
+    return GST_MFX_ENCODER_STATUS_ERROR_ALLOCATION_FAILED;
+
   do {
     sts = MFXVideoENCODE_EncodeFrameAsync (encoder->session,
             NULL, insurf, &encoder->bs, &syncp);
@@ -1076,10 +1192,8 @@ gst_mfx_encoder_encode (GstMfxEncoder * encoder, GstVideoCodecFrame * frame)
     if (MFX_WRN_DEVICE_BUSY == sts)
       g_usleep (500);
     else if (MFX_ERR_NOT_ENOUGH_BUFFER == sts) {
-      encoder->bs.MaxLength += 1024 * 16;
-      encoder->bitstream = g_byte_array_set_size (encoder->bitstream,
-          encoder->bs.MaxLength);
-      encoder->bs.Data = encoder->bitstream->data;
+      if (!grow_bitstream (encoder))
+        return GST_MFX_ENCODER_STATUS_ERROR_ALLOCATION_FAILED;
     }
   } while (MFX_WRN_DEVICE_BUSY == sts || MFX_ERR_NOT_ENOUGH_BUFFER == sts);
 
@@ -1100,14 +1214,9 @@ gst_mfx_encoder_encode (GstMfxEncoder * encoder, GstVideoCodecFrame * frame)
       sts = MFXVideoCORE_SyncOperation (encoder->session, syncp, 1000);
     } while (MFX_WRN_IN_EXECUTION == sts);
 
-    frame->output_buffer =
-        gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
-          encoder->bs.Data, encoder->bs.MaxLength,
-          encoder->bs.DataOffset, encoder->bs.DataLength, NULL, NULL);
+    frame->output_buffer = output_bitstream (encoder);
 
     calculate_new_pts_and_dts (encoder, frame);
-
-    encoder->bs.DataLength = 0;
   }
 
   if (encoder->bs.FrameType & MFX_FRAMETYPE_IDR
@@ -1125,6 +1234,9 @@ gst_mfx_encoder_flush (GstMfxEncoder * encoder, GstVideoCodecFrame ** frame)
   mfxSyncPoint syncp;
   mfxStatus sts = MFX_ERR_NONE;
 
+  if (!acquire_bitstream (encoder))
+    return GST_MFX_ENCODER_STATUS_ERROR_ALLOCATION_FAILED;
+
   do {
     sts = MFXVideoENCODE_EncodeFrameAsync (encoder->session,
             NULL, NULL, &encoder->bs, &syncp);
@@ -1132,10 +1244,8 @@ gst_mfx_encoder_flush (GstMfxEncoder * encoder, GstVideoCodecFrame ** frame)
     if (MFX_WRN_DEVICE_BUSY == sts)
       g_usleep (500);
     else if (MFX_ERR_NOT_ENOUGH_BUFFER == sts) {
-      encoder->bs.MaxLength += 1024 * 16;
-      encoder->bitstream = g_byte_array_set_size (encoder->bitstream,
-          encoder->bs.MaxLength);
-      encoder->bs.Data = encoder->bitstream->data;
+      if (!grow_bitstream (encoder))
+        return GST_MFX_ENCODER_STATUS_ERROR_ALLOCATION_FAILED;
     }
   } while (MFX_WRN_DEVICE_BUSY == sts || MFX_ERR_NOT_ENOUGH_BUFFER == sts);
 
@@ -1152,14 +1262,9 @@ gst_mfx_encoder_flush (GstMfxEncoder * encoder, GstVideoCodecFrame ** frame)
 
     *frame = g_slice_new0 (GstVideoCodecFrame);
 
-    (*frame)->output_buffer =
-        gst_buffer_new_wrapped_full (GST_MEMORY_FLAG_READONLY,
-          encoder->bs.Data, encoder->bs.MaxLength,
-          encoder->bs.DataOffset, encoder->bs.DataLength, NULL, NULL);
+    (*frame)->output_buffer = output_bitstream (encoder);
 
     calculate_new_pts_and_dts (encoder, *frame);
-
-    encoder->bs.DataLength = 0;
   }
 
   if (encoder->bs.FrameType & MFX_FRAMETYPE_IDR
@@ -155,7 +155,10 @@ struct _GstMfxEncoder
   GstMfxTaskAggregator   *aggregator;
   GstMfxTask             *encode;
   GstMfxFilter           *filter;
-  GByteArray             *bitstream;
+  GstBufferPool          *bitstream_pool;
+  GstBuffer              *bitstream;
+  GstMapInfo              bitstream_map;
+  gsize                   bitstream_size;
   gboolean                memtype_is_system;
   gboolean                shared;
 
@@ -170,6 +173,11 @@ struct _GstMfxEncoder
   GstClockTime            current_pts;
   GstClockTime            duration;
 
+  /* Bitstream statistics */
+  guint64                 num_outputs;
+  gsize                   peak_output_size;
+  guint                   num_grows;
+
   /* Encoder params */
   GstMfxEncoderPreset     preset;
   GstMfxRateControl       rc_method;
@@ -236,6 +236,7 @@ gst_mfx_surface_init_properties(GstMfxSurface * surface)
 #endif
 
   surface->queued = 0;
+  surface->pool_index = -1;
 }
 
 static gboolean
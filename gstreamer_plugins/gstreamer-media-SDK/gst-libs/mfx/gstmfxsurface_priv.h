@@ -67,6 +67,10 @@ struct _GstMfxSurface
   gint drm_fd;
 
   gboolean flipping;
+  /* decoded but not output by the decoder yet, the pool doesn't reuse it */
+  gboolean held;
+  /* slot in the surface pool, -1 if it doesn't belong to a pool */
+  gint pool_index;
 };
 
 struct _GstMfxSurfaceClass
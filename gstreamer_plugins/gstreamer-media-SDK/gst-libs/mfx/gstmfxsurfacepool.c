@@ -29,6 +29,25 @@
 #define DEBUG 1
 #include "gstmfxdebug.h"
 
+/* Surfaces are kept in an array of slots, a slot is either in the free list
+ * or in the used list, both are linked by slot index. The used list is in
+ * the order of acquiring, so the oldest used surface is checked first when
+ * no surface is free. */
+typedef struct _GstMfxSurfaceSlot GstMfxSurfaceSlot;
+struct _GstMfxSurfaceSlot
+{
+  GstMfxSurface *surface;
+  gint prev;
+  gint next;
+  gboolean used;
+};
+
+typedef struct
+{
+  gint head;
+  gint tail;
+} GstMfxSurfaceList;
+
 struct _GstMfxSurfacePool
 {
   /*< private > */
@@ -38,34 +57,90 @@ struct _GstMfxSurfacePool
   GstMfxTask *task;
   GstVideoInfo info;
   gboolean memtype_is_system;
-  GQueue free_surfaces;
-  GList *used_surfaces;
+  GArray *slots;
+  GstMfxSurfaceList free_surfaces;
+  GstMfxSurfaceList used_surfaces;
   guint used_count;
+  guint max_used_count;
   GMutex mutex;
 };
 
+#define SLOT(pool, i) (&g_array_index ((pool)->slots, GstMfxSurfaceSlot, (i)))
+
 static void
-gst_mfx_surface_pool_put_surface (GstMfxSurfacePool * pool,
+slot_list_push_tail (GstMfxSurfacePool * pool, GstMfxSurfaceList * list,
+    gint i)
+{
+  GstMfxSurfaceSlot *slot = SLOT (pool, i);
+
+  slot->prev = list->tail;
+  slot->next = -1;
+  if (list->tail >= 0)
+    SLOT (pool, list->tail)->next = i;
+  else
+    list->head = i;
+  list->tail = i;
+}
+
+static void
+slot_list_remove (GstMfxSurfacePool * pool, GstMfxSurfaceList * list, gint i)
+{
+  GstMfxSurfaceSlot *slot = SLOT (pool, i);
+
+  if (slot->prev >= 0)
+    SLOT (pool, slot->prev)->next = slot->next;
+  else
+    list->head = slot->next;
+  if (slot->next >= 0)
+    SLOT (pool, slot->next)->prev = slot->prev;
+  else
+    list->tail = slot->prev;
+  slot->prev = slot->next = -1;
+}
+
+/* The surface is given to the pool, it is in the free list */
+static void
+gst_mfx_surface_pool_add_slot (GstMfxSurfacePool * pool,
+    GstMfxSurface * surface)
+{
+  GstMfxSurfaceSlot slot = { surface, -1, -1, FALSE };
+
+  surface->pool_index = pool->slots->len;
+  g_array_append_val (pool->slots, slot);
+  slot_list_push_tail (pool, &pool->free_surfaces, surface->pool_index);
+}
+
+static void
+gst_mfx_surface_pool_put_surface_unlocked (GstMfxSurfacePool * pool,
     GstMfxSurface * surface);
 
-static gint
-sync_output_surface (gconstpointer surface, gconstpointer surf)
+static gboolean
+surface_is_released (GstMfxSurface * surface)
 {
-  GstMfxSurface *_surface = (GstMfxSurface *) surface;
-  mfxFrameSurface1 *_surf = (mfxFrameSurface1 *) surf;
+  mfxFrameSurface1 *surf = gst_mfx_surface_get_frame_surface (surface);
 
-  return _surf != GST_MFX_SURFACE_FRAME_SURFACE (_surface);
+  return surf && !surf->Data.Locked && !surface->flipping && !surface->held;
 }
 
+/* Return a used surface which is neither locked by MFX nor held by
+ * downstream. It checks at most max_checks surfaces from the oldest one,
+ * busy surfaces are moved to the tail to be checked later. */
 static void
-release_surfaces (gpointer surface, gpointer pool)
+release_surfaces_unlocked (GstMfxSurfacePool * pool, guint max_checks)
 {
-  GstMfxSurface *_surface = (GstMfxSurface *) surface;
-  GstMfxSurfacePool *_pool = (GstMfxSurfacePool *) pool;
+  guint n = MIN (max_checks, pool->used_count);
+  gint i;
 
-  mfxFrameSurface1 *surf = gst_mfx_surface_get_frame_surface (_surface);
-  if (surf && !surf->Data.Locked && !_surface->flipping)
-    gst_mfx_surface_pool_put_surface (_pool, _surface);
+  while (n-- > 0 && (i = pool->used_surfaces.head) >= 0) {
+    GstMfxSurface *surface = SLOT (pool, i)->surface;
+
+    if (surface_is_released (surface)) {
+      gst_mfx_surface_pool_put_surface_unlocked (pool, surface);
+      break;
+    }
+    slot_list_remove (pool, &pool->used_surfaces, i);
+    slot_list_push_tail (pool, &pool->used_surfaces, i);
+  }
 }
 
 static void
@@ -79,17 +154,19 @@ gst_mfx_surface_pool_add_surfaces(GstMfxSurfacePool * pool)
     if (!surface)
       return;
 
-    g_queue_push_tail (&pool->free_surfaces, surface);
+    gst_mfx_surface_pool_add_slot (pool, surface);
   }
 }
 
 static void
 gst_mfx_surface_pool_init (GstMfxSurfacePool * pool)
 {
-  pool->used_surfaces = NULL;
+  pool->slots = g_array_new (FALSE, FALSE, sizeof (GstMfxSurfaceSlot));
+  pool->free_surfaces.head = pool->free_surfaces.tail = -1;
+  pool->used_surfaces.head = pool->used_surfaces.tail = -1;
   pool->used_count = 0;
+  pool->max_used_count = 0;
 
-  g_queue_init (&pool->free_surfaces);
   g_mutex_init (&pool->mutex);
 
   if (pool->task && gst_mfx_task_has_video_memory (pool->task))
@@ -99,17 +176,21 @@ gst_mfx_surface_pool_init (GstMfxSurfacePool * pool)
 void
 gst_mfx_surface_pool_finalize (GstMfxSurfacePool * pool)
 {
-  GstMfxSurface *surface;
+  guint i;
 
-  while (g_list_length(pool->used_surfaces)) {
-    surface = g_list_nth_data (pool->used_surfaces, 0);
-    gst_mfx_surface_pool_put_surface(pool, surface);
-  }
+  while (pool->used_surfaces.head >= 0)
+    gst_mfx_surface_pool_put_surface_unlocked (pool,
+        SLOT (pool, pool->used_surfaces.head)->surface);
+
+  GST_DEBUG ("surface pool %p: %u surfaces, max %u used", pool,
+      pool->slots->len, pool->max_used_count);
 
-  g_list_free (pool->used_surfaces);
-  g_queue_foreach (&pool->free_surfaces,
-      (GFunc) gst_mfx_surface_unref, NULL);
-  g_queue_clear (&pool->free_surfaces);
+  for (i = 0; i < pool->slots->len; i++) {
+    GstMfxSurface *surface = SLOT (pool, i)->surface;
+    surface->pool_index = -1;
+    gst_mfx_surface_unref (surface);
+  }
+  g_array_free (pool->slots, TRUE);
   g_mutex_clear (&pool->mutex);
 
   gst_mfx_display_replace(&pool->display, NULL);
@@ -196,37 +277,35 @@ static void
 gst_mfx_surface_pool_put_surface_unlocked (GstMfxSurfacePool * pool,
     GstMfxSurface * surface)
 {
-  GList *elem;
+  gint i = surface->pool_index;
 
-  elem = g_list_find (pool->used_surfaces, surface);
-  if (!elem)
+  if (i < 0 || (guint) i >= pool->slots->len
+      || SLOT (pool, i)->surface != surface || !SLOT (pool, i)->used)
     return;
 
   gst_mfx_surface_unref (surface);
   --pool->used_count;
-  pool->used_surfaces = g_list_delete_link (pool->used_surfaces, elem);
-  g_queue_push_tail (&pool->free_surfaces, surface);
-}
-
-static void
-gst_mfx_surface_pool_put_surface (GstMfxSurfacePool * pool,
-    GstMfxSurface * surface)
-{
-  g_return_if_fail (pool != NULL);
-  g_return_if_fail (surface != NULL);
-
-  g_mutex_lock (&pool->mutex);
-  gst_mfx_surface_pool_put_surface_unlocked (pool, surface);
-  g_mutex_unlock (&pool->mutex);
+  SLOT (pool, i)->used = FALSE;
+  slot_list_remove (pool, &pool->used_surfaces, i);
+  slot_list_push_tail (pool, &pool->free_surfaces, i);
 }
 
 static GstMfxSurface *
 gst_mfx_surface_pool_get_surface_unlocked (GstMfxSurfacePool * pool)
 {
-  GstMfxSurface *surface;
+  GstMfxSurface *surface = NULL;
+  gint i;
+
+  /* Usually surfaces are released in the order of acquiring, so checking
+   * the oldest one keeps up with decoding. All are checked if none is free */
+  release_surfaces_unlocked (pool,
+      pool->free_surfaces.head < 0 ? pool->used_count : 1);
 
-  surface = g_queue_pop_head (&pool->free_surfaces);
-  if (!surface) {
+  i = pool->free_surfaces.head;
+  if (i >= 0) {
+    slot_list_remove (pool, &pool->free_surfaces, i);
+  }
+  else {
     // all surfaces are locked, wait but not allocate new
     int num_surfaces = 0;
     if(pool->task)
@@ -248,10 +327,17 @@ gst_mfx_surface_pool_get_surface_unlocked (GstMfxSurfacePool * pool)
     g_mutex_lock (&pool->mutex);
     if (!surface)
       return NULL;
+
+    gst_mfx_surface_pool_add_slot (pool, surface);
+    i = surface->pool_index;
+    slot_list_remove (pool, &pool->free_surfaces, i);
   }
 
-  ++pool->used_count;
-  pool->used_surfaces = g_list_prepend (pool->used_surfaces, surface);
+  surface = SLOT (pool, i)->surface;
+  SLOT (pool, i)->used = TRUE;
+  slot_list_push_tail (pool, &pool->used_surfaces, i);
+  if (++pool->used_count > pool->max_used_count)
+    pool->max_used_count = pool->used_count;
   surface->flipping = FALSE;
   return gst_mfx_surface_ref (surface);
 }
@@ -263,8 +349,6 @@ gst_mfx_surface_pool_get_surface (GstMfxSurfacePool * pool)
 
   g_return_val_if_fail (pool != NULL, NULL);
 
-  g_list_foreach (pool->used_surfaces, release_surfaces, pool);
-
   g_mutex_lock (&pool->mutex);
   surface = gst_mfx_surface_pool_get_surface_unlocked (pool);
   g_mutex_unlock (&pool->mutex);
@@ -272,14 +356,69 @@ gst_mfx_surface_pool_get_surface (GstMfxSurfacePool * pool)
   return surface;
 }
 
+/* surface is the frame surface embedded in a GstMfxSurface of this pool */
 GstMfxSurface *
 gst_mfx_surface_pool_find_surface (GstMfxSurfacePool * pool,
     mfxFrameSurface1 * surface)
 {
+  GstMfxSurface *_surface;
+  GstMfxSurface *found = NULL;
+
   g_return_val_if_fail (pool != NULL, NULL);
+  g_return_val_if_fail (surface != NULL, NULL);
+
+  _surface = (GstMfxSurface *) ((guint8 *) surface -
+      G_STRUCT_OFFSET (GstMfxSurface, surface));
+
+  g_mutex_lock (&pool->mutex);
+  if (_surface->pool_index >= 0
+      && (guint) _surface->pool_index < pool->slots->len
+      && SLOT (pool, _surface->pool_index)->surface == _surface)
+    found = _surface;
+  g_mutex_unlock (&pool->mutex);
+
+  return found;
+}
+
+/* An operation in flight keeps its output surface until it is output, MFX
+ * may unlock the surface before that. Return a new reference, or NULL if
+ * surface is not in this pool */
+GstMfxSurface *
+gst_mfx_surface_pool_hold_surface (GstMfxSurfacePool * pool,
+    mfxFrameSurface1 * surface)
+{
+  GstMfxSurface *found = gst_mfx_surface_pool_find_surface (pool, surface);
+
+  if (!found)
+    return NULL;
+
+  g_mutex_lock (&pool->mutex);
+  found->held = TRUE;
+  g_mutex_unlock (&pool->mutex);
+
+  return gst_mfx_surface_ref (found);
+}
+
+/* Drop the reference got by gst_mfx_surface_pool_hold_surface() */
+void
+gst_mfx_surface_pool_unhold_surface (GstMfxSurface * surface)
+{
+  g_return_if_fail (surface != NULL);
 
-  GList *l = g_list_find_custom (pool->used_surfaces, surface,
-      sync_output_surface);
+  surface->held = FALSE;
+  gst_mfx_surface_unref (surface);
+}
+
+guint
+gst_mfx_surface_pool_get_max_used (GstMfxSurfacePool * pool)
+{
+  guint max_used;
+
+  g_return_val_if_fail (pool != NULL, 0);
+
+  g_mutex_lock (&pool->mutex);
+  max_used = pool->max_used_count;
+  g_mutex_unlock (&pool->mutex);
 
-  return GST_MFX_SURFACE (l->data);
+  return max_used;
 }
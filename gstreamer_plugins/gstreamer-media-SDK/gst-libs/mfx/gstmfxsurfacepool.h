@@ -54,6 +54,16 @@ GstMfxSurface *
 gst_mfx_surface_pool_find_surface (GstMfxSurfacePool * pool,
     mfxFrameSurface1 * surface);
 
+GstMfxSurface *
+gst_mfx_surface_pool_hold_surface (GstMfxSurfacePool * pool,
+    mfxFrameSurface1 * surface);
+
+void
+gst_mfx_surface_pool_unhold_surface (GstMfxSurface * surface);
+
+guint
+gst_mfx_surface_pool_get_max_used (GstMfxSurfacePool * pool);
+
 G_END_DECLS
 
 #endif /* GST_MFX_SURFACE_POOL_H */
@@ -39,6 +39,7 @@ GST_DEBUG_CATEGORY_STATIC (mfxdec_debug);
   g_quark_from_static_string("mfxdec-params")
 
 #define DEFAULT_ASYNC_DEPTH 4
+#define DEFAULT_QOS_SKIP TRUE
 
 /* Default templates */
 #define GST_CAPS_CODEC(CODEC) CODEC "; "
@@ -81,7 +82,8 @@ enum
   PROP_0,
   PROP_ASYNC_DEPTH,
   PROP_LIVE_MODE,
-  PROP_SKIP_CORRUPTED_FRAMES
+  PROP_SKIP_CORRUPTED_FRAMES,
+  PROP_QOS_SKIP
 };
 
 static GstStaticPadTemplate src_template_factory =
@@ -281,6 +283,9 @@ gst_mfxdec_set_property (GObject * object, guint prop_id,
   case PROP_SKIP_CORRUPTED_FRAMES:
     dec->skip_corrupted_frames = g_value_get_boolean (value);
     break;
+  case PROP_QOS_SKIP:
+    dec->qos_skip = g_value_get_boolean (value);
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     break;
@@ -303,6 +308,9 @@ gst_mfxdec_get_property (GObject * object, guint prop_id, GValue * value,
   case PROP_SKIP_CORRUPTED_FRAMES:
     g_value_set_boolean (value, dec->skip_corrupted_frames);
     break;
+  case PROP_QOS_SKIP:
+    g_value_set_boolean (value, dec->qos_skip);
+    break;
   default:
     G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
     break;
@@ -556,6 +564,10 @@ gst_mfxdec_handle_frame (GstVideoDecoder *vdec, GstVideoCodecFrame * frame)
     }
   }
 
+  gst_mfx_decoder_set_skip_mode (mfxdec->decoder,
+      mfxdec->qos_skip ? g_atomic_int_get (&mfxdec->skip_mode)
+      : GST_MFX_DECODER_SKIP_NONE);
+
   sts = gst_mfx_decoder_decode (mfxdec->decoder, frame);
 
   gst_mfxdec_flush_discarded_frames (mfxdec);
@@ -656,6 +668,25 @@ gst_mfxdec_src_event (GstVideoDecoder * vdec, GstEvent * event)
   if (GST_EVENT_TYPE(event) == GST_EVENT_LATENCY)
     mfxdec->dequeuing = TRUE;
 
+  /* Downstream can't keep up, proportion is its load (1.0 = full). Skip the
+   * frames which are not referenced first, then all frames until next key frame */
+  if (GST_EVENT_TYPE(event) == GST_EVENT_QOS) {
+    GstQOSType type;
+    gdouble proportion;
+    gint mode = GST_MFX_DECODER_SKIP_NONE;
+
+    gst_event_parse_qos (event, &type, &proportion, NULL, NULL);
+    if (type == GST_QOS_TYPE_OVERFLOW) {
+      if (proportion >= 2.0)
+        mode = GST_MFX_DECODER_SKIP_TO_KEY;
+      else if (proportion >= 1.0)
+        mode = GST_MFX_DECODER_SKIP_NON_REF;
+      GST_DEBUG_OBJECT (mfxdec, "QoS proportion %f, skip mode %d",
+          proportion, mode);
+      g_atomic_int_set (&mfxdec->skip_mode, mode);
+    }
+  }
+
   return GST_VIDEO_DECODER_CLASS (parent_class)->src_event (vdec, event);
 }
 
@@ -736,6 +767,13 @@ gst_mfxdec_class_init (GstMfxDecClass *klass)
       "Skip decoded frames that have major corruption",
       FALSE, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+  g_object_class_install_property (gobject_class, PROP_QOS_SKIP,
+  g_param_spec_boolean ("qos-skip",
+      "QoS frame skipping",
+      "Skip decoding of non-reference frames, or all frames until next key frame, "
+      "when downstream reports overflow QoS",
+      DEFAULT_QOS_SKIP, G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
   vdec_class->open = GST_DEBUG_FUNCPTR (gst_mfxdec_open);
   vdec_class->close = GST_DEBUG_FUNCPTR (gst_mfxdec_close);
   vdec_class->flush = GST_DEBUG_FUNCPTR (gst_mfxdec_flush);
@@ -788,6 +826,8 @@ gst_mfxdec_init (GstMfxDec *mfxdec)
   mfxdec->async_depth = DEFAULT_ASYNC_DEPTH;
   mfxdec->live_mode = FALSE;
   mfxdec->skip_corrupted_frames = FALSE;
+  mfxdec->qos_skip = DEFAULT_QOS_SKIP;
+  mfxdec->skip_mode = GST_MFX_DECODER_SKIP_NONE;
   mfxdec->prev_surf = NULL;
   mfxdec->dequeuing = FALSE;
   mfxdec->flushing = 0;
@@ -41,6 +41,9 @@ struct _GstMfxDec {
   guint                async_depth;
   gboolean             live_mode;
   gboolean             skip_corrupted_frames;
+  gboolean             qos_skip;
+  /* GstMfxDecoderSkipMode requested by downstream QoS */
+  gint                 skip_mode;
   GstMfxSurface*       prev_surf;
   gboolean             dequeuing;
   gint                 flushing;
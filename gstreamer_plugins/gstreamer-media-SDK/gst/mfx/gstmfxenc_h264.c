@@ -24,6 +24,7 @@
 #include "gstmfxenc_h264.h"
 #include "gstmfxpluginutil.h"
 #include "gstmfxvideomemory.h"
+#include "gst-libs/mfx/common/gststartcode.h"
 
 #include <gst-libs/mfx/gstmfxencoder_h264.h>
 #include <gst-libs/mfx/gstmfxutils_h264.h>
@@ -236,7 +237,6 @@ _h264_byte_stream_next_nal (guint8 * buffer, gint32 len, guint32 * nal_size)
   const guint8 *cur = buffer;
   const guint8 *const end = buffer + len;
   guint8 *nal_start = NULL;
-  guint32 flag = 0xFFFFFFFF;
   guint32 nal_start_len = 0;
 
   g_assert (len >= 0 && buffer && nal_size);
@@ -255,25 +255,16 @@ _h264_byte_stream_next_nal (guint8 * buffer, gint32 len, guint32 * nal_size)
     }
   }
   nal_start = buffer + nal_start_len;
-  cur = nal_start;
+  if (nal_start >= end) {
+    *nal_size = 0;
+    return NULL;
+  }
 
   /*find next nal start position */
-  while (cur < end) {
-    flag = ((flag << 8) | ((*cur++) & 0xFF));
-    if ((flag & 0x00FFFFFF) == 0x00000001) {
-      if (flag == 0x00000001)
-        *nal_size = cur - 4 - nal_start;
-      else
-        *nal_size = cur - 3 - nal_start;
-      break;
-    }
-  }
-  if (cur >= end) {
-    *nal_size = end - nal_start;
-    if (nal_start >= end) {
-      nal_start = NULL;
-    }
-  }
+  cur = nal_start + gst_start_code_find (nal_start, end - nal_start);
+  if (cur < end && cur > nal_start && !cur[-1])        /* 0x00000001 */
+    cur--;
+  *nal_size = cur - nal_start;
   return nal_start;
 }
 
@@ -0,0 +1,270 @@
+/*
+ *  test-startcode.c - checks of the start code helpers
+ *
+ *  Copyright (C) 2018 Intel Corporation
+ *
+ *  This library is free software; you can redistribute it and/or
+ *  modify it under the terms of the GNU Lesser General Public License
+ *  as published by the Free Software Foundation; either version 2.1
+ *  of the License, or (at your option) any later version.
+ *
+ *  This library is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ *  Lesser General Public License for more details.
+ *
+ *  You should have received a copy of the GNU Lesser General Public
+ *  License along with this library; if not, write to the Free
+ *  Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ *  Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+#include "common/gststartcode.h"
+
+/* the plain scan which gst_start_code_find() must agree with */
+static gsize
+find_reference (const guint8 * data, gsize size)
+{
+  gsize i;
+
+  for (i = 0; i + 2 < size; i++)
+    if (!data[i] && !data[i + 1] && data[i + 2] == 1)
+      return i;
+  return size;
+}
+
+/* scan data of size bytes at every start offset, each scan is done on an
+ * exact size copy, so that a read past its end is caught by a memory checker */
+static void
+check_find (const guint8 * data, gsize size)
+{
+  gsize start;
+
+  for (start = 0; start <= size; start++) {
+    guint8 *copy = g_memdup (data + start, size - start);
+    g_assert_cmpuint (gst_start_code_find (copy, size - start), ==,
+        find_reference (copy, size - start));
+    g_free (copy);
+  }
+}
+
+static void
+test_find_3_4_bytes (void)
+{
+  guint8 data[160];
+  gsize pos;
+
+  /* every position crosses a 16 and 32 bytes block of the SIMD scanners */
+  for (pos = 0; pos + 4 <= sizeof (data); pos++) {
+    memset (data, 0xff, sizeof (data));
+    data[pos] = data[pos + 1] = 0;
+    data[pos + 2] = 1;
+    g_assert_cmpuint (gst_start_code_find (data, sizeof (data)), ==, pos);
+
+    /* a four bytes start code is found at its second byte */
+    memset (data, 0xff, sizeof (data));
+    data[pos] = data[pos + 1] = data[pos + 2] = 0;
+    data[pos + 3] = 1;
+    g_assert_cmpuint (gst_start_code_find (data, sizeof (data)), ==, pos + 1);
+  }
+
+  /* 00 00 00 00 01 is found at its last 00 00 01 */
+  memset (data, 0, 64);
+  data[64] = 1;
+  g_assert_cmpuint (gst_start_code_find (data, sizeof (data)), ==, 62);
+  check_find (data, 70);
+
+  /* 00 00 02, 00 01 and 00 00 followed by 00 are not start codes */
+  memset (data, 0xff, sizeof (data));
+  data[10] = data[11] = 0;
+  data[12] = 2;
+  data[40] = 0;
+  data[41] = 1;
+  data[80] = data[81] = data[82] = 0;
+  g_assert_cmpuint (gst_start_code_find (data, sizeof (data)), ==,
+      sizeof (data));
+  check_find (data, sizeof (data));
+}
+
+static void
+test_find_buffer_end (void)
+{
+  guint8 data[100];
+  gsize size, cut;
+
+  for (size = 3; size <= sizeof (data); size++) {
+    /* a start code in the last bytes is found */
+    memset (data, 0xff, sizeof (data));
+    data[size - 3] = data[size - 2] = 0;
+    data[size - 1] = 1;
+    check_find (data, size);
+    g_assert_cmpuint (gst_start_code_find (data, size), ==, size - 3);
+
+    /* split by the end of the buffer, it is not found in the first part,
+     * and found by scanning the next part from the last 2 bytes */
+    for (cut = 1; cut <= 2; cut++) {
+      g_assert_cmpuint (gst_start_code_find (data, size - cut), ==,
+          size - cut);
+      check_find (data, size - cut);
+    }
+    g_assert_cmpuint (gst_start_code_find (data + size - 3, 3), ==, 0);
+  }
+
+  /* nothing to scan */
+  g_assert_cmpuint (gst_start_code_find (data, 0), ==, 0);
+  g_assert_cmpuint (gst_start_code_find (data, 2), ==, 2);
+}
+
+static void
+test_find_random (void)
+{
+  GRand *rand = g_rand_new_with_seed (1);
+  guint8 data[300];
+  guint round, i;
+
+  for (round = 0; round < 200; round++) {
+    gsize size = g_rand_int_range (rand, 0, sizeof (data) + 1);
+    /* mostly zero bytes, so that partial start codes are everywhere */
+    for (i = 0; i < size; i++)
+      data[i] = g_rand_int_range (rand, 0, 8) < 6 ? 0 :
+          g_rand_int_range (rand, 0, 4);
+    check_find (data, size);
+  }
+  g_rand_free (rand);
+}
+
+/* -m perf: throughput of gst_start_code_find() on a 16M NAL unit without
+ * start codes, the worst case of a slice of a big frame */
+static void
+test_find_perf (void)
+{
+  const gsize size = 16 * 1024 * 1024;
+  guint8 *data;
+  gdouble elapsed;
+  gsize i;
+  guint round;
+
+  if (!g_test_perf ())
+    return;
+
+  data = g_malloc (size);
+  for (i = 0; i < size; i++)
+    data[i] = (i % 7) ? (guint8) (i % 251 + 1) : 0;
+
+  g_test_timer_start ();
+  for (round = 0; round < 20; round++)
+    g_assert_cmpuint (gst_start_code_find (data, size), ==, size);
+  elapsed = g_test_timer_elapsed ();
+  g_test_maximized_result (20.0 * size / elapsed / 1e6,
+      "gst_start_code_find: %.1f MB/s", 20.0 * size / elapsed / 1e6);
+
+  /* a plain byte loop, for comparison */
+  g_test_timer_start ();
+  for (round = 0; round < 20; round++)
+    g_assert_cmpuint (find_reference (data, size), ==, size);
+  elapsed = g_test_timer_elapsed ();
+  g_test_message ("byte loop: %.1f MB/s", 20.0 * size / elapsed / 1e6);
+
+  g_free (data);
+}
+
+/* append a NAL unit of size bytes with a 4 bytes length prefix */
+static void
+append_avc_nal (GByteArray * array, guint8 type, guint32 size)
+{
+  guint8 prefix[4];
+  guint32 i;
+
+  GST_WRITE_UINT32_BE (prefix, size);
+  g_byte_array_append (array, prefix, 4);
+  for (i = 0; i < size; i++) {
+    guint8 byte = i ? (guint8) (i * 7 + 1) : type;
+    g_byte_array_append (array, &byte, 1);
+  }
+}
+
+static void
+test_convert_avc (void)
+{
+  static const guint32 sizes[] = { 1, 5, 300, 2, 70000 };
+  GByteArray *array = g_byte_array_new ();
+  GByteArray *copy;
+  gsize offset = 0;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++)
+    append_avc_nal (array, 0x65, sizes[i]);
+  copy = g_byte_array_new ();
+  g_byte_array_append (copy, array->data, array->len);
+
+  g_assert_true (gst_start_code_convert_avc (array->data, array->len));
+  for (i = 0; i < G_N_ELEMENTS (sizes); i++) {
+    g_assert_cmpuint (GST_READ_UINT32_BE (array->data + offset), ==, 1);
+    /* the payload is not touched */
+    g_assert_cmpint (memcmp (array->data + offset + 4, copy->data + offset + 4,
+            sizes[i]), ==, 0);
+    offset += sizes[i] + 4;
+  }
+  g_assert_cmpuint (offset, ==, array->len);
+
+  /* an empty access unit has nothing to convert */
+  g_assert_true (gst_start_code_convert_avc (array->data, 0));
+
+  g_byte_array_unref (copy);
+  g_byte_array_unref (array);
+}
+
+/* a broken access unit is left untouched */
+static void
+check_avc_broken (GByteArray * array)
+{
+  guint8 *copy = g_memdup (array->data, array->len);
+
+  g_assert_false (gst_start_code_convert_avc (array->data, array->len));
+  g_assert_cmpint (memcmp (array->data, copy, array->len), ==, 0);
+  g_free (copy);
+}
+
+static void
+test_convert_avc_cross_end (void)
+{
+  GByteArray *array = g_byte_array_new ();
+  guint cut;
+
+  append_avc_nal (array, 0x67, 20);
+  append_avc_nal (array, 0x68, 4);
+  append_avc_nal (array, 0x65, 1000);
+
+  /* the last NAL unit or its length prefix crosses the end of the buffer */
+  for (cut = 1; cut <= 1004 - 1; cut++) {
+    GByteArray *part = g_byte_array_new ();
+    g_byte_array_append (part, array->data, array->len - cut);
+    check_avc_broken (part);
+    g_byte_array_unref (part);
+  }
+
+  /* a length larger than the whole buffer, and one which wraps the offset */
+  GST_WRITE_UINT32_BE (array->data + 24, 0x7fffffff);
+  check_avc_broken (array);
+  GST_WRITE_UINT32_BE (array->data + 24, 0xfffffffc);
+  check_avc_broken (array);
+
+  g_byte_array_unref (array);
+}
+
+int
+main (int argc, char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/startcode/find-3-4-bytes", test_find_3_4_bytes);
+  g_test_add_func ("/startcode/find-buffer-end", test_find_buffer_end);
+  g_test_add_func ("/startcode/find-random", test_find_random);
+  g_test_add_func ("/startcode/find-perf", test_find_perf);
+  g_test_add_func ("/startcode/convert-avc", test_convert_avc);
+  g_test_add_func ("/startcode/convert-avc-cross-end",
+      test_convert_avc_cross_end);
+
+  return g_test_run ();
+}
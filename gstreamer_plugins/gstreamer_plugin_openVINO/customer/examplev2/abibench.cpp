@@ -0,0 +1,173 @@
+/*
+ *Copyright (C) 2018 Intel Corporation
+ *
+ *SPDX-License-Identifier: LGPL-2.1-only
+ *
+ *This library is free software; you can redistribute it and/or modify it under the terms
+ * of the GNU Lesser General Public License as published by the Free Software Foundation;
+ * version 2.1.
+ *
+ *This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this library;
+ * if not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+// Compare the cost of v1 and v2 ABI of generic algo library, with a synthetic SSD result.
+// It does what GenericAlgo does for each frame: parse the result and post process the objects.
+// Before that, it checks that v2 parses the same objects as v1, and reports a full arena.
+//
+// usage: abibench <v1 library> <v2 library> [frames]
+// note: the v1 example library prints every object it parses, redirect stdout to /dev/null
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <dlfcn.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "exinferdata.h"
+#include "exinferdatav2.h"
+
+#define SSD_PROPOSAL_NUM 100
+#define SSD_OBJECT_SIZE 7
+#define IMAGE_WIDTH 1920
+#define IMAGE_HEIGHT 1080
+
+// 40 cars in the lower part of the image, the others are background
+static void fill_ssd_result(std::vector<float> &data)
+{
+    data.assign(SSD_PROPOSAL_NUM * SSD_OBJECT_SIZE, 0.0f);
+    for(int i = 0; i < SSD_PROPOSAL_NUM; i++) {
+        float *box = &data[i * SSD_OBJECT_SIZE];
+        box[1] = (i < 40) ? 7 : 0;
+        box[2] = 0.9f;
+        box[3] = 0.01f * (i % 50);
+        box[4] = 0.5f;
+        box[5] = box[3] + 0.05f;
+        box[6] = 0.6f;
+    }
+}
+
+// v2 must parse the same objects as v1, and report the objects which don't fit in the arena
+static bool check_abi(void *v1, void *v2, std::vector<float> &data)
+{
+    pfInferenceResultParseFunc parse1 = (pfInferenceResultParseFunc)dlsym(v1, "parse_inference_result");
+    pfInferenceBatchParseFunc parse2 = (pfInferenceBatchParseFunc)dlsym(v2, "ex_parse_inference_batch");
+    pfGetAbiVersionFunc version = (pfGetAbiVersionFunc)dlsym(v2, "ex_algo_abi_version");
+    bool ok = true;
+
+    if(!parse1 || !parse2 || !version || version() != EX_ALGO_ABI_VERSION) {
+        fprintf(stderr, "check: missing entry points or wrong ABI version!\n");
+        return false;
+    }
+
+    ExInferData *result = parse1(data.data(), DataTypeFP32, data.size(), IMAGE_WIDTH, IMAGE_HEIGHT);
+    int num = (int)result->mObjectVec.size();
+    std::vector<ExObject> objects(num + 1);
+    ExResultArena arena = {objects.data(), (int)objects.size(), 0, 0, 0};
+    int ret = parse2(data.data(), DataTypeFP32, data.size(), 1, IMAGE_WIDTH, IMAGE_HEIGHT, &arena);
+    if(ret != num || arena.count != num || arena.dropped != 0) {
+        fprintf(stderr, "check: v1 parsed %d objects, v2 parsed %d\n", num, ret);
+        ok = false;
+    }
+    for(int i = 0; ok && i < num; i++) {
+        ExObjectData &o1 = result->mObjectVec[i];
+        ExObject &o2 = objects[i];
+        if(o1.objectClass != o2.objectClass || o1.prob != o2.prob || o1.label != o2.label ||
+           o1.x != o2.x || o1.y != o2.y || o1.w != o2.w || o1.h != o2.h || o2.flags != 0) {
+            fprintf(stderr, "check: object %d differs\n", i);
+            ok = false;
+        }
+    }
+    delete result;
+
+    // half of the objects fit, the others are counted in dropped
+    arena = {objects.data(), num / 2, 0, 0, 0};
+    ret = parse2(data.data(), DataTypeFP32, data.size(), 1, IMAGE_WIDTH, IMAGE_HEIGHT, &arena);
+    if(ret != num / 2 || arena.count != num / 2 || arena.dropped != num - num / 2) {
+        fprintf(stderr, "check: full arena returned %d objects, dropped %d\n", ret, arena.dropped);
+        ok = false;
+    }
+    return ok;
+}
+
+static double bench_v1(void *handler, std::vector<float> &data, int frames)
+{
+    pfInferenceResultParseFunc parse = (pfInferenceResultParseFunc)dlsym(handler, "parse_inference_result");
+    pfPostProcessInferenceDataFunc post = (pfPostProcessInferenceDataFunc)dlsym(handler, "post_process_inference_data");
+    if(!parse || !post) {
+        fprintf(stderr, "not a v1 library!\n");
+        return -1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    for(int f = 0; f < frames; f++) {
+        ExInferData *result = parse(data.data(), DataTypeFP32, data.size(), IMAGE_WIDTH, IMAGE_HEIGHT);
+        // GenericAlgo copies the objects out, and copies them again for post process
+        ExInferData postData;
+        for(size_t i = 0; i < result->mObjectVec.size(); i++)
+            postData.mObjectVec.push_back(result->mObjectVec[i]);
+        post(postData);
+        delete result;
+    }
+    std::chrono::duration<double, std::micro> cost = std::chrono::steady_clock::now() - start;
+    return cost.count() / frames;
+}
+
+static double bench_v2(void *handler, std::vector<float> &data, int frames)
+{
+    pfInferenceBatchParseFunc parse = (pfInferenceBatchParseFunc)dlsym(handler, "ex_parse_inference_batch");
+    pfPostProcessObjectsFunc post = (pfPostProcessObjectsFunc)dlsym(handler, "ex_post_process_objects");
+    if(!parse || !post) {
+        fprintf(stderr, "not a v2 library!\n");
+        return -1;
+    }
+
+    std::vector<ExObject> objects(256);
+    auto start = std::chrono::steady_clock::now();
+    for(int f = 0; f < frames; f++) {
+        ExResultArena arena = {objects.data(), (int)objects.size(), 0, 0, 0};
+        parse(data.data(), DataTypeFP32, data.size(), 1, IMAGE_WIDTH, IMAGE_HEIGHT, &arena);
+        post(&arena);
+    }
+    std::chrono::duration<double, std::micro> cost = std::chrono::steady_clock::now() - start;
+    return cost.count() / frames;
+}
+
+int main(int argc, char *argv[])
+{
+    std::vector<float> data;
+    int frames = 10000;
+
+    if(argc < 3) {
+        fprintf(stderr, "usage: %s <v1 library> <v2 library> [frames]\n", argv[0]);
+        return 1;
+    }
+    if(argc > 3)
+        frames = atoi(argv[3]);
+    if(frames <= 0)
+        frames = 1;
+
+    void *v1 = dlopen(argv[1], RTLD_LAZY);
+    void *v2 = dlopen(argv[2], RTLD_LAZY);
+    if(!v1 || !v2) {
+        fprintf(stderr, "Failed to dlopen: %s\n", dlerror());
+        return 1;
+    }
+
+    fill_ssd_result(data);
+    if(!check_abi(v1, v2, data)) {
+        fprintf(stderr, "ABI check failed!\n");
+        return 1;
+    }
+    double costV1 = bench_v1(v1, data, frames);
+    double costV2 = bench_v2(v2, data, frames);
+    fprintf(stderr, "%d frames: v1 = %.2f us/frame, v2 = %.2f us/frame\n", frames, costV1, costV2);
+
+    dlclose(v1);
+    dlclose(v2);
+    return 0;
+}
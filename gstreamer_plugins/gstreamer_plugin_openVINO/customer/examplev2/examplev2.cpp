@@ -0,0 +1,147 @@
+/*
+ *Copyright (C) 2018 Intel Corporation
+ *
+ *SPDX-License-Identifier: LGPL-2.1-only
+ *
+ *This library is free software; you can redistribute it and/or modify it under the terms
+ * of the GNU Lesser General Public License as published by the Free Software Foundation;
+ * version 2.1.
+ *
+ *This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this library;
+ * if not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+// The same SSD parser as example, but with v2 ABI
+
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include "exinferdata.h"
+#include "exinferdatav2.h"
+
+using namespace std;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+static const char* VOC_LABEL_MAPPING[] = {
+         "background",    "aeroplane",    "bicycle",    "bird",    "boat",    "bottle",
+         "bus",    "car",    "cat",    "chair",    "cow",    "diningtable",    "dog",    "horse",
+         "motorbike",    "person",    "pottedplant",    "sheep",    "sofa",    "train",
+         "tvmonitor"
+ };
+
+int ex_algo_abi_version(void)
+{
+    return EX_ALGO_ABI_VERSION;
+}
+
+// parse the inference data of batch_num items
+int ex_parse_inference_batch(const void *in_data, int data_type, int data_len, int batch_num,
+                             int image_width, int image_height, ExResultArena *arena)
+{
+    const static int mSSDMaxProposalCount = 100;
+    const static int mSSDObjectSize=7;
+    int begin = arena->count;
+
+    if(data_type != DataTypeFP32 || batch_num <= 0)
+        return -1;
+
+    for (int b = 0; b < batch_num; b++) {
+        const float *box = (const float *)in_data + b * (data_len / batch_num);
+        for (int i = 0; i < mSSDMaxProposalCount; i++) {
+            float image_id = box[i * mSSDObjectSize + 0];
+            if (image_id < 0 /* better than check == -1 */) {
+                break;
+            }
+
+            auto label = (int)box[i * mSSDObjectSize + 1];
+            float confidence = box[i * mSSDObjectSize + 2];
+            if (confidence < 0.2) {
+                continue;
+            }
+            if((label != 6) &&(label!=7) &&(label!=15))
+                continue;
+
+            auto xmin = (int)(box[i * mSSDObjectSize + 3] * (float)image_width);
+            auto ymin = (int)(box[i * mSSDObjectSize + 4] * (float)image_height);
+            auto xmax = (int)(box[i * mSSDObjectSize + 5] * (float)image_width);
+            auto ymax = (int)(box[i * mSSDObjectSize + 6] * (float)image_height);
+
+            xmin = std::min(std::max(xmin, 0), image_width - 1);
+            xmax = std::min(std::max(xmax, 0), image_width - 1);
+            ymin = std::min(std::max(ymin, 0), image_height - 1);
+            ymax = std::min(std::max(ymax, 0), image_height - 1);
+
+            if(xmin >= xmax || ymin >= ymax) continue;
+
+            // only detect the lower 3/2 part in the image
+            if (ymin < (int)((float)image_height * 0.1f)) continue;
+            if (ymax >= image_height -10 ) continue;
+
+            // arena is full, tell the caller how many more objects it needs
+            if(arena->count >= arena->capacity) {
+                arena->dropped++;
+                continue;
+            }
+
+            ExObject *object = &arena->objects[arena->count];
+            object->id = arena->count - begin;
+            object->objectClass = label;
+            object->label = VOC_LABEL_MAPPING[label];
+            object->prob = confidence;
+            object->x = xmin;
+            object->y = ymin;
+            object->w = xmax - xmin + 1;
+            object->h = ymax - ymin + 1;
+            object->batchIndex = b;
+            object->flags = 0;
+            arena->count++;
+        }
+    }
+    arena->outputIndex = 0; //must set its value
+    return arena->count - begin;
+}
+
+// post process all objects for this frame, remove the too small objects
+int ex_post_process_objects(ExResultArena *arena)
+{
+    int changed = 0;
+    for(int i = 0; i < arena->count; i++) {
+        ExObject *object = &arena->objects[i];
+        if(object->w * object->h < 16 * 16) {
+            object->flags |= EX_OBJECT_FLAG_REMOVED;
+            changed = 1;
+        }
+    }
+    arena->outputIndex = 0; //must set its value
+    return changed;
+}
+
+char *get_network_config(const char* modelName)
+{
+    std::string modelNameStr = std::string(modelName);
+    std::string config_xml =  std::string("file=") + modelNameStr.substr(0, modelNameStr.rfind(".")) + std::string(".conf.xml");
+    char* config = strdup(config_xml.c_str());
+    return config;
+}
+
+// get the data type for inference input and result
+void get_data_type(ExDataType *inData,  ExDataType *outData)
+{
+     *inData = DataTypeFP32;
+     *outData = DataTypeFP32;
+}
+void get_mean_scale(float *mean, float *scale)
+{
+    *mean = 127.0f;
+    *scale = 1.0/127.0f;
+}
+#ifdef __cplusplus
+};
+#endif
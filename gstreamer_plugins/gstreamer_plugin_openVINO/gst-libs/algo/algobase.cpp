@@ -20,20 +20,23 @@
 #include <gst/video/video.h>
 #include "algobase.h"
 #include "algopipeline.h"
+#include "algorecord.h"
 
 //#define DUMP_BUFFER_ENABLE
 
+// max time to wait for the inferences in flight when an algo is stopped
+#define ALGO_WORK_DONE_TIMEOUT 10000 //ms
+
 using namespace std;
 using namespace cv;
 
-static void algo_enter_thread (GstTask * task, GThread * thread, gpointer user_data)
-{
-    GST_LOG("enter algo thread.");
-}
-
-static void algo_leave_thread (GstTask * task, GThread * thread, gpointer user_data)
+// This frame will not be put into next algo, tell SinkAlgo not to wait for it
+static void algo_data_drop_frame(CvdlAlgoBase *algo, CvdlAlgoData *algoData)
 {
-    GST_LOG("leave algo thread.");
+    if(algoData->mJoin)
+        algo_data_leave_join(algoData);
+    else if(algo->mSinkAlgo)
+        algo->mSinkAlgo->skip_frame(algoData->mFrameId);
 }
 
 static void try_process_algo_data(CvdlAlgoData *algoData)
@@ -56,7 +59,10 @@ static void try_process_algo_data(CvdlAlgoData *algoData)
         algoData->mAllObjectDone = true;
         // clear input objectData
         algoData->mObjectVecIn.clear();
-        if(hddlAlgo->postCb)
+        // the algo is stopping, a partial result is not passed down
+        if(algoData->mDropped)
+            algoData->mObjectVec.clear();
+        else if(hddlAlgo->postCb)
                hddlAlgo->postCb(algoData);
 
         std::vector<ObjectData> &objectVec = algoData->mObjectVec;
@@ -65,12 +71,14 @@ static void try_process_algo_data(CvdlAlgoData *algoData)
             GST_LOG("algo %d(%s) - output GstBuffer = %p(%d)\n",
                    hddlAlgo->mAlgoType, hddlAlgo->mName.c_str(), algoData->mGstBuffer,
                    GST_MINI_OBJECT_REFCOUNT(algoData->mGstBuffer));
-            hddlAlgo->mNext[algoData->mOutputIndex]->mInQueue.put(algoData);
+            hddlAlgo->push_to_next(algoData);
         } else {
             GST_LOG("algo %d(%s) - unref GstBuffer = %p(%d)\n",
                 hddlAlgo->mAlgoType, hddlAlgo->mName.c_str(), algoData->mGstBuffer,
                 GST_MINI_OBJECT_REFCOUNT(algoData->mGstBuffer));
             gst_buffer_unref(algoData->mGstBuffer);
+            // Not wait the delayed delete, SinkAlgo may be waiting for this frame
+            algo_data_drop_frame(hddlAlgo, algoData);
              // delete the obsoleted algoData delayed some time to avoid race condition.
             if(hddlAlgo->mObsoletedAlgoData)
                 delete hddlAlgo->mObsoletedAlgoData;
@@ -121,7 +129,6 @@ static void try_process_algo_data(CvdlAlgoData *algoData)
         try_process_algo_data(algoData);
         return;
     }
-    objectData.oclBuf = ocl_buf;
     //test
     #ifdef  DUMP_BUFFER_ENABLE
         hddlAlgo->save_buffer(ocl_mem->frame.getMat(0).ptr(), hddlAlgo->mInputWidth,
@@ -129,12 +136,19 @@ static void try_process_algo_data(CvdlAlgoData *algoData)
                 algo_pipeline_get_name(hddlAlgo->mAlgoType));
     #endif
     // result callback function
-    auto onHddlResult = [&objectData](void* data)
+    auto onHddlResult = [&objectData](void* data, bool dropped)
     {
         CvdlAlgoData *algoData = static_cast<CvdlAlgoData*> (data);
         CvdlAlgoBase *hddlAlgo = algoData->algoBase;
 
+        if(dropped) {
+            hddlAlgo->mAlgoDataMutex.lock();
+            algoData->mDropped = TRUE;
+            hddlAlgo->mAlgoDataMutex.unlock();
+        }
+
         hddlAlgo->mInferCnt--;
+        hddlAlgo->notify_work_done();
         objectData.flags |= CVDL_OBJECT_FLAG_DONE;
 
         // check and process algoData
@@ -142,21 +156,22 @@ static void try_process_algo_data(CvdlAlgoData *algoData)
     };
 
     // ASync detect, directly return after pushing request.
+    // onHddlResult may run before do_inference_async returns, e.g. the job is dropped,
+    // then algoData may have been freed, so objectData must not be touched after it.
+    hddlAlgo->mInferCnt++;
+    hddlAlgo->mInferCntTotal++;
     start = g_get_monotonic_time();
     ret = hddlAlgo->mIeLoader.do_inference_async((void *)algoData, algoData->mFrameId,objId,
-                                                        ocl_mem->frame, onHddlResult);
+                                                        ocl_mem->frame, onHddlResult, ocl_buf);
 
-    // this ocl will not use, free it here
+    // IE service holds this ocl buffer until it is put into infer request, free it here
     GST_LOG("algo %d(%s) - unref Ocl GstBuffer = %p(%d)\n",
-                hddlAlgo->mAlgoType, hddlAlgo->mName.c_str(), objectData.oclBuf,
-                GST_MINI_OBJECT_REFCOUNT(objectData.oclBuf));
-    gst_buffer_unref(objectData.oclBuf);
-    objectData.oclBuf  = NULL;
+                hddlAlgo->mAlgoType, hddlAlgo->mName.c_str(), ocl_buf,
+                GST_MINI_OBJECT_REFCOUNT(ocl_buf));
+    gst_buffer_unref(ocl_buf);
 
     stop = g_get_monotonic_time();
     hddlAlgo->mInferCost += (stop - start);
-    hddlAlgo->mInferCnt++;
-    hddlAlgo->mInferCntTotal++;
 
     if (ret!=GST_FLOW_OK) {
         g_print("IE: inference failed, ret = %d\n",ret);
@@ -170,30 +185,10 @@ static void try_process_algo_data(CvdlAlgoData *algoData)
  *     2. async inference
  *     3. parse inference result and put it into in_queue of next algo
  */
-static void base_hddl_algo_func(gpointer userData)
+static void base_hddl_algo_process(CvdlAlgoBase *hddlAlgo, CvdlAlgoData *algoData)
 {
-    CvdlAlgoBase *hddlAlgo = static_cast<CvdlAlgoBase*> (userData);
-    CvdlAlgoData *algoData = NULL;//new CvdlAlgoData;
     const char*algo_name = algo_pipeline_get_name(hddlAlgo->mAlgoType);
-    GST_LOG("\n%s:%s - new an algoData = %p\n", __func__, algo_name, algoData);
-
-    if(!hddlAlgo->mNext[0]) {
-        GST_WARNING("The %s algo's next algo is NULL", algo_name);
-    }
-
-    if(!hddlAlgo->mInQueue.get(algoData)) {
-        GST_WARNING("InQueue is empty!");
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        //delete algoData;
-        return;
-    }
-
-    if(algoData->mGstBuffer==NULL) {
-        GST_WARNING("Invalid buffer!!!");
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        delete algoData;
-        return;
-    }
+    GST_LOG("\n%s:%s - get an algoData = %p\n", __func__, algo_name, algoData);
 
     // bind algoTask into algoData, so that can be used when sync callback
     algoData->algoBase = static_cast<CvdlAlgoBase *>(hddlAlgo);
@@ -222,8 +217,9 @@ static void base_hddl_algo_func(gpointer userData)
         algoData->mObjectVecIn[i].flags =0;
     }
 
-    //process all object
-    for(unsigned int i=0; i< algoData->mObjectVecIn.size(); i++) {
+    //process all object, algoData may be freed once the last one is done
+    unsigned int objectNum = algoData->mObjectVecIn.size();
+    for(unsigned int i=0; i< objectNum; i++) {
         process_one_object(algoData, algoData->mObjectVecIn[i], i);
     }
 
@@ -244,6 +240,7 @@ void push_algo_data(CvdlAlgoData* &algoData)
         GST_LOG("push_algo_data - unref GstBuffer = %p(%d)\n",
             algoData->mGstBuffer, GST_MINI_OBJECT_REFCOUNT(algoData->mGstBuffer));
         gst_buffer_unref(algoData->mGstBuffer);
+        algo_data_drop_frame(cvAlgo, algoData);
         delete algoData;
         return;
     }
@@ -258,7 +255,7 @@ void push_algo_data(CvdlAlgoData* &algoData)
             objectVec[i].rect.x, objectVec[i].rect.y,
             objectVec[i].rect.width, objectVec[i].rect.height, objectVec[i].score);
     }
-    cvAlgo->mNext[algoData->mOutputIndex]->mInQueue.put(algoData);
+    cvAlgo->push_to_next(algoData);
     //delete algoData;
 }
 
@@ -268,31 +265,13 @@ void push_algo_data(CvdlAlgoData* &algoData)
  *     2. cv(track) processsing
  *     3. queue algoData into in_queue of next algo
  */
-static void base_cv_algo_func(gpointer userData)
+static void base_cv_algo_process(CvdlAlgoBase *cvAlgo, CvdlAlgoData *algoData)
 {
-    CvdlAlgoBase *cvAlgo = static_cast<CvdlAlgoBase*> (userData);
-    CvdlAlgoData *algoData = NULL;//new CvdlAlgoData;
     gint64 start, stop;
 
     const char*algo_name = algo_pipeline_get_name(cvAlgo->mAlgoType);
-    GST_LOG("\n%s:%s - new an algoData = %p\n", __func__, algo_name, algoData);
-
-    if(!cvAlgo->mNext[0]) {
-        GST_WARNING("Algo %d: the next algo is NULL, return!", cvAlgo->mAlgoType);
-        return;
-    }
+    GST_LOG("\n%s:%s - get an algoData = %p\n", __func__, algo_name, algoData);
 
-    if(!cvAlgo->mInQueue.get(algoData)) {
-        GST_WARNING("Algo %d:InQueue is empty!", cvAlgo->mAlgoType);
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        return;
-    }
-    if(algoData->mGstBuffer==NULL) {
-        GST_WARNING("Algo %d: Invalid buffer!!!", cvAlgo->mAlgoType);
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
-        delete algoData;
-        return;
-    }
     start = g_get_monotonic_time();
 
     // bind algoTask into algoData, so that can be used when sync callback
@@ -315,7 +294,9 @@ static void base_cv_algo_func(gpointer userData)
     if(ocl_buf==NULL) {
         GST_WARNING("Failed to do image process!");
         cvAlgo->mInferCnt=0;
+        cvAlgo->notify_work_done();
         gst_buffer_unref(algoData->mGstBuffer);
+        algo_data_drop_frame(cvAlgo, algoData);
         delete algoData;
         return;
     }
@@ -324,7 +305,9 @@ static void base_cv_algo_func(gpointer userData)
     if(ocl_mem==NULL){
         GST_WARNING("Failed get ocl_mem after image process!");
         cvAlgo->mInferCnt=0;
+        cvAlgo->notify_work_done();
         gst_buffer_unref(algoData->mGstBuffer);
+        algo_data_drop_frame(cvAlgo, algoData);
         delete algoData;
         return;
     }
@@ -346,39 +329,67 @@ static void base_cv_algo_func(gpointer userData)
     // push data if possible
     push_algo_data(algoData);
     cvAlgo->mInferCnt=0;
+    cvAlgo->notify_work_done();
     cvAlgo->mInferCntTotal++;
     cvAlgo->mFrameDoneNum++;
 }
 
 CvdlAlgoBase::CvdlAlgoBase(PostCallback  cb, guint cvdlType )
     :mCapsInited(false), mAlgoType(ALGO_NONE), mName(std::string("")),
-     mCvdlType(cvdlType), mTask(NULL), mIeInited(false),
+     mCvdlType(cvdlType), mExecutor(NULL), mStageTask(NULL), mThreadId(0), mLastCpu(-1), mIeInited(false),
+     mTargetDevice(InferenceEngine::TargetDevice::eHDDL),
      mInputWidth(0), mInputHeight(0), mImageProcessorInVideoWidth(0),
      mImageProcessorInVideoHeight(0), mInCaps(NULL), mOclCaps(NULL), 
-     mPrev(NULL), mObsoletedAlgoData(NULL), postCb(cb),
-     mInferCnt(0), mInferCntTotal(0), mFrameIndex(0), mFrameDoneNum(0),
-     mImageProcCost(1), mInferCost(1), mFrameIndexLast(0), mObjIndex(0),
+     mPrev(NULL), mFanOut(FALSE), mSinkAlgo(NULL), mObsoletedAlgoData(NULL), postCb(cb),
+     mInferCnt(0), mInferCntTotal(0), mLastDequeue(0), mFrameIndex(0), mFrameDoneNum(0),
+     mImageProcCost(1), mInferCost(1), mLatencyStat(FALSE), mRecorder(NULL), mFrameIndexLast(0), mObjIndex(0),
      fpOclResult(NULL)
 {
-    g_rec_mutex_init (&mMutex);
-
-    if(cvdlType == CVDL_TYPE_NONE) {
-        mTask = NULL;
+    if(cvdlType == CVDL_TYPE_NONE)
         return;
-    }
 
     for(int i=0;i<MAX_DOWN_STREAM_ALGO_NUM;i++)
         mNext[i]=NULL;
+}
+
+/*
+ * Process one frame of the input queue on an executor worker, it is the
+ * stage task of this algo. Return false if there is no frame.
+ */
+bool CvdlAlgoBase::run_stage()
+{
+    CvdlAlgoData *algoData = NULL;
+
+    if(!mNext[0]) {
+        GST_WARNING("Algo %d: the next algo is NULL!", mAlgoType);
+        return false;
+    }
+    if(!mInQueue.try_get(algoData))
+        return false;
+    mLastDequeue = g_get_monotonic_time();
+    mLastCpu = sched_getcpu();
+    mThreadId = AlgoExecutor::current_thread_id();
+
+    if(algoData->mGstBuffer==NULL) {
+        GST_WARNING("Algo %d: Invalid buffer!!!", mAlgoType);
+        delete algoData;
+        return true;
+    }
 
-    /* Create task for this algo */
-    if(cvdlType==CVDL_TYPE_DL) {
-        mTask = gst_task_new (base_hddl_algo_func, this, NULL);
-     } else {
-         mTask = gst_task_new (base_cv_algo_func, this, NULL);
-     }
-     gst_task_set_lock (mTask, &mMutex);
-     gst_task_set_enter_callback (mTask, algo_enter_thread, NULL, NULL);
-     gst_task_set_leave_callback (mTask, algo_leave_thread, NULL, NULL);
+    if(mCvdlType==CVDL_TYPE_DL)
+        base_hddl_algo_process(this, algoData);
+    else
+        base_cv_algo_process(this, algoData);
+    return true;
+}
+
+// put an algoData into the input queue, and wake up the stage task
+void CvdlAlgoBase::put_in_queue(CvdlAlgoData *algoData)
+{
+    mInQueue.put(algoData);
+    std::lock_guard<std::mutex> lk(mStageMutex);
+    if(mStageTask)
+        mStageTask->schedule();
 }
 
 int CvdlAlgoBase::set_data_caps(GstCaps *incaps)
@@ -422,16 +433,14 @@ int CvdlAlgoBase::set_data_caps(GstCaps *incaps)
 CvdlAlgoBase::~CvdlAlgoBase()
 {
     wait_work_done();
-    if(mTask) {
-        if((gst_task_get_state(mTask) == GST_TASK_STARTED) ||
-          (gst_task_get_state(mTask) == GST_TASK_PAUSED)) {
-                gst_task_set_state(mTask, GST_TASK_STOPPED);
-                mInQueue.flush();
-                gst_task_join(mTask);
-        }
-        gst_object_unref(mTask);
-        mTask = NULL;
-    }
+    mStageMutex.lock();
+    ExecutorTask *task = mStageTask;
+    mStageTask = NULL;
+    mStageMutex.unlock();
+    // it waits until the task is not running
+    delete task;
+    AlgoExecutor::release(mExecutor);
+    mExecutor = NULL;
     mInQueue.close();
     mPrev = NULL;
     for(int i=0;i<MAX_DOWN_STREAM_ALGO_NUM;i++)
@@ -442,8 +451,10 @@ CvdlAlgoBase::~CvdlAlgoBase()
     if(mObsoletedAlgoData)
         delete mObsoletedAlgoData;
     mObsoletedAlgoData=NULL;
+    if(mRecorder)
+        delete mRecorder;
+    mRecorder = NULL;
 
-    g_rec_mutex_clear(&mMutex);
     if(fpOclResult)
         fclose(fpOclResult);
     //gst_object_unref(mPool);
@@ -467,23 +478,188 @@ void CvdlAlgoBase::algo_connect_with_index(CvdlAlgoBase *algoTo, int index)
     algoTo->mPrev = this;
 }
 
+// index of the object which has the same joinIndex, -1 if object was created in a branch
+static int find_object(std::vector<ObjectData> &objectVec, const ObjectData &object)
+{
+    if(object.joinIndex < 0)
+        return -1;
+    for(size_t i = 0; i < objectVec.size(); i++) {
+        if(objectVec[i].joinIndex == object.joinIndex)
+            return i;
+    }
+    return -1;
+}
+
+// copy the fields which a branch changed since the branch point
+static void merge_object(ObjectData &merged, const ObjectData &object, const ObjectData &base)
+{
+    if(object.label != base.label || object.objectClass != base.objectClass) {
+        merged.label = object.label;
+        merged.objectClass = object.objectClass;
+        merged.prob = object.prob;
+    }
+    if(object.rect != base.rect || object.rectROI != base.rectROI) {
+        merged.rect = object.rect;
+        merged.rectROI = object.rectROI;
+    }
+    if(object.score != base.score)
+        merged.score = object.score;
+    if(object.trajectoryPoints.size() != base.trajectoryPoints.size())
+        merged.trajectoryPoints = object.trajectoryPoints;
+    merged.flags |= object.flags;
+}
+
+// put the processed algoData into next algo
+//   1. default, only put it into mNext[mOutputIndex]
+//   2. fan out, put it into all next algos, every branch gets a copy of this algoData
+//      with the same GstBuffer refcounted, and SinkAlgo will join them by frame.
+void CvdlAlgoBase::push_to_next(CvdlAlgoData *algoData)
+{
+    CvdlFrameJoin *join = NULL;
+    CvdlAlgoData *branchData = NULL;
+    int i, num = 0;
+
+    for(i=0;i<MAX_DOWN_STREAM_ALGO_NUM;i++)
+        if(mNext[i])
+            num++;
+
+    if(mLatencyStat)
+        record_latency(algoData);
+    if(mRecorder)
+        mRecorder->write(algoData);
+    algoData->mStageStart = g_get_monotonic_time();
+
+    if(!mFanOut || num<=1 || !mSinkAlgo) {
+        mNext[algoData->mOutputIndex]->put_in_queue(algoData);
+        return;
+    }
+
+    // If it has been in a branch, all sub branches share the same join
+    if(!algoData->mJoin)
+        algoData->mJoin = new CvdlFrameJoin(mSinkAlgo);
+    join = algoData->mJoin;
+    join->mMutex.lock();
+    join->mPending += num - 1;
+    // the objects are joined by their index at the branch point, not by id or geometry
+    for(auto &object : algoData->mObjectVec) {
+        if(object.joinIndex < 0)
+            object.joinIndex = join->mNextIndex++;
+        if(find_object(join->mBase, object) < 0)
+            join->mBase.push_back(object);
+    }
+    join->mMutex.unlock();
+
+    for(i=1;i<num;i++) {
+        branchData = new CvdlAlgoData(gst_buffer_ref(algoData->mGstBuffer));
+        branchData->mFrameId = algoData->mFrameId;
+        branchData->mPts = algoData->mPts;
+        branchData->mObjectVec = algoData->mObjectVec;
+        branchData->mStageStart = algoData->mStageStart;
+        branchData->mJoin = join;
+        GST_LOG("algo %d(%s) - fan out GstBuffer = %p(%d) to branch %d\n",
+            mAlgoType, mName.c_str(), branchData->mGstBuffer,
+            GST_MINI_OBJECT_REFCOUNT(branchData->mGstBuffer), i);
+        mNext[i]->put_in_queue(branchData);
+    }
+    mNext[0]->put_in_queue(algoData);
+}
+
+static CvdlAlgoData *frame_join_done(CvdlAlgoData *algoData, gboolean dropped, gboolean *done)
+{
+    CvdlFrameJoin *join = algoData->mJoin;
+    CvdlAlgoData *merged = NULL;
+    gboolean last = FALSE;
+
+    algoData->mJoin = NULL;
+    join->mMutex.lock();
+    if(!dropped) {
+        if(!join->mMerged) {
+            join->mMerged = algoData;
+        } else {
+            // objects of the branch points are taken once, new objects of every branch are added,
+            // so are the extra copies of a branch point object made in this branch
+            std::vector<ObjectData> &objectVec = join->mMerged->mObjectVec;
+            std::vector<bool> used(objectVec.size(), false);
+            for(auto &object : algoData->mObjectVec) {
+                int base = find_object(join->mBase, object);
+                int merged = base >= 0 ? find_object(objectVec, object) : -1;
+                if(merged >= 0 && !used[merged]) {
+                    used[merged] = true;
+                    merge_object(objectVec[merged], object, join->mBase[base]);
+                } else {
+                    objectVec.push_back(object);
+                }
+            }
+            gst_buffer_unref(algoData->mGstBuffer);
+            delete algoData;
+        }
+    }
+    join->mPending--;
+    if(join->mPending<=0) {
+        last = TRUE;
+        merged = join->mMerged;
+    }
+    join->mMutex.unlock();
+
+    if(last)
+        delete join;
+    if(done)
+        *done = last;
+    return merged;
+}
+
+void algo_data_leave_join(CvdlAlgoData *algoData)
+{
+    CvdlAlgoBase *sink = algoData->mJoin->mSink;
+    guint64 frameId = algoData->mFrameId;
+    gboolean done = FALSE;
+    CvdlAlgoData *merged = frame_join_done(algoData, TRUE, &done);
+
+    // the last branch was dropped, hand the merged result to SinkAlgo
+    if(merged)
+        sink->put_in_queue(merged);
+    else if(done)
+        sink->skip_frame(frameId);
+}
+
+CvdlAlgoData *algo_data_join(CvdlAlgoData *algoData)
+{
+    return frame_join_done(algoData, FALSE, NULL);
+}
+
 void CvdlAlgoBase::start_algo_thread()
 {
-    if(mTask)
-        gst_task_start(mTask);
+    if(mCvdlType == CVDL_TYPE_NONE)
+        return;
+
+    std::lock_guard<std::mutex> lk(mStageMutex);
+    // the placement may have been changed since the last start
+    if(mStageTask && mExecutor->get_key() != mPlacement.cpus()) {
+        delete mStageTask;
+        mStageTask = NULL;
+        AlgoExecutor::release(mExecutor);
+        mExecutor = NULL;
+    }
+    if(!mStageTask) {
+        // DL stages wait for OpenCL image processing, they run on the blocking workers
+        mExecutor = AlgoExecutor::acquire(mPlacement, mCvdlType == CVDL_TYPE_DL);
+        mStageTask = new ExecutorTask(mExecutor, [this]{ return run_stage(); });
+    }
+    mStageTask->start();
 }
 
 void CvdlAlgoBase::stop_algo_thread()
 {
-    if(mTask)
-        gst_task_set_state(mTask, GST_TASK_STOPPED);
+    mStageMutex.lock();
+    if(mStageTask)
+        mStageTask->stop();
+    mStageMutex.unlock();
+    mThreadId = 0;
 
     // remove all intem in the Queue
     clear_queue();
     mInQueue.flush();
     wait_work_done();
-    if(mTask)
-        gst_task_join(mTask);
 }
 
 void CvdlAlgoBase::clear_queue()
@@ -498,18 +674,71 @@ void CvdlAlgoBase::clear_queue()
     }
 }
 
-void CvdlAlgoBase::queue_buffer(GstBuffer *buffer, guint w, guint h)
+void CvdlAlgoBase::wait_work_done()
+{
+    // frames in input queue will not be processed
+    clear_queue();
+    // and the objects waiting for infer requests
+    mIeLoader.drop_jobs();
+
+    std::unique_lock<std::mutex> lk(mDoneMutex);
+    if(!mDoneCond.wait_for(lk, std::chrono::milliseconds(ALGO_WORK_DONE_TIMEOUT),
+                           [this]{ return mInferCnt <= 0; })) {
+        int value = mInferCnt;
+        g_print("warning: mInferCnt = %d in %s\n", value, mName.c_str() );
+    }
+    lk.unlock();
+    clear_queue();
+}
+
+void CvdlAlgoBase::notify_work_done()
+{
+    std::lock_guard<std::mutex> lk(mDoneMutex);
+    mDoneCond.notify_all();
+}
+
+gboolean CvdlAlgoBase::get_oldest_queued_age(gint64 *age)
+{
+    gint64 start = 0;
+    if(!mInQueue.peek_front([&start](CvdlAlgoData *algoData) { start = algoData->mStageStart; }))
+        return FALSE;
+    // EOS buffer has no start time
+    if(start == 0)
+        return FALSE;
+    *age = g_get_monotonic_time() - start;
+    return TRUE;
+}
+
+void CvdlAlgoBase::queue_buffer(GstBuffer *buffer, guint w, guint h, VideoRect *rois, int roiNum)
 {
     CvdlAlgoData *algoData = new CvdlAlgoData(buffer);
     algoData->mFrameId = mFrameIndex++;
+    algoData->mStageStart = g_get_monotonic_time();
     if(buffer)
         algoData->mPts = GST_BUFFER_TIMESTAMP (buffer);
 
-    ObjectData objData;
-    objData.rect = cv::Rect(0,0, w,h);
-    objData.rectROI =  cv::Rect(0,0, w,h);
-    algoData->mObjectVec.push_back(objData);
-    mInQueue.put(algoData);
+    if(!rois || roiNum<=0) {
+        ObjectData objData;
+        objData.rect = cv::Rect(0,0, w,h);
+        objData.rectROI =  cv::Rect(0,0, w,h);
+        algoData->mObjectVec.push_back(objData);
+    }
+    for(int i=0; rois && i<roiNum; i++) {
+        ObjectData objData;
+        objData.id = i;
+        objData.rect = cv::Rect(rois[i].x, rois[i].y, rois[i].width, rois[i].height);
+        objData.rectROI = objData.rect;
+        algoData->mObjectVec.push_back(objData);
+    }
+    put_in_queue(algoData);
+    GST_LOG("InQueue size = %d\n", mInQueue.size());
+}
+
+void CvdlAlgoBase::queue_algo_data(CvdlAlgoData *algoData)
+{
+    algoData->mFrameId = mFrameIndex++;
+    algoData->mStageStart = g_get_monotonic_time();
+    put_in_queue(algoData);
     GST_LOG("InQueue size = %d\n", mInQueue.size());
 }
 
@@ -520,9 +749,28 @@ void CvdlAlgoBase::queue_out_buffer(GstBuffer *buffer)
     if(buffer)
         algoData->mPts = GST_BUFFER_TIMESTAMP (buffer);
     
-    mInQueue.put(algoData);
+    put_in_queue(algoData);
     GST_LOG("InQueue size = %d\n", mInQueue.size());
 }
+
+GstFlowReturn CvdlAlgoBase::parse_inference_outputs(std::vector<IEOutput> &outputs,
+        CvdlAlgoData *outData, int objId)
+{
+    InferenceEngine::Blob::Ptr resultBlobPtr = IELoader::output_to_fp32(outputs[0]);
+    if(!resultBlobPtr)
+        return GST_FLOW_ERROR;
+    return parse_inference_result(resultBlobPtr, sizeof(float), outData, objId);
+}
+
+void CvdlAlgoBase::record_latency(CvdlAlgoData *algoData)
+{
+    // bounded, a benchmark run does not need more samples than this
+    const static size_t maxSamples = 1 << 20;
+    std::lock_guard<std::mutex> lk(mLatencyMutex);
+    if(mLatency.size() < maxSamples)
+        mLatency.push_back(g_get_monotonic_time() - algoData->mStageStart);
+}
+
 int CvdlAlgoBase::get_in_queue_size()
 {
     return mInQueue.size();
@@ -541,9 +789,9 @@ GstFlowReturn CvdlAlgoBase::init_ieloader(const char* modeFileName, guint ieType
         return ret;
     mIeInited = true;
 
-    ret = mIeLoader.set_device(InferenceEngine::TargetDevice::eHDDL);
+    ret = mIeLoader.set_device(mTargetDevice);
     if(ret != GST_FLOW_OK){
-        g_print("IE failed to set device be eHDDL!\n");
+        g_print("IE failed to set device be %d!\n", (int)mTargetDevice);
         return GST_FLOW_ERROR;
     }
     // Load different Model based on different device.
@@ -551,6 +799,8 @@ GstFlowReturn CvdlAlgoBase::init_ieloader(const char* modeFileName, guint ieType
     std::string tmpFn = strModelXml.substr(0, strModelXml.rfind("."));
     std::string strModelBin = tmpFn + ".bin";
     g_print("Algo %s(%d): Model bin = %s\n", mName.c_str(), mAlgoType, strModelBin.c_str());
+    if(element)
+        mIeLoader.set_stream_name(std::string(GST_ELEMENT_NAME(element)) + "." + mName);
     ret = mIeLoader.read_model(strModelXml, strModelBin, ieType, network_config);
     
     if(ret != GST_FLOW_OK){
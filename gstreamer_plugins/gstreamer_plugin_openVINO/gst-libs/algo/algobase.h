@@ -26,17 +26,70 @@
 #include <inference_engine.hpp>
 #include <atomic>
 #include <vector>
+#include <memory>
+#include <cstring>
+#include <condition_variable>
 #include <interface/videodefs.h>
 #include "imageproc.h"
 #include <ocl/oclmemory.h>
+#include <ocl/metadata.h>
 #include "ieloader.h"
+#include "algoplacement.h"
+#include "algoexecutor.h"
 #include "private.h"
 
+// Label of an object. A class name of the model is interned as an id in the
+// process-wide label table, other text such as a plate number is owned by the
+// object and shared by its copies, so that objects are copied between algo
+// stages without copying strings.
+class ObjectLabel{
+public:
+    ObjectLabel() : mId(CVDL_LABEL_NONE) {};
+    // free text label
+    ObjectLabel(const char *label) : mId(CVDL_LABEL_NONE) { set_text(label); };
+    ObjectLabel(const std::string &label) : mId(CVDL_LABEL_NONE) { set_text(label.c_str()); };
+
+    // label of a fixed class vocabulary, never pass free text to it
+    static ObjectLabel intern(const char *label)
+    {
+        ObjectLabel objLabel;
+        objLabel.mId = cvdl_label_intern(label);
+        return objLabel;
+    }
+
+    // CVDL_LABEL_NONE for a free text label
+    int id() const { return mId; }
+    // it is valid as long as this label or a copy of it is alive
+    const char *c_str() const { return mText ? mText->c_str() : cvdl_label_name(mId); }
+    std::string str() const { return std::string(c_str()); }
+    size_t size() const { return mText ? mText->size() : strlen(c_str()); }
+    // 0 if they are the same label
+    int compare(const char *label) const { return strcmp(c_str(), label); }
+    int compare(const ObjectLabel &label) const
+    {
+        if(!mText && !label.mText)
+            return mId - label.mId;
+        return strcmp(c_str(), label.c_str());
+    }
+    bool operator==(const ObjectLabel &label) const { return compare(label) == 0; }
+    bool operator!=(const ObjectLabel &label) const { return compare(label) != 0; }
+
+private:
+    void set_text(const char *label)
+    {
+        if(label && label[0])
+            mText = std::make_shared<const std::string>(label);
+    }
+
+    int mId;
+    std::shared_ptr<const std::string> mText;
+};
+
 class ObjectData{
 public:
     ObjectData() : id(-1), objectClass(-1), prob(0.0), 
                  flags(0), score(0.0), oclBuf(NULL), mAuxData(NULL),
-                 mAuxDataLen(0){};
+                 mAuxDataLen(0), joinIndex(-1){};
     ~ObjectData()
    {
         trajectoryPoints.clear();
@@ -44,7 +97,7 @@ public:
     int id;
     int objectClass;
     float prob;
-    std::string label;
+    ObjectLabel label;
     // It is based on the orignal video frame
     cv::Rect rect;  // rect of detection
     cv::Rect rectROI; // rect to be classified
@@ -68,6 +121,10 @@ public:
     void *mAuxData;
     gint mAuxDataLen;
 
+    // index of this object at the branch points of its frame, which the branches are
+    // joined by, -1 if it was created in a branch
+    int joinIndex;
+
     float figure_score(int w, int h) {
         float score = 0.0;
         int dx, dy;
@@ -85,18 +142,44 @@ public:
 
 class CvdlAlgoBase;
 class CvdlAlgoData;
+class AlgoRecorder;
 using PostCallback = std::function<void(CvdlAlgoData* algoData)>;
 
+// Join point of a frame which has been put into multiple algo branches.
+// It is shared by all branch copies of the same frame, and the last branch
+// which is done hands the merged algoData to SinkAlgo.
+class CvdlFrameJoin{
+public:
+    CvdlFrameJoin(CvdlAlgoBase *sink) : mSink(sink), mPending(1), mMerged(NULL), mNextIndex(0) {}
+    CvdlAlgoBase *mSink;
+    std::mutex mMutex;
+    // branch copies not done yet
+    int mPending;
+    // the first arrived branch, other branches' objects are merged into it
+    CvdlAlgoData *mMerged;
+    // objects at the branch points, they are taken once from all branches
+    std::vector<ObjectData> mBase;
+    // joinIndex of the next object added to mBase
+    int mNextIndex;
+};
+
+// Drop a branch copy from its join, it must be called before the algoData is freed
+void algo_data_leave_join(CvdlAlgoData *algoData);
+// A branch copy arrives SinkAlgo, return the merged algoData if all branches are done
+CvdlAlgoData *algo_data_join(CvdlAlgoData *algoData);
+
 class CvdlAlgoData{
 public:
     CvdlAlgoData(): mGstBuffer(NULL) ,mFrameId(0), mPts(0),mOutputIndex(0),  mAllObjectDone(true),
-                                                mGstBufferOcl(NULL), algoBase(NULL), ie_start(0), ie_duration(0)
+                                                mGstBufferOcl(NULL), algoBase(NULL), ie_start(0), ie_duration(0),
+                                                mStageStart(0), mJoin(NULL), mDropped(FALSE)
     {
         mObjectVec.clear();
         mObjectVecIn.clear();
     }
     CvdlAlgoData(GstBuffer *buf) : mGstBuffer(buf), mFrameId(0), mPts(0),mOutputIndex(0), mAllObjectDone(true),
-                                                mGstBufferOcl(NULL), algoBase(NULL), ie_start(0), ie_duration(0)
+                                                mGstBufferOcl(NULL), algoBase(NULL), ie_start(0), ie_duration(0),
+                                                mStageStart(0), mJoin(NULL), mDropped(FALSE)
     {
         if(buf){
             //gst_buffer_ref(buf);
@@ -108,6 +191,9 @@ public:
         if(mGstBuffer){
             //gst_buffer_unref(mGstBuffer);
         }
+        // a dropped branch copy will not arrive SinkAlgo
+        if(mJoin)
+            algo_data_leave_join(this);
         mObjectVec.clear();
         mObjectVecIn.clear();
     }
@@ -133,6 +219,14 @@ public:
     CvdlAlgoBase* algoBase;
     gint64 ie_start;
     gint64 ie_duration;
+    // when it was put into the input queue of current algo
+    gint64 mStageStart;
+
+    // Not NULL if this frame has been put into multiple algo branches
+    CvdlFrameJoin *mJoin;
+
+    // an inference of its objects was dropped, it will not be put into next algo
+    gboolean mDropped;
 };
 
 
@@ -144,26 +238,26 @@ public:
 
     void algo_connect(CvdlAlgoBase *algoTo);
     void algo_connect_with_index(CvdlAlgoBase *algoTo, int index);
-    void queue_buffer(GstBuffer *buffer, guint w, guint h);
+    // rois - objects to be processed by the first algo, default is the whole frame
+    void queue_buffer(GstBuffer *buffer, guint w, guint h, VideoRect *rois=NULL, int roiNum=0);
     void queue_out_buffer(GstBuffer *buffer);
+    // put an algoData with objects into this algo, such as a replayed record
+    void queue_algo_data(CvdlAlgoData *algoData);
+    void push_to_next(CvdlAlgoData *algoData);
+    // put an algoData into the input queue of this algo
+    void put_in_queue(CvdlAlgoData *algoData);
+    // process one frame of the input queue, return false if there is no frame
+    bool run_stage();
     void start_algo_thread();
     void stop_algo_thread();
 
     void clear_queue();
-    void wait_work_done() {
-         // wait IE infer thread finished
-         int times = 100;
-         while((mInferCnt>0) ||(mInQueue.size()>0)) {
-            g_usleep(100000);//100ms
-            clear_queue();
-            if(times--<=0) 
-           {
-                int value = mInferCnt;
-                g_print("warning: mInferCnt = %d in %s\n", value, mName.c_str() );
-                break;
-            }
-         }
-    }
+    // wait until all inferences of this algo are done, it is woken up by notify_work_done()
+    void wait_work_done();
+    // mInferCnt has been decreased
+    void notify_work_done();
+    // age(us) of the oldest frame in the input queue, return FALSE if the queue is empty
+    gboolean get_oldest_queued_age(gint64 *age);
     int get_in_queue_size();
     int get_out_queue_size();
 
@@ -181,15 +275,26 @@ public:
     {
         return GST_FLOW_OK;
     }
+    // all outputs of an inference, a multi-head network is parsed in one pass by
+    // overriding it, the default parses the first output as FP32 by parse_inference_result()
+    virtual GstFlowReturn parse_inference_outputs(std::vector<IEOutput> &outputs,
+        CvdlAlgoData *outData, int objId);
 
     // dequeue a processed buffer with metaData, which is only used for the last algo in the algo pipeline
-    virtual GstBuffer* dequeue_buffer()
+    // *eos is set to TRUE when the EOS buffer of algo_pipeline_flush_buffer() is got
+    virtual GstBuffer* dequeue_buffer(gboolean *eos)
     {
         return NULL;
     }
+    // a frame was dropped by an upstream algo, which is only used for the last algo
+    virtual void skip_frame(guint64 frameId)
+    {
+    }
     void save_buffer(unsigned char *buf, int w, int h, int p, int id, int bPlannar,const char *info);
     void save_image(unsigned char *buf, int w, int h, int p, int bPlannar, char *info);
     void print_objects(std::vector<ObjectData> &objectVec);
+    // record the latency of a frame in this algo, from its input queue to next algo
+    void record_latency(CvdlAlgoData *algoData);
 
 private:
         //It's not expected that class instances are copied, the operator= should be declared as private.
@@ -209,12 +314,22 @@ public:
     //  CV task - run without IE inference enngine
     guint mCvdlType;// DL or CV task
 
-    /* Main task/thread to do the algo processing */
-    GstTask *mTask;
-    GRecMutex mMutex;
+    /* Shared workers to do the algo processing, the stage task of this algo runs on them */
+    AlgoExecutor *mExecutor;
+    ExecutorTask *mStageTask;
+    // upstream algos schedule the stage task while it may be replaced
+    std::mutex mStageMutex;
+    // CPUs of the executor workers and the inference callbacks, set before the algo starts
+    AlgoPlacement mPlacement;
+    // thread id of the worker which ran the algo last, 0 if it is not running
+    std::atomic<int> mThreadId;
+    // CPU which the algo got its last frame on, -1 if unknown
+    std::atomic<int> mLastCpu;
 
     IELoader mIeLoader;
     gboolean mIeInited;
+    // device to run inference, default is HDDL
+    InferenceEngine::TargetDevice mTargetDevice;
     ImageProcessor mImageProcessor;
 
     /* The image size into the actual algo processing */
@@ -234,6 +349,12 @@ public:
     CvdlAlgoBase *mNext[MAX_DOWN_STREAM_ALGO_NUM];
     CvdlAlgoBase *mPrev;
 
+    // put every output frame into all next algos, which will run in parallel,
+    // instead of only putting it into mNext[mOutputIndex]
+    gboolean mFanOut;
+    // the SinkAlgo of this algo pipeline, it joins the branches of a frame
+    CvdlAlgoBase *mSinkAlgo;
+
     // queue input buffer
     thread_queue<CvdlAlgoData *> mInQueue;
 
@@ -249,6 +370,10 @@ public:
 
     std::atomic<int> mInferCnt;
     std::atomic<guint64> mInferCntTotal;
+    std::mutex mDoneMutex;
+    std::condition_variable mDoneCond;
+    // heartbeat, when the last frame was got from the input queue
+    std::atomic<gint64> mLastDequeue;
 
     // mutex for multiple objects sync
     std::mutex mAlgoDataMutex;
@@ -258,6 +383,14 @@ public:
     gint64 mImageProcCost; /* in microseconds */
     gint64 mInferCost; /* in microseconds */
 
+    // latency samples in microseconds, only recorded if mLatencyStat is set
+    gboolean mLatencyStat;
+    std::mutex mLatencyMutex;
+    std::vector<gint64> mLatency;
+
+    // record the output of this algo if it is not NULL
+    AlgoRecorder *mRecorder;
+
     int mFrameIndexLast;
     // It was used to generate object id
     gint mObjIndex;
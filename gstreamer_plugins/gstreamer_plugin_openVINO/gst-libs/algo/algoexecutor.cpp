@@ -0,0 +1,284 @@
+/*
+ *Copyright (C) 2018 Intel Corporation
+ *
+ *SPDX-License-Identifier: LGPL-2.1-only
+ *
+ *This library is free software; you can redistribute it and/or modify it under the terms
+ * of the GNU Lesser General Public License as published by the Free Software Foundation;
+ * version 2.1.
+ *
+ *This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this library;
+ * if not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "algoexecutor.h"
+#include <algorithm>
+#include <chrono>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <gst/gstinfo.h>
+
+std::mutex AlgoExecutor::sMutex;
+std::map<std::string, AlgoExecutor *> AlgoExecutor::sExecutors;
+
+// the executor and worker of the calling thread
+static thread_local AlgoExecutor *tExecutor = NULL;
+static thread_local int tWorkerIndex = -1;
+static thread_local int tThreadId = 0;
+// the task which the calling worker is running
+static thread_local ExecutorTask *tTask = NULL;
+
+ExecutorTask::ExecutorTask(AlgoExecutor *executor, std::function<bool()> func)
+    : mExecutor(executor), mFunc(func), mQueued(false), mRunning(false), mRerun(false),
+      mStopped(true)
+{
+}
+
+ExecutorTask::~ExecutorTask()
+{
+    stop();
+}
+
+void ExecutorTask::schedule()
+{
+    std::unique_lock<std::mutex> lk(mMutex);
+    if(mStopped || mQueued)
+        return;
+    if(mRunning) {
+        mRerun = true;
+        return;
+    }
+    mQueued = true;
+    lk.unlock();
+    mExecutor->submit(this, false);
+}
+
+void ExecutorTask::start()
+{
+    std::unique_lock<std::mutex> lk(mMutex);
+    mStopped = false;
+    if(mQueued || mRunning)
+        return;
+    // the input put before start
+    mQueued = true;
+    lk.unlock();
+    mExecutor->submit(this, false);
+}
+
+void ExecutorTask::stop()
+{
+    std::unique_lock<std::mutex> lk(mMutex);
+    mStopped = true;
+    // stopped by its own func, run() doesn't queue it again
+    if(tTask == this)
+        return;
+    // a queued task is dropped when a worker gets it, or it is removed from the queue
+    // here, as the calling thread may be the only worker which could get it
+    while(mQueued || mRunning) {
+        if(mQueued && mExecutor->cancel(this)) {
+            mQueued = false;
+            break;
+        }
+        mCond.wait_for(lk, std::chrono::milliseconds(10));
+    }
+}
+
+void ExecutorTask::run()
+{
+    std::unique_lock<std::mutex> lk(mMutex);
+    mQueued = false;
+    if(mStopped) {
+        mCond.notify_all();
+        return;
+    }
+    mRunning = true;
+    mRerun = false;
+    lk.unlock();
+
+    bool more = true;
+    tTask = this;
+    for(int i=0; i<EXECUTOR_TASK_BATCH && more; i++) {
+        more = mFunc();
+        // it may have been stopped by its func
+        lk.lock();
+        more = more && !mStopped;
+        lk.unlock();
+    }
+    tTask = NULL;
+
+    lk.lock();
+    mRunning = false;
+    if(!mStopped && (more || mRerun)) {
+        mQueued = true;
+        lk.unlock();
+        // behind the other tasks of this worker
+        mExecutor->submit(this, true);
+        return;
+    }
+    mCond.notify_all();
+}
+
+AlgoExecutor::AlgoExecutor(const AlgoPlacement &placement, bool blocking, int workerNum)
+    : mPlacement(placement), mKey(placement.cpus()), mBlocking(blocking), mRefCount(1), mQueuedNum(0),
+      mNextWorker(0), mStop(false)
+{
+    for(int i=0; i<workerNum; i++)
+        mWorkers.push_back(new Worker);
+    for(int i=0; i<workerNum; i++)
+        mWorkers[i]->thread = std::thread(&AlgoExecutor::worker_func, this, i);
+}
+
+AlgoExecutor::~AlgoExecutor()
+{
+    std::unique_lock<std::mutex> lk(mMutex);
+    mStop = true;
+    mCond.notify_all();
+    lk.unlock();
+
+    for(auto worker : mWorkers) {
+        worker->thread.join();
+        delete worker;
+    }
+    mWorkers.clear();
+}
+
+std::string AlgoExecutor::map_key(const std::string &cpus, bool blocking)
+{
+    return blocking ? cpus + "/blocking" : cpus;
+}
+
+AlgoExecutor *AlgoExecutor::acquire(const AlgoPlacement &placement, bool blocking)
+{
+    std::lock_guard<std::mutex> lk(sMutex);
+    auto it = sExecutors.find(map_key(placement.cpus(), blocking));
+    if(it != sExecutors.end()) {
+        it->second->mRefCount++;
+        return it->second;
+    }
+
+    int workerNum = placement.is_set() ? placement.cpu_count() : (int)g_get_num_processors();
+    const gchar *env = g_getenv("HDDLS_CVDL_WORKERS");
+    if(env && atoi(env) > 0)
+        workerNum = MIN(workerNum, atoi(env));
+    workerNum = MAX(workerNum, 1);
+
+    AlgoExecutor *executor = new AlgoExecutor(placement, blocking, workerNum);
+    sExecutors[map_key(executor->mKey, blocking)] = executor;
+    GST_INFO("AlgoExecutor: %d %sworkers on CPUs %s", workerNum, blocking ? "blocking " : "",
+        placement.is_set() ? placement.cpus().c_str() : "all");
+    return executor;
+}
+
+void AlgoExecutor::release(AlgoExecutor *executor)
+{
+    if(!executor)
+        return;
+
+    std::unique_lock<std::mutex> lk(sMutex);
+    if(--executor->mRefCount > 0)
+        return;
+    sExecutors.erase(map_key(executor->mKey, executor->mBlocking));
+    lk.unlock();
+
+    // a worker cannot join itself
+    if(tExecutor == executor) {
+        std::thread([executor]{ delete executor; }).detach();
+        return;
+    }
+    delete executor;
+}
+
+int AlgoExecutor::current_thread_id()
+{
+    return tThreadId;
+}
+
+void AlgoExecutor::submit(ExecutorTask *task, bool yield)
+{
+    Worker *worker = NULL;
+
+    if(tExecutor == this) {
+        worker = mWorkers[tWorkerIndex];
+    } else {
+        std::lock_guard<std::mutex> lk(mMutex);
+        worker = mWorkers[mNextWorker++ % mWorkers.size()];
+    }
+
+    worker->mutex.lock();
+    if(yield)
+        worker->tasks.push_front(task);
+    else
+        worker->tasks.push_back(task);
+    worker->mutex.unlock();
+
+    std::lock_guard<std::mutex> lk(mMutex);
+    mQueuedNum++;
+    mCond.notify_one();
+}
+
+bool AlgoExecutor::cancel(ExecutorTask *task)
+{
+    for(auto worker : mWorkers) {
+        std::lock_guard<std::mutex> lk(worker->mutex);
+        auto it = std::find(worker->tasks.begin(), worker->tasks.end(), task);
+        if(it == worker->tasks.end())
+            continue;
+        worker->tasks.erase(it);
+        std::lock_guard<std::mutex> lkQueued(mMutex);
+        mQueuedNum--;
+        return true;
+    }
+    return false;
+}
+
+// the newest task of its own queue, or the oldest task of other workers
+ExecutorTask *AlgoExecutor::pop_task(int index)
+{
+    ExecutorTask *task = NULL;
+    size_t num = mWorkers.size();
+
+    for(size_t i=0; i<num && !task; i++) {
+        Worker *worker = mWorkers[(index + i) % num];
+        std::lock_guard<std::mutex> lk(worker->mutex);
+        if(worker->tasks.empty())
+            continue;
+        if(i == 0) {
+            task = worker->tasks.back();
+            worker->tasks.pop_back();
+        } else {
+            task = worker->tasks.front();
+            worker->tasks.pop_front();
+        }
+    }
+    if(task) {
+        std::lock_guard<std::mutex> lk(mMutex);
+        mQueuedNum--;
+    }
+    return task;
+}
+
+void AlgoExecutor::worker_func(int index)
+{
+    tExecutor = this;
+    tWorkerIndex = index;
+    tThreadId = (int)syscall(SYS_gettid);
+    mPlacement.apply();
+
+    while(true) {
+        ExecutorTask *task = pop_task(index);
+        if(task) {
+            task->run();
+            continue;
+        }
+        std::unique_lock<std::mutex> lk(mMutex);
+        mCond.wait(lk, [this]{ return mStop || mQueuedNum > 0; });
+        if(mStop && mQueuedNum <= 0)
+            break;
+    }
+    tExecutor = NULL;
+}
@@ -0,0 +1,129 @@
+/*
+ *Copyright (C) 2018 Intel Corporation
+ *
+ *SPDX-License-Identifier: LGPL-2.1-only
+ *
+ *This library is free software; you can redistribute it and/or modify it under the terms
+ * of the GNU Lesser General Public License as published by the Free Software Foundation;
+ * version 2.1.
+ *
+ *This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this library;
+ * if not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef __ALGO_EXECUTOR_H__
+#define __ALGO_EXECUTOR_H__
+
+#include <string>
+#include <map>
+#include <deque>
+#include <vector>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <functional>
+#include <condition_variable>
+#include "algoplacement.h"
+
+// max runs of a task before it yields its worker to other tasks
+#define EXECUTOR_TASK_BATCH 8
+
+class AlgoExecutor;
+
+// A serial task of AlgoExecutor, such as an algo stage. It is scheduled when it
+// has input, and it is run by only one worker at a time, so that its input is
+// processed in order.
+class ExecutorTask {
+public:
+    // func processes one input, and returns false if there was no input
+    ExecutorTask(AlgoExecutor *executor, std::function<bool()> func);
+    ~ExecutorTask();
+
+    // there is new input
+    void schedule();
+    // it can be scheduled again, the pending input will be processed
+    void start();
+    // wait until it is not running, and it will not run until start().
+    // Called by its own func, it returns at once and the task stops after func returns,
+    // the task must not be deleted by its own func.
+    void stop();
+
+private:
+    friend class AlgoExecutor;
+    // called by a worker
+    void run();
+
+    AlgoExecutor *mExecutor;
+    std::function<bool()> mFunc;
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    // in the queue of a worker
+    bool mQueued;
+    bool mRunning;
+    // scheduled while running, run it again
+    bool mRerun;
+    bool mStopped;
+};
+
+// Workers shared by the algo stages of all algo pipelines with the same placement,
+// so that the number of threads doesn't grow with pipelines and stages.
+// Stages which wait for devices, e.g. OpenCL image processing and infer requests,
+// run on a separate blocking executor, so that they don't starve CPU-bound stages.
+//
+// Every worker has a task queue. A task scheduled by a worker is put into its own
+// queue, e.g. the next algo of a frame runs on the same worker with hot caches, and
+// other tasks are put into the queues round robin. A worker runs the newest task of
+// its own queue, and steals the oldest task of others when its queue is empty.
+class AlgoExecutor {
+public:
+    // Get the executor of placement, it is created if it doesn't exist.
+    // The number of workers is the CPU number of placement, or $HDDLS_CVDL_WORKERS if it is less.
+    static AlgoExecutor *acquire(const AlgoPlacement &placement, bool blocking = false);
+    // the last release by its own worker destroys it in another thread
+    static void release(AlgoExecutor *executor);
+    // thread id of the calling worker, 0 if it is not a worker
+    static int current_thread_id();
+
+    // yield: put it behind the other tasks of the calling worker
+    void submit(ExecutorTask *task, bool yield);
+    // remove a queued task, return false if it is not in the queues
+    bool cancel(ExecutorTask *task);
+    int get_worker_num() { return (int)mWorkers.size(); }
+    // CPU list of its placement, "" if not pinned
+    const std::string &get_key() { return mKey; }
+
+private:
+    AlgoExecutor(const AlgoPlacement &placement, bool blocking, int workerNum);
+    static std::string map_key(const std::string &cpus, bool blocking);
+    ~AlgoExecutor();
+    void worker_func(int index);
+    ExecutorTask *pop_task(int index);
+
+    struct Worker {
+        std::mutex mutex;
+        std::deque<ExecutorTask *> tasks;
+        std::thread thread;
+    };
+
+    AlgoPlacement mPlacement;
+    std::string mKey;
+    bool mBlocking;
+    int mRefCount;
+    std::vector<Worker *> mWorkers;
+
+    // idle workers wait for queued tasks
+    std::mutex mMutex;
+    std::condition_variable mCond;
+    int mQueuedNum;
+    unsigned int mNextWorker;
+    bool mStop;
+
+    static std::mutex sMutex;
+    static std::map<std::string, AlgoExecutor *> sExecutors;
+};
+
+#endif
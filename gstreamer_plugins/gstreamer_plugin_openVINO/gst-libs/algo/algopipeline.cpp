@@ -31,12 +31,11 @@
 #include "reidalgo.h"
 #include "genericalgo.h"
 #include "sinkalgo.h"
+#include "algorecord.h"
 #include "algopipeline.h"
 
 using namespace std;
 
-#define TEST_STR_FUNC 1
-
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -117,7 +116,6 @@ static CvdlAlgoBase* algo_create(GstElement *element, int type)
    return algo;
 }
 
-//Improvement need: support one algo link to multiple algos,  specified the algo's src pad
 static void algo_item_link(AlgoItem* from, AlgoItem* to, int index)
 {
     CvdlAlgoBase *algoFrom, *algoTo;
@@ -153,38 +151,13 @@ static void algo_item_link_sink(AlgoItem *preItem[], int num, AlgoItem *sinkItem
     return;
 }
 
-static int get_str_count(gchar *str, const gchar *token, int len)
+static std::string algo_desc_strip(const std::string &str)
 {
-    int count = 0;
-    if(!str || !token || !len)
-        return 0;
-
-    // In str, find the occurrence times of this token
-    std::string str_buf = std::string(str);
-    size_t pos = str_buf.find(token, 0);
-
-    while(pos != std::string::npos ) {
-         count++;
-         pos = str_buf.find(token, pos+1);
-     }
-
-#if  TEST_STR_FUNC
-   int count_2 = 0;
-   gchar *p = str;
-
-    p=g_strstr_len(p,len,token);
-    while(p){
-        count_2++;
-        p++;
-        p=g_strstr_len(p,len,token);
-    }
-    if(count != count_2) {
-        g_print("%s() - get incorrent result!\n", __func__);
-        exit(1);
-     }
- #endif
-
-    return count;
+    size_t first = str.find_first_not_of(" \t");
+    size_t last = str.find_last_not_of(" \t");
+    if(first == std::string::npos)
+        return std::string("");
+    return str.substr(first, last - first + 1);
 }
 
 void algo_pipeline_config_destroy(AlgoPipelineConfig *config)
@@ -198,13 +171,17 @@ void algo_pipeline_config_destroy(AlgoPipelineConfig *config)
 // The format is like:
 //  case 1.   "yolov1tiny ! opticalflowtrack ! googlenetv2"
 //  case 2.   "detection ! track name=tk ! tk.vehicle_classification  ! tk.person_face_detection ! face_recognication"
+//
+// In case 2, "name=tk" makes track be a branch point, every item with "tk." prefix is a branch of it.
+// The branches run in parallel, and their outputs are joined by frame in SinkAlgo.
 AlgoPipelineConfig *algo_pipeline_config_create(gchar *desc, int *num, GstElement *element)
 {
     AlgoPipelineConfig *config = NULL;
-    gchar *p = desc, *pDot, *pName, *pParentName, *descStrip;
-    gchar **items = NULL;// **names;
-    int count = 0, i, j, index, len,  out_index = 1;// nameNum = 0, nameIndex = 0;
-    //gboolean newSubBranch = FALSE;
+    gchar *descStrip;
+    gchar **items = NULL;
+    int count = 0, i, j, index, out_index = 1;
+    size_t pos;
+    bool error = false;
     if(!desc)
         return NULL;
 
@@ -212,144 +189,131 @@ AlgoPipelineConfig *algo_pipeline_config_create(gchar *desc, int *num, GstElemen
     register_init();
     register_dump();
 
-    //Improvement need: need to support case 2 better
-
     GST_INFO("algo pipeline congig description: %s\n", desc);
     // delete the blank char
     descStrip = g_strstrip(desc);
-    p = descStrip;
-    items = g_strsplit(p, "!", 6);/* 6 items at most */
-
-    //nameNum = get_str_count(p, "name=");
-    //if(nameNum > 0) {
-    //    names = g_new0(gchar *, nameNum);
-    //}
+    items = g_strsplit(descStrip, "!", -1);
 
     count = g_strv_length(items);
     if(count==0){
-        g_print("Invalid algo pipeline description: %s\n",p);
+        g_print("Invalid algo pipeline description: %s\n", descStrip);
+        g_strfreev(items);
         return NULL;
     }
-    for(i=0;i<count;i++)
-        items[i] = g_strstrip(items[i]);
 
-    std::string temp;
-    config = g_new0 (AlgoPipelineConfig, count);
+    // split every item into "<parent branch>.<algo name> name=<branch>"
+    std::vector<std::string> algoNames(count), branchNames(count), parentNames(count);
     for(i=0;i<count;i++) {
+        std::string item = algo_desc_strip(std::string(items[i]));
+        pos = item.find("name=");
+        if(pos != std::string::npos) {
+            branchNames[i] = algo_desc_strip(item.substr(pos + 5));
+            item = item.substr(0, pos);
+        }
+        pos = item.find(".");
+        if(pos != std::string::npos) {
+            parentNames[i] = algo_desc_strip(item.substr(0, pos));
+            item = item.substr(pos + 1);
+        }
+        algoNames[i] = algo_desc_strip(item);
+    }
+    g_strfreev(items);
+
+    std::ostringstream data_str;
+    config = g_new0 (AlgoPipelineConfig, count);
+    for(i=0;i<count && !error;i++) {
         // get curId
         config[i].curId = i;
-        p = items[i];
-
-        // get nextNum
-        temp = std::string(p);
-        pName = g_strstr_len(p, temp.size(),"name=");
-        if(pName) {
-            // get branch algo name list
-            //names[nameIndex++] = g_strndup(pName+5,g_strlen(pName+5));
-            temp = std::string(descStrip);
-            config[i].nextNum = get_str_count(descStrip, pName+5, temp.size()) - 1;
-            // set nextId
-            index = 0;
-            pName = pName + 5;
-            for(j=0;j<count;j++) {
-                //temp = std::string(items[j]);
-                temp = std::string(pName);
-                //if(!strcmp_s(items[j],strnlen_s(pName, 32), pName, &indicator))
-                if(!temp.compare(0, temp.size(), items[j] ))
-                    config[i].nextId[index++] = j;
-            }
-        } else {
-            config[i].nextNum = 1;
-            // next is the end or other sub branch, set -1
-            if(i==count-1) {
-                config[i].nextId[0] = -1 * out_index;
-                out_index ++;
-            } else {
-                temp = std::string(items[i+1]);
-                if(g_strstr_len(items[i+1],temp.size(), ".")) {
-                    config[i].nextId[0] = -1 * out_index;
-                    out_index ++;
-                } else
-                    config[i].nextId[0] = i+1;
-            }
-        }
 
         // set preId
-        // get parent branch name
-        temp = std::string(items[i]);
-        pDot = g_strstr_len(p, temp.size(),".");
-        if(pDot) {
-            // It is a sub branch
-            pName = p;
-            p = pDot + 1;
-            len = pDot - pName;
-            // find parent branch id
-            for(j=0;j<count;j++) {
-                temp = std::string(items[j]);
-                pParentName = g_strstr_len(items[j], temp.size(),"name=");
-                if(!pParentName)
-                    continue;
-                temp = std::string(pParentName+5);
-                //if(!strcmp_s(pParentName+5,len , pName, &indicator)) {
-                if(!temp.compare(0, len, pName)) {
+        if(!parentNames[i].empty()) {
+            // It is a sub branch, find parent branch id
+            config[i].preId = -1;
+            for(j=0;j<i;j++) {
+                if(!branchNames[j].compare(parentNames[i])) {
                     config[i].preId = j;
                     break;
                 }
             }
+            if(config[i].preId == -1) {
+                data_str  << "Cannot find algo branch: " << parentNames[i] << std::endl;
+                error = true;
+                break;
+            }
         } else {
-            if(i==0) {
-                config[i].preId = -1;
-            } else {
-                config[i].preId = i - 1;
+            config[i].preId = (i==0) ? -1 : i - 1;
+        }
+
+        // set nextId: the next item if it is not a sub branch, and all sub branches of this item
+        index = 0;
+        if(i+1<count && parentNames[i+1].empty())
+            config[i].nextId[index++] = i + 1;
+        if(!branchNames[i].empty()) {
+            for(j=i+1;j<count;j++) {
+                if(parentNames[j].compare(branchNames[i]))
+                    continue;
+                if(index>=MAX_DOWN_STREAM_ALGO_NUM) {
+                    data_str  << "Too many branches for algo: " << algoNames[i] << std::endl;
+                    error = true;
+                    break;
+                }
+                config[i].nextId[index++] = j;
             }
+            config[i].fanOut = (index > 1);
         }
+        // next is the end of a branch, set -1, -2 ...
+        if(index==0) {
+            config[i].nextId[index++] = -1 * out_index;
+            out_index ++;
+        }
+        config[i].nextNum = index;
 
         // get algo type
- #if 1
-        config[i].curType = register_get_algo_id(p);
+        config[i].curType = register_get_algo_id(algoNames[i].c_str());
         if(config[i].curType==-1) {
-            //g_print("error: not support this algo = %s\n", p);
             register_dump();
-            std::ostringstream data_str;
-            data_str  << "Not support this algo = " << p << std::endl;
-            std::string error_info = data_str.str();
-            g_print("%s", error_info.c_str());
-            pipeline_report_error_info(element,error_info.c_str());
-            algo_pipeline_config_destroy(config);
-            config = NULL;
-            break;
-            //exit(1);
+            data_str  << "Not support this algo = " << algoNames[i] << std::endl;
+            error = true;
        }
-#else
-        for(n=0;n<ALGO_MAX_DEFAULT_NUM-1;n++) {
-            if(strlen(p) != strlen(g_algo_name_str[n]))
-                continue;
-            if(!strncmp(p, g_algo_name_str[n], strlen(g_algo_name_str[n]))) {
-                config[i].curType = n;
-                break;
-            }
-         }
-#endif
+    }
+
+    if(!error && out_index-1 > MAX_PIPELINE_OUT_NUM) {
+        data_str  << "Too many algo branches: " << out_index-1 << ", max = "
+                  << MAX_PIPELINE_OUT_NUM << std::endl;
+        error = true;
+    }
+
+    if(error) {
+        std::string error_info = data_str.str();
+        g_print("%s", error_info.c_str());
+        pipeline_report_error_info(element,error_info.c_str());
+        algo_pipeline_config_destroy(config);
+        config = NULL;
     }
     *num = count;
-    g_strfreev(items);
     return config;
 }
 
 static void algo_pipeline_print(AlgoPipelineHandle handle)
 {
      AlgoPipeline *pipeline = (AlgoPipeline *) handle;
-      CvdlAlgoBase* algo = (CvdlAlgoBase *)pipeline->first;
-      CvdlAlgoBase* last = (CvdlAlgoBase *)pipeline->last;
-
-      //Improvement need: print tree-shape algo pipeline
-      g_print("algopipeline chain: ");
-      while(algo && algo!=last && last) {
-            g_print("%s ->  ",register_get_algo_name(algo->mAlgoType));
-            algo = algo->mNext[0];
-      }
-      if(algo)
-        g_print("%s\n",register_get_algo_name(algo->mAlgoType));
+     CvdlAlgoBase* algo = NULL;
+     int i, j;
+
+     // print every algo with its next algos, so that branches can be seen
+     g_print("algopipeline chain:\n");
+     for(i=0; i< pipeline->algo_num; i++) {
+         algo = static_cast<CvdlAlgoBase *>(pipeline->algo_chain[i].algo);
+         if(!algo || algo==pipeline->last)
+             continue;
+         g_print("\t%s%s -> ", register_get_algo_name(algo->mAlgoType),
+                 algo->mFanOut ? "(fan out)" : "");
+         for(j=0;j<MAX_DOWN_STREAM_ALGO_NUM;j++) {
+             if(algo->mNext[j])
+                 g_print("%s  ", register_get_algo_name(algo->mNext[j]->mAlgoType));
+         }
+         g_print("\n");
+     }
 }
 
 AlgoPipelineHandle algo_pipeline_create(AlgoPipelineConfig* config, int num, GstElement *element)
@@ -377,6 +341,7 @@ AlgoPipelineHandle algo_pipeline_create(AlgoPipelineConfig* config, int num, Gst
             error = true;
             break;
         }
+        static_cast<CvdlAlgoBase *>(item->algo)->mFanOut = config[i].fanOut;
         preId = config[i].preId;
         if(preId>=0){
             item->preItem = pipeline->algo_chain + preId;
@@ -437,6 +402,12 @@ AlgoPipelineHandle algo_pipeline_create(AlgoPipelineConfig* config, int num, Gst
      algo_item_link_sink(preSinkItem, MAX_PIPELINE_OUT_NUM, item);
      pipeline->last = item->algo;
 
+     // all branches are joined in sinkalgo
+     for(i=0; i< num; i++) {
+        CvdlAlgoBase *algo = static_cast<CvdlAlgoBase *>(pipeline->algo_chain[i].algo);
+        algo->mSinkAlgo = static_cast<CvdlAlgoBase *>(pipeline->last);
+     }
+
     handle = (AlgoPipelineHandle)pipeline;
     algo_pipeline_print(handle);
     return handle;
@@ -539,6 +510,12 @@ void algo_pipeline_stop(AlgoPipelineHandle handle)
     }
 }
 void algo_pipeline_put_buffer(AlgoPipelineHandle handle, GstBuffer *buf,  guint w, guint h)
+{
+    algo_pipeline_put_buffer_rois(handle, buf, w, h, NULL, 0);
+}
+
+void algo_pipeline_put_buffer_rois(AlgoPipelineHandle handle, GstBuffer *buf, guint w, guint h,
+                                   VideoRect *rois, int num)
 {
     AlgoPipeline *pipeline = (AlgoPipeline *) handle;
     CvdlAlgoBase* algo = NULL;
@@ -555,7 +532,7 @@ void algo_pipeline_put_buffer(AlgoPipelineHandle handle, GstBuffer *buf,  guint
         return;
     }
     //g_print("%s() - GstBuffer = %p\n",__func__,  buf);
-    algo->queue_buffer(buf, w, h);
+    algo->queue_buffer(buf, w, h, rois, num);
 }
 
 
@@ -598,18 +575,301 @@ int algo_pipeline_get_all_queue_size(AlgoPipelineHandle handle)
     return size;
 }
 
-void algo_pipeline_get_buffer(AlgoPipelineHandle handle, GstBuffer **buf)
+gint64 algo_pipeline_get_oldest_age(AlgoPipelineHandle handle)
+{
+    AlgoPipeline *pipeline = (AlgoPipeline *) handle;
+    CvdlAlgoBase* algo = NULL;
+    gint64 age = 0, oldest = 0;
+    int i;
+
+    if(pipeline==NULL)
+        return 0;
+    for(i=0;i<pipeline->algo_num;i++) {
+        algo = static_cast<CvdlAlgoBase *>(pipeline->algo_chain[i].algo);
+        if(algo && algo->get_oldest_queued_age(&age) && age > oldest)
+            oldest = age;
+    }
+    return oldest;
+}
+
+gboolean algo_pipeline_get_buffer(AlgoPipelineHandle handle, GstBuffer **buf)
 {
     AlgoPipeline *pipeline = (AlgoPipeline *) handle;
     CvdlAlgoBase* algo = NULL;
+    gboolean eos = FALSE;
 
     *buf = NULL;
     //Improvement need: support multiple output buffer
     if(pipeline) {
         algo = static_cast<CvdlAlgoBase *>(pipeline->last);
         if(algo)
-            *buf = algo->dequeue_buffer();
+            *buf = algo->dequeue_buffer(&eos);
+    }
+    return !eos;
+}
+
+void algo_pipeline_set_reorder_time(AlgoPipelineHandle handle, int ms)
+{
+    AlgoPipeline *pipeline = (AlgoPipeline *) handle;
+    SinkAlgo* sink = NULL;
+
+    if(pipeline==NULL) {
+        GST_ERROR("%s - algo pipeline handle is NULL!\n", __func__);
+        return;
+    }
+    sink = static_cast<SinkAlgo *>(pipeline->last);
+    if(sink)
+        sink->set_reorder_time(ms);
+}
+
+void algo_pipeline_set_warmup(AlgoPipelineHandle handle, gboolean enable)
+{
+    AlgoPipeline *pipeline = (AlgoPipeline *) handle;
+    CvdlAlgoBase* algo = NULL;
+    int i;
+
+    if(pipeline==NULL) {
+        GST_ERROR("%s - algo pipeline handle is NULL!\n", __func__);
+        return;
+    }
+    for(i=0;i<pipeline->algo_num;i++) {
+        algo = static_cast<CvdlAlgoBase *>(pipeline->algo_chain[i].algo);
+        if(algo)
+            algo->mIeLoader.set_warmup(enable);
+    }
+}
+
+int algo_pipeline_set_device(AlgoPipelineHandle handle, const char *device)
+{
+    AlgoPipeline *pipeline = (AlgoPipeline *) handle;
+    CvdlAlgoBase* algo = NULL;
+    InferenceEngine::TargetDevice dev;
+    int i;
+
+    if(pipeline==NULL) {
+        GST_ERROR("%s - algo pipeline handle is NULL!\n", __func__);
+        return eCvdlFilterErrorCode_EmptyPipe;
+    }
+    if(!device || !g_ascii_strcasecmp(device, "HDDL")) {
+        dev = InferenceEngine::TargetDevice::eHDDL;
+    } else if(!g_ascii_strcasecmp(device, "CPU")) {
+        dev = InferenceEngine::TargetDevice::eCPU;
+    } else if(!g_ascii_strcasecmp(device, "GPU")) {
+        dev = InferenceEngine::TargetDevice::eGPU;
+    } else {
+        g_print("Not support device: %s\n", device);
+        return eCvdlFilterErrorCode_IE;
+    }
+    for(i=0;i<pipeline->algo_num;i++) {
+        algo = static_cast<CvdlAlgoBase *>(pipeline->algo_chain[i].algo);
+        if(algo)
+            algo->mTargetDevice = dev;
+    }
+    return eCvdlFilterErrorCode_None;
+}
+
+int algo_pipeline_set_placement(AlgoPipelineHandle handle, const char *policy)
+{
+    AlgoPipeline *pipeline = (AlgoPipeline *) handle;
+    CvdlAlgoBase* algo = NULL;
+    std::string defaultCpus;
+    std::map<std::string, std::string> algoCpus;
+    gchar **items = NULL;
+    int i, ret = eCvdlFilterErrorCode_None;
+
+    if(pipeline==NULL) {
+        GST_ERROR("%s - algo pipeline handle is NULL!\n", __func__);
+        return eCvdlFilterErrorCode_EmptyPipe;
+    }
+    items = g_strsplit(policy ? policy : "", ";", -1);
+    for(i=0; items[i]; i++) {
+        std::string item = algo_desc_strip(std::string(items[i]));
+        size_t pos = item.find("=");
+        if(pos == std::string::npos)
+            defaultCpus = item;
+        else
+            algoCpus[algo_desc_strip(item.substr(0, pos))] = algo_desc_strip(item.substr(pos + 1));
+    }
+    g_strfreev(items);
+
+    for(i=0;i<pipeline->algo_num;i++) {
+        algo = static_cast<CvdlAlgoBase *>(pipeline->algo_chain[i].algo);
+        if(!algo)
+            continue;
+        auto it = algoCpus.find(algo->mName);
+        const std::string &cpus = (it != algoCpus.end()) ? it->second : defaultCpus;
+        if(!algo->mPlacement.parse(cpus.c_str())) {
+            std::string error_info = std::string("Invalid placement of algo ") + algo->mName + ": " + cpus;
+            pipeline_report_error_info(pipeline->element, error_info.c_str());
+            ret = eCvdlFilterErrorCode_InvalidPipe;
+            continue;
+        }
+        algo->mIeLoader.set_placement(algo->mPlacement);
+        if(algo->mPlacement.is_set())
+            g_print("Algo %s: CPUs = %s, NUMA node = %d\n", algo->mName.c_str(),
+                algo->mPlacement.cpus().c_str(), algo->mPlacement.node());
+    }
+    return ret;
+}
+
+gboolean algo_pipeline_get_placement(AlgoPipelineHandle handle, int index, AlgoPlacementReport *report)
+{
+    AlgoPipeline *pipeline = (AlgoPipeline *) handle;
+    CvdlAlgoBase* algo = NULL;
+
+    if(pipeline==NULL || report==NULL || index<0 || index>=pipeline->algo_num)
+        return FALSE;
+    algo = static_cast<CvdlAlgoBase *>(pipeline->algo_chain[index].algo);
+    if(!algo)
+        return FALSE;
+    report->algo_name = algo->mName.c_str();
+    report->cpus = algo->mPlacement.cpus().c_str();
+    report->node = algo->mPlacement.node();
+    report->thread_id = algo->mThreadId;
+    report->cpu = algo->mLastCpu;
+    report->workers = algo->mExecutor ? algo->mExecutor->get_worker_num() : 0;
+    return TRUE;
+}
+
+void algo_pipeline_set_latency_stat(AlgoPipelineHandle handle, gboolean enable)
+{
+    AlgoPipeline *pipeline = (AlgoPipeline *) handle;
+    CvdlAlgoBase* algo = NULL;
+    int i;
+
+    if(pipeline==NULL) {
+        GST_ERROR("%s - algo pipeline handle is NULL!\n", __func__);
+        return;
+    }
+    for(i=0;i<pipeline->algo_num;i++) {
+        algo = static_cast<CvdlAlgoBase *>(pipeline->algo_chain[i].algo);
+        if(algo)
+            algo->mLatencyStat = enable;
+    }
+}
+
+int algo_pipeline_get_algo_num(AlgoPipelineHandle handle)
+{
+    AlgoPipeline *pipeline = (AlgoPipeline *) handle;
+    return pipeline ? pipeline->algo_num : 0;
+}
+
+const char *algo_pipeline_get_latency(AlgoPipelineHandle handle, int index, GArray *samples)
+{
+    AlgoPipeline *pipeline = (AlgoPipeline *) handle;
+    CvdlAlgoBase* algo = NULL;
+
+    if(pipeline==NULL || index<0 || index>=pipeline->algo_num)
+        return NULL;
+    algo = static_cast<CvdlAlgoBase *>(pipeline->algo_chain[index].algo);
+    if(!algo)
+        return NULL;
+
+    std::lock_guard<std::mutex> lk(algo->mLatencyMutex);
+    if(samples && algo->mLatency.size()>0)
+        g_array_append_vals(samples, algo->mLatency.data(), algo->mLatency.size());
+    return algo->mName.c_str();
+}
+
+gboolean algo_pipeline_check_stall(AlgoPipelineHandle handle, int queue_timeout, int infer_timeout,
+                                   AlgoStallReport *report)
+{
+    AlgoPipeline *pipeline = (AlgoPipeline *) handle;
+    CvdlAlgoBase* algo = NULL;
+    gint64 age = 0, now = g_get_monotonic_time();
+    int i, reqestId = -1;
+
+    if(pipeline==NULL || report==NULL)
+        return FALSE;
+    for(i=0;i<pipeline->algo_num;i++) {
+        algo = static_cast<CvdlAlgoBase *>(pipeline->algo_chain[i].algo);
+        if(!algo)
+            continue;
+        report->type = eAlgoStallType_None;
+        if(infer_timeout>0 && algo->mIeInited &&
+           algo->mIeLoader.get_oldest_request(&reqestId, &age) && age > infer_timeout*1000ll) {
+            report->type = eAlgoStallType_Infer;
+            report->request_id = reqestId;
+        } else if(queue_timeout>0 && algo->get_oldest_queued_age(&age) &&
+                  age > queue_timeout*1000ll) {
+            report->type = eAlgoStallType_Queue;
+            report->request_id = -1;
+        }
+        if(report->type == eAlgoStallType_None)
+            continue;
+        report->algo_index = i;
+        report->algo_name = algo->mName.c_str();
+        report->duration = age;
+        report->idle = algo->mLastDequeue ? now - algo->mLastDequeue : 0;
+        report->queue_size = algo->get_in_queue_size();
+        return TRUE;
+    }
+    return FALSE;
+}
+
+int algo_pipeline_set_record(AlgoPipelineHandle handle, int index, const char *file)
+{
+    AlgoPipeline *pipeline = (AlgoPipeline *) handle;
+    CvdlAlgoBase* algo = NULL;
+
+    if(pipeline==NULL) {
+        GST_ERROR("%s - algo pipeline handle is NULL!\n", __func__);
+        return eCvdlFilterErrorCode_EmptyPipe;
+    }
+    if(index<0 || index>=pipeline->algo_num) {
+        GST_ERROR("algo index is invalid: %d", index);
+        return eCvdlFilterErrorCode_InvalidPipe;
+    }
+    algo = static_cast<CvdlAlgoBase *>(pipeline->algo_chain[index].algo);
+    if(!file) {
+        if(algo->mRecorder)
+            algo->mRecorder->close();
+        return eCvdlFilterErrorCode_None;
+    }
+    if(!algo->mRecorder)
+        algo->mRecorder = new AlgoRecorder;
+    if(!algo->mRecorder->open(file))
+        return eCvdlFilterErrorCode_Unknown;
+    return eCvdlFilterErrorCode_None;
+}
+
+AlgoReplayHandle algo_replay_open(const char *file)
+{
+    AlgoReplayer *replay = new AlgoReplayer;
+    if(!replay->open(file)) {
+        delete replay;
+        return NULL;
+    }
+    return (AlgoReplayHandle)replay;
+}
+
+void algo_replay_close(AlgoReplayHandle replay)
+{
+    if(replay)
+        delete static_cast<AlgoReplayer *>(replay);
+}
+
+gboolean algo_pipeline_put_replay_buffer(AlgoPipelineHandle handle, AlgoReplayHandle replay,
+                                         GstBuffer *buf)
+{
+    AlgoPipeline *pipeline = (AlgoPipeline *) handle;
+    CvdlAlgoBase* algo = NULL;
+
+    if(pipeline==NULL || replay==NULL || pipeline->first==NULL) {
+        gst_buffer_unref(buf);
+        GST_ERROR("%s - algo pipeline or replay is NULL!\n", __func__);
+        return FALSE;
+    }
+    algo = static_cast<CvdlAlgoBase *>(pipeline->first);
+
+    CvdlAlgoData *algoData = new CvdlAlgoData(buf);
+    if(!static_cast<AlgoReplayer *>(replay)->read(algoData)) {
+        delete algoData;
+        gst_buffer_unref(buf);
+        return FALSE;
     }
+    algo->queue_algo_data(algoData);
+    return TRUE;
 }
 
 void algo_pipeline_flush_buffer(AlgoPipelineHandle handle)
@@ -25,6 +25,7 @@ extern "C" {
 
 #include <gst/gstbuffer.h>
 #include <gst/gstpad.h>
+#include <interface/videodefs.h>
 #include "algoregister.h"
 #include "private.h"
 
@@ -44,6 +45,7 @@ typedef struct _AlgoPipelineConfig{
     int preId; /* previous algo id */
     int nextNum; /* next algo number */
     int nextId[MAX_DOWN_STREAM_ALGO_NUM]; /* next algo id*/
+    int fanOut; /* 1 - put every frame into all next algos, 0 - only into nextId[outputIndex] */
 }AlgoPipelineConfig;
 
 // Note: 
@@ -54,6 +56,9 @@ typedef struct _AlgoPipelineConfig{
 //      If it is output, all value in nextId are same
 //        {1, ALGO_OF_TRACK, 1, 2, {2, 3}}
 //        {2, ALGO_OF_TRACK, 1, 1, {-2}}
+//   3. If fanOut is set, the next algos are parallel branches of this algo, and
+//      their outputs will be joined by frame in SinkAlgo:
+//        {1, ALGO_OF_TRACK, 0, 2, {2, 3}, 1}
 //
 //static AlgoPipelineConfig algoTopologyDefault[] = {
 //    {0, ALGO_YOLOV1_TINY, -1,  1, {1}},
@@ -82,6 +87,33 @@ typedef struct _AlgoPipeline{
 
 typedef void* AlgoPipelineHandle;
 
+enum eAlgoStallType {
+    eAlgoStallType_None = 0,
+    eAlgoStallType_Queue = 1, /* a frame waits in the input queue of an algo too long */
+    eAlgoStallType_Infer = 2, /* an infer request of an algo runs too long */
+};
+
+// which algo stalls, which request and how long
+typedef struct _AlgoStallReport{
+    int type;
+    int algo_index;
+    const char *algo_name;
+    int request_id;    /* only for eAlgoStallType_Infer */
+    gint64 duration;   /* age(us) of the oldest queued frame or the infer request */
+    gint64 idle;       /* time(us) since the algo got its last frame */
+    int queue_size;
+}AlgoStallReport;
+
+// where the threads of an algo run
+typedef struct _AlgoPlacementReport{
+    const char *algo_name;
+    const char *cpus;  /* CPU list the algo threads are pinned to, "" if not pinned */
+    int node;          /* NUMA node of the CPU list, -1 if not pinned or it spans nodes */
+    int thread_id;     /* thread id of the worker which ran the algo last, 0 if it is not running */
+    int cpu;           /* CPU the algo got its last frame on, -1 if unknown */
+    int workers;       /* workers of the executor shared by the algos with the same CPU list */
+}AlgoPlacementReport;
+
 
 AlgoPipelineHandle algo_pipeline_create(AlgoPipelineConfig* config, int num, GstElement *element);
 AlgoPipelineHandle algo_pipeline_create_default(GstElement *element);
@@ -94,13 +126,55 @@ int algo_pipeline_set_caps_all(AlgoPipelineHandle handle, GstCaps* caps);
 void algo_pipeline_start(AlgoPipelineHandle handle);
 void algo_pipeline_stop(AlgoPipelineHandle handle);
 void algo_pipeline_put_buffer(AlgoPipelineHandle handle, GstBuffer *buf, guint w, guint h);
-void algo_pipeline_get_buffer(AlgoPipelineHandle handle, GstBuffer **buf);
+// put a buffer with num objects, which will be processed by the first algo instead of the whole frame
+void algo_pipeline_put_buffer_rois(AlgoPipelineHandle handle, GstBuffer *buf, guint w, guint h,
+                                   VideoRect *rois, int num);
+// *buf = NULL if no buffer is ready, return FALSE only if the EOS buffer put by
+// algo_pipeline_flush_buffer() was got, a timeout returns TRUE
+gboolean algo_pipeline_get_buffer(AlgoPipelineHandle handle, GstBuffer **buf);
+void algo_pipeline_set_reorder_time(AlgoPipelineHandle handle, int ms);
+// must be called before algo_pipeline_set_caps_all(), which loads the networks
+void algo_pipeline_set_warmup(AlgoPipelineHandle handle, gboolean enable);
+// device = "HDDL", "CPU" or "GPU", must be called before algo_pipeline_set_caps_all()
+int algo_pipeline_set_device(AlgoPipelineHandle handle, const char *device);
+
+// pin the threads of algos to CPUs, must be called before algo_pipeline_start()
+// policy = "<cpus>;<algo name>=<cpus>;...", the first item without a name is for all algos,
+// cpus is a CPU list like "0-3,8" or "node<N>" for all CPUs of NUMA node N, NULL or "" to unpin
+int algo_pipeline_set_placement(AlgoPipelineHandle handle, const char *policy);
+// fill report with the placement of algo index, return FALSE if index is invalid
+gboolean algo_pipeline_get_placement(AlgoPipelineHandle handle, int index, AlgoPlacementReport *report);
+
+// latency statistics of every algo, it is used by benchmark
+void algo_pipeline_set_latency_stat(AlgoPipelineHandle handle, gboolean enable);
+int algo_pipeline_get_algo_num(AlgoPipelineHandle handle);
+// append the latency samples(us) of algo index into samples(gint64), return the algo name
+// or NULL if index is invalid
+const char *algo_pipeline_get_latency(AlgoPipelineHandle handle, int index, GArray *samples);
+
+// check the heartbeats of every algo against the timeouts(ms), 0 - not check
+// return TRUE and fill report if an algo stalls
+gboolean algo_pipeline_check_stall(AlgoPipelineHandle handle, int queue_timeout, int infer_timeout,
+                                   AlgoStallReport *report);
+
+// record the output of algo index into file, file = NULL to stop recording
+int algo_pipeline_set_record(AlgoPipelineHandle handle, int index, const char *file);
+
+// replay a record file into the first algo of a pipeline, the upstream algos are not needed
+typedef void* AlgoReplayHandle;
+AlgoReplayHandle algo_replay_open(const char *file);
+void algo_replay_close(AlgoReplayHandle replay);
+// put buf with the objects of the next record, return FALSE and unref buf at the end of the file
+gboolean algo_pipeline_put_replay_buffer(AlgoPipelineHandle handle, AlgoReplayHandle replay,
+                                         GstBuffer *buf);
 
 const char* algo_pipeline_get_name(guint  mAlgoType);
 
 void algo_pipeline_flush_buffer(AlgoPipelineHandle handle);
 int algo_pipeline_get_input_queue_size(AlgoPipelineHandle handle);
 int algo_pipeline_get_all_queue_size(AlgoPipelineHandle handle);
+// age(us) of the oldest frame waiting in the input queues of all algos, 0 if no frame waits
+gint64 algo_pipeline_get_oldest_age(AlgoPipelineHandle handle);
 
 void pipeline_report_error_info(GstElement *element, const char* error_info);
 
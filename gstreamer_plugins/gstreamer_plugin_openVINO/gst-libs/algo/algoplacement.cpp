@@ -0,0 +1,180 @@
+/*
+ *Copyright (C) 2018 Intel Corporation
+ *
+ *SPDX-License-Identifier: LGPL-2.1-only
+ *
+ *This library is free software; you can redistribute it and/or modify it under the terms
+ * of the GNU Lesser General Public License as published by the Free Software Foundation;
+ * version 2.1.
+ *
+ *This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this library;
+ * if not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "algoplacement.h"
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/syscall.h>
+#include <linux/mempolicy.h>
+#include <sstream>
+#include <gst/gstinfo.h>
+
+#define NUMA_NODE_PATH "/sys/devices/system/node"
+// max NUMA nodes in the node mask of set_mempolicy
+#define MAX_NUMA_NODES 1024
+
+// parse a CPU list like "0-3,8,10-11" into set
+static gboolean parse_cpu_list(const char *str, cpu_set_t *set)
+{
+    gchar **items = g_strsplit(str, ",", -1);
+    gboolean ret = TRUE;
+
+    CPU_ZERO(set);
+    for(int i=0; items[i] && ret; i++) {
+        gchar *item = g_strstrip(items[i]);
+        gchar *end = NULL;
+        if(strlen(item)==0)
+            continue;
+        long first = strtol(item, &end, 10);
+        long last = first;
+        if(end && *end=='-')
+            last = strtol(end + 1, &end, 10);
+        if(end==item || (end && *end) || first<0 || last<first || last>=CPU_SETSIZE) {
+            ret = FALSE;
+            break;
+        }
+        for(long cpu=first; cpu<=last; cpu++)
+            CPU_SET(cpu, set);
+    }
+    g_strfreev(items);
+    return ret && CPU_COUNT(set)>0;
+}
+
+static std::string format_cpu_list(cpu_set_t *set)
+{
+    std::ostringstream str;
+    int cpu = 0;
+    while(cpu < CPU_SETSIZE) {
+        if(!CPU_ISSET(cpu, set)) {
+            cpu++;
+            continue;
+        }
+        int last = cpu;
+        while(last+1 < CPU_SETSIZE && CPU_ISSET(last+1, set))
+            last++;
+        if(str.tellp() > 0)
+            str << ",";
+        str << cpu;
+        if(last > cpu)
+            str << "-" << last;
+        cpu = last + 1;
+    }
+    return str.str();
+}
+
+static gboolean read_node_cpus(int node, cpu_set_t *set)
+{
+    gchar *path = g_strdup_printf(NUMA_NODE_PATH "/node%d/cpulist", node);
+    gchar *content = NULL;
+    gboolean ret = g_file_get_contents(path, &content, NULL, NULL);
+    g_free(path);
+    if(!ret)
+        return FALSE;
+    ret = parse_cpu_list(content, set);
+    g_free(content);
+    return ret;
+}
+
+// the node which has all CPUs of set, -1 if none
+static int find_node(cpu_set_t *set)
+{
+    GDir *dir = g_dir_open(NUMA_NODE_PATH, 0, NULL);
+    const gchar *name;
+    int found = -1;
+
+    if(!dir)
+        return -1;
+    while(found<0 && (name = g_dir_read_name(dir))) {
+        cpu_set_t nodeSet, both;
+        if(!g_str_has_prefix(name, "node") || !g_ascii_isdigit(name[4]))
+            continue;
+        int node = atoi(name + 4);
+        if(!read_node_cpus(node, &nodeSet))
+            continue;
+        CPU_AND(&both, &nodeSet, set);
+        if(CPU_EQUAL(&both, set))
+            found = node;
+    }
+    g_dir_close(dir);
+    return found;
+}
+
+static void set_mempolicy_node(int node)
+{
+    unsigned long mask[MAX_NUMA_NODES / (8 * sizeof(unsigned long))];
+    long ret;
+
+    if(node < 0) {
+        ret = syscall(SYS_set_mempolicy, MPOL_DEFAULT, NULL, 0);
+    } else {
+        memset(mask, 0, sizeof(mask));
+        mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+        ret = syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask, MAX_NUMA_NODES);
+    }
+    if(ret != 0)
+        GST_WARNING("Failed to set memory policy of node %d", node);
+}
+
+AlgoPlacement::AlgoPlacement() : mSet(FALSE), mCpus(""), mNode(-1)
+{
+    CPU_ZERO(&mCpuSet);
+}
+
+gboolean AlgoPlacement::parse(const char *cpus)
+{
+    cpu_set_t set;
+    int node = -1;
+
+    if(!cpus || strlen(cpus)==0) {
+        mSet = FALSE;
+        mCpus = "";
+        mNode = -1;
+        return TRUE;
+    }
+    if(g_str_has_prefix(cpus, "node")) {
+        node = atoi(cpus + 4);
+        if(!g_ascii_isdigit(cpus[4]) || node >= MAX_NUMA_NODES || !read_node_cpus(node, &set)) {
+            g_print("Invalid NUMA node: %s\n", cpus);
+            return FALSE;
+        }
+    } else {
+        if(!parse_cpu_list(cpus, &set)) {
+            g_print("Invalid CPU list: %s\n", cpus);
+            return FALSE;
+        }
+        node = find_node(&set);
+    }
+
+    mCpuSet = set;
+    mCpus = format_cpu_list(&set);
+    mNode = node < MAX_NUMA_NODES ? node : -1;
+    mSet = TRUE;
+    return TRUE;
+}
+
+void AlgoPlacement::apply() const
+{
+    if(!mSet)
+        return;
+    int ret = pthread_setaffinity_np(pthread_self(), sizeof(cpu_set_t), &mCpuSet);
+    if(ret != 0)
+        GST_WARNING("Failed to pin thread to CPUs %s: %s", mCpus.c_str(), strerror(ret));
+    if(mNode >= 0)
+        set_mempolicy_node(mNode);
+}
@@ -0,0 +1,59 @@
+/*
+ *Copyright (C) 2018 Intel Corporation
+ *
+ *SPDX-License-Identifier: LGPL-2.1-only
+ *
+ *This library is free software; you can redistribute it and/or modify it under the terms
+ * of the GNU Lesser General Public License as published by the Free Software Foundation;
+ * version 2.1.
+ *
+ *This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this library;
+ * if not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef __ALGO_PLACEMENT_H__
+#define __ALGO_PLACEMENT_H__
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <sched.h>
+#include <string>
+#include <glib.h>
+
+// CPU set of the threads of an algo, the executor workers running its stage and
+// the threads which parse its inference results.
+// If the CPU set is in one NUMA node, the memory allocated by these threads is
+// preferred on that node, so that the ROI buffers and the objects of the algo
+// stay close to the CPUs using them.
+class AlgoPlacement {
+public:
+    AlgoPlacement();
+
+    // cpus: a CPU list like "0-3,8", or "node1" for all CPUs of NUMA node 1,
+    // NULL or "" to clear
+    gboolean parse(const char *cpus);
+    gboolean is_set() const { return mSet; }
+    // CPU list of the set, "" if not set
+    const std::string &cpus() const { return mCpus; }
+    // NUMA node of the set, -1 if not set or it spans nodes
+    int node() const { return mNode; }
+    // number of CPUs in the set, 0 if not set
+    int cpu_count() const { return mSet ? CPU_COUNT(&mCpuSet) : 0; }
+
+    // pin the calling thread, which is dedicated to the set, such as an executor
+    // worker or an IE callback thread
+    void apply() const;
+
+private:
+    gboolean mSet;
+    cpu_set_t mCpuSet;
+    std::string mCpus;
+    int mNode;
+};
+
+#endif
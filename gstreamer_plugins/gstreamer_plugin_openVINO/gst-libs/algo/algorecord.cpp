@@ -0,0 +1,191 @@
+/*
+ *Copyright (C) 2018 Intel Corporation
+ *
+ *SPDX-License-Identifier: LGPL-2.1-only
+ *
+ *This library is free software; you can redistribute it and/or modify it under the terms
+ * of the GNU Lesser General Public License as published by the Free Software Foundation;
+ * version 2.1.
+ *
+ *This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this library;
+ * if not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <string.h>
+#include "algorecord.h"
+
+template<typename T>
+static void record_put(std::string &buf, T value)
+{
+    buf.append((const char *)&value, sizeof(T));
+}
+
+template<typename T>
+static bool replay_get(FILE *fp, T &value)
+{
+    return fread(&value, sizeof(T), 1, fp) == 1;
+}
+
+static void record_put_rect(std::string &buf, cv::Rect &rect)
+{
+    record_put<gint32>(buf, rect.x);
+    record_put<gint32>(buf, rect.y);
+    record_put<gint32>(buf, rect.width);
+    record_put<gint32>(buf, rect.height);
+}
+
+static bool replay_get_rect(FILE *fp, cv::Rect &rect)
+{
+    gint32 v[4];
+    if(fread(v, sizeof(gint32), 4, fp) != 4)
+        return false;
+    rect = cv::Rect(v[0], v[1], v[2], v[3]);
+    return true;
+}
+
+AlgoRecorder::AlgoRecorder() : mFile(NULL)
+{
+}
+
+AlgoRecorder::~AlgoRecorder()
+{
+    close();
+}
+
+gboolean AlgoRecorder::open(const char *file)
+{
+    guint32 version = ALGO_RECORD_VERSION;
+
+    close();
+    std::lock_guard<std::mutex> lk(mMutex);
+    mFile = fopen(file, "wb");
+    if(!mFile) {
+        g_print("Failed to open record file: %s\n", file);
+        return FALSE;
+    }
+    fwrite(ALGO_RECORD_MAGIC, 1, sizeof(ALGO_RECORD_MAGIC), mFile);
+    fwrite(&version, sizeof(version), 1, mFile);
+    return TRUE;
+}
+
+void AlgoRecorder::close()
+{
+    std::lock_guard<std::mutex> lk(mMutex);
+    if(mFile)
+        fclose(mFile);
+    mFile = NULL;
+}
+
+// A record is serialized into mBuffer first, so that it is written by one fwrite
+void AlgoRecorder::write(CvdlAlgoData *algoData)
+{
+    std::lock_guard<std::mutex> lk(mMutex);
+    if(!mFile)
+        return;
+
+    std::vector<ObjectData> &objectVec = algoData->mObjectVec;
+    mBuffer.clear();
+    record_put<guint64>(mBuffer, algoData->mFrameId);
+    record_put<guint64>(mBuffer, algoData->mPts);
+    record_put<gint32>(mBuffer, algoData->mOutputIndex);
+    record_put<guint32>(mBuffer, objectVec.size());
+    for(auto &object : objectVec) {
+        record_put<gint32>(mBuffer, object.id);
+        record_put<gint32>(mBuffer, object.objectClass);
+        record_put<float>(mBuffer, object.prob);
+        record_put<float>(mBuffer, object.score);
+        record_put_rect(mBuffer, object.rect);
+        record_put_rect(mBuffer, object.rectROI);
+        record_put<guint32>(mBuffer, object.label.size());
+        mBuffer.append(object.label.c_str());
+        record_put<guint32>(mBuffer, object.trajectoryPoints.size());
+        for(auto &point : object.trajectoryPoints) {
+            record_put<gint32>(mBuffer, point.x);
+            record_put<gint32>(mBuffer, point.y);
+        }
+    }
+    if(fwrite(mBuffer.data(), 1, mBuffer.size(), mFile) != mBuffer.size())
+        g_print("Failed to write record of frame %ld\n", algoData->mFrameId);
+}
+
+AlgoReplayer::AlgoReplayer() : mFile(NULL)
+{
+}
+
+AlgoReplayer::~AlgoReplayer()
+{
+    close();
+}
+
+gboolean AlgoReplayer::open(const char *file)
+{
+    char magic[sizeof(ALGO_RECORD_MAGIC)];
+    guint32 version = 0;
+
+    close();
+    mFile = fopen(file, "rb");
+    if(!mFile) {
+        g_print("Failed to open replay file: %s\n", file);
+        return FALSE;
+    }
+    if(fread(magic, 1, sizeof(magic), mFile) != sizeof(magic) ||
+       memcmp(magic, ALGO_RECORD_MAGIC, sizeof(magic)) ||
+       !replay_get(mFile, version) || version != ALGO_RECORD_VERSION) {
+        g_print("Invalid replay file: %s\n", file);
+        close();
+        return FALSE;
+    }
+    return TRUE;
+}
+
+void AlgoReplayer::close()
+{
+    if(mFile)
+        fclose(mFile);
+    mFile = NULL;
+}
+
+gboolean AlgoReplayer::read(CvdlAlgoData *algoData)
+{
+    guint64 frameId, pts;
+    gint32 outputIndex;
+    guint32 objectNum, len;
+
+    if(!mFile)
+        return FALSE;
+    if(!replay_get(mFile, frameId) || !replay_get(mFile, pts) ||
+       !replay_get(mFile, outputIndex) || !replay_get(mFile, objectNum))
+        return FALSE;
+
+    algoData->mPts = pts;
+    algoData->mOutputIndex = outputIndex;
+    algoData->mObjectVec.clear();
+    for(guint32 i=0; i<objectNum; i++) {
+        ObjectData object;
+        bool ok = replay_get(mFile, object.id) && replay_get(mFile, object.objectClass) &&
+                  replay_get(mFile, object.prob) && replay_get(mFile, object.score) &&
+                  replay_get_rect(mFile, object.rect) && replay_get_rect(mFile, object.rectROI) &&
+                  replay_get(mFile, len);
+        if(ok && len>0) {
+            std::string label(len, '\0');
+            ok = fread(&label[0], 1, len, mFile) == len;
+            object.label = label;
+        }
+        ok = ok && replay_get(mFile, len);
+        for(guint32 j=0; ok && j<len; j++) {
+            VideoPoint point;
+            ok = replay_get(mFile, point.x) && replay_get(mFile, point.y);
+            object.trajectoryPoints.push_back(point);
+        }
+        if(!ok) {
+            g_print("Truncated record of frame %ld\n", frameId);
+            return FALSE;
+        }
+        algoData->mObjectVec.push_back(object);
+    }
+    return TRUE;
+}
@@ -0,0 +1,68 @@
+/*
+ *Copyright (C) 2018 Intel Corporation
+ *
+ *SPDX-License-Identifier: LGPL-2.1-only
+ *
+ *This library is free software; you can redistribute it and/or modify it under the terms
+ * of the GNU Lesser General Public License as published by the Free Software Foundation;
+ * version 2.1.
+ *
+ *This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this library;
+ * if not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef __ALGO_RECORD_H__
+#define __ALGO_RECORD_H__
+
+#include <stdio.h>
+#include <string>
+#include <mutex>
+#include "algobase.h"
+
+// Binary log of the algoData at an algo boundary, which can be replayed into
+// an algo without the upstream algos, e.g. to benchmark a track algo without inference.
+//
+// File: "CVDLREC" | version(u32) | record ...
+// Record: frameId(u64) | pts(u64) | outputIndex(i32) | objectNum(u32) | object ...
+// Object: id | objectClass | prob | score | rect(4) | rectROI(4) | labelLen(u32) | label
+//         | pointNum(u32) | point(x,y) ...
+// All values are 32 bits in host byte order unless noted.
+
+#define ALGO_RECORD_MAGIC "CVDLREC"
+#define ALGO_RECORD_VERSION 1
+
+class AlgoRecorder {
+public:
+    AlgoRecorder();
+    ~AlgoRecorder();
+
+    gboolean open(const char *file);
+    void close();
+    // it is called by the algo thread or IE callback threads
+    void write(CvdlAlgoData *algoData);
+
+private:
+    FILE *mFile;
+    std::mutex mMutex;
+    std::string mBuffer;
+};
+
+class AlgoReplayer {
+public:
+    AlgoReplayer();
+    ~AlgoReplayer();
+
+    gboolean open(const char *file);
+    void close();
+    // read the next record into algoData, return FALSE at the end of the log
+    gboolean read(CvdlAlgoData *algoData);
+
+private:
+    FILE *mFile;
+};
+
+#endif
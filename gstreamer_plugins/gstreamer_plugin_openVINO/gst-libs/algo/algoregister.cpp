@@ -16,7 +16,10 @@
  */
 
 #include "algoregister.h"
+#include "exinferdatav2.h"
 #include <assert.h>
+#include <dlfcn.h>
+#include <sys/stat.h>
 #include <glib.h>
 #include <gst/gst.h>
 
@@ -25,21 +28,26 @@ using namespace std;
 #include<iostream>
 #include<cstdio>
 #include <fstream>
+#include <sstream>
 #include <vector>
+#include <mutex>
+#include <unordered_map>
+#include <unordered_set>
+#include <map>
 
-class AlgoListItem {
-public:
-    int id;
-    std::string name_str;
-};
+// the cache file is checked for updates at most once per second
+#define REGISTER_CHECK_INTERVAL 1000000
 
+// Algos are looked up by hash, the cache file is read once and only read
+// again when its mtime or size changes.
 class AlgoRegister{
 public:
-    AlgoRegister():  generic_algo_num(0), algo_id(0), inited(false)
+    AlgoRegister():  generic_algo_num(0), inited(false), cache_mtime(0),
+        cache_size(-1), last_check(0)
    {
    };
     ~AlgoRegister(){};
-    void add_algo(int id, const char* name);
+    int add_algo(int id, const char* name);
     const char *get_algo_name(int id);
     int get_algo_id(const char *name);
     int get_free_id();
@@ -51,7 +59,8 @@ public:
 
     int get_algo_num()
     {
-        return algo_vec.size();
+        std::lock_guard<std::mutex> lk(mutex);
+        return algo_ids.size();
      }
     int get_generic_algo_num()
     {
@@ -59,43 +68,115 @@ public:
     }
 private:
     void init_default_algo();
-    std::vector<AlgoListItem>  algo_vec;
+    bool insert_algo(int id, const char* name);
+    bool check_algo_library(const char* name);
+    int read_cache();
+    void write_cache();
+    bool cache_changed();
+
+    std::mutex mutex;
+    std::unordered_map<std::string, int> algo_ids;
+    std::unordered_map<int, const char *> algo_names;
+    // names are never freed, so that returned names stay valid after reload
+    std::unordered_set<std::string> name_pool;
     int generic_algo_num; // number of generic algo
-    int algo_id;
     bool inited;
+    gint64 cache_mtime;
+    gint64 cache_size;
+    gint64 last_check;
 };
 
-void AlgoRegister::add_algo(int id, const char* name)
+bool AlgoRegister::insert_algo(int id, const char* name)
 {
     // check if this name/id has already exist.
-    for(unsigned int i=0; i<algo_vec.size();i++) {
-        AlgoListItem &item = algo_vec[i];
-        if(!item.name_str.compare(name) || item.id==id) {
-            GST_ERROR("Algo(id=%d, name=%s) has existed!\n",id, name);
-            return;
+    if(algo_ids.count(name) || algo_names.count(id)) {
+        GST_ERROR("Algo(id=%d, name=%s) has existed!\n",id, name);
+        return false;
+    }
+
+    const char *stored = name_pool.insert(std::string(name)).first->c_str();
+    algo_ids[stored] = id;
+    algo_names[id] = stored;
+    if(id>=ALGO_MAX_DEFAULT_NUM)
+        generic_algo_num = MAX(generic_algo_num, id - ALGO_MAX_DEFAULT_NUM + 1);
+    return true;
+}
+
+// A generic algo library must export the whole ABI of its version, or it
+// would only fail when the first frame is parsed.
+bool AlgoRegister::check_algo_library(const char* name)
+{
+    static const char *common_symbols[] = {
+        "get_data_type", "get_mean_scale", "get_network_config", NULL };
+    static const char *v1_symbols[] = {
+        "parse_inference_result", "post_process_inference_data", NULL };
+    static const char *v2_symbols[] = {
+        "ex_parse_inference_batch", "ex_post_process_objects", NULL };
+    const char **symbols[2] = { common_symbols, NULL };
+    bool ok = true;
+    int version = 1;
+
+    gchar *lib_name = register_get_algo_library(name);
+    if(!lib_name) {
+        g_print("Cannot get ${HDDLS_CVDL_MODEL_PATH}\n");
+        return false;
+    }
+    void *handler = dlopen(lib_name, RTLD_LAZY | RTLD_LOCAL);
+    if(!handler) {
+        g_print("Failed to dlopen %s: %s\n", lib_name, dlerror());
+        g_free(lib_name);
+        return false;
+    }
+
+    pfGetAbiVersionFunc pfGetAbiVersion = (pfGetAbiVersionFunc)dlsym(handler, "ex_algo_abi_version");
+    if(pfGetAbiVersion)
+        version = pfGetAbiVersion();
+    if(version == EX_ALGO_ABI_VERSION) {
+        symbols[1] = v2_symbols;
+    } else if(version == 1) {
+        symbols[1] = v1_symbols;
+    } else {
+        g_print("%s: unknown ABI version %d\n", lib_name, version);
+        ok = false;
+    }
+
+    for(int i=0; ok && i<2; i++) {
+        for(const char **symbol = symbols[i]; *symbol; symbol++) {
+            if(!dlsym(handler, *symbol)) {
+                g_print("%s: ABI version %d, missing symbol %s\n", lib_name, version, *symbol);
+                ok = false;
+            }
         }
     }
 
-    AlgoListItem new_item;
-    new_item.id = id;
-    new_item.name_str = std::string(name);
-    algo_vec.push_back(new_item);
-    return;
+    dlclose(handler);
+    g_free(lib_name);
+    return ok;
+}
+
+int AlgoRegister::add_algo(int id, const char* name)
+{
+    std::lock_guard<std::mutex> lk(mutex);
+
+    if(id>=ALGO_MAX_DEFAULT_NUM && !check_algo_library(name)) {
+        g_print("Reject algo(id=%d, name=%s)\n", id, name);
+        return -1;
+    }
+    return insert_algo(id, name) ? 0 : -1;
 }
 
 int AlgoRegister::get_free_id()
  {
-    return ALGO_MAX_DEFAULT_NUM + generic_algo_num++;
+    std::lock_guard<std::mutex> lk(mutex);
+    return ALGO_MAX_DEFAULT_NUM + generic_algo_num;
  }
 
 const char *AlgoRegister::get_algo_name(int id)
 {
-    for(unsigned int i=0; i<algo_vec.size();i++) {
-        AlgoListItem &item = algo_vec[i];
-        if(id == item.id) {
-            return item.name_str.c_str();
-        }
-    }
+    std::lock_guard<std::mutex> lk(mutex);
+    auto it = algo_names.find(id);
+    if(it != algo_names.end())
+        return it->second;
 
     GST_ERROR("Failed to get algo name, id = %d\n",id);
     return NULL;
@@ -103,115 +184,155 @@ const char *AlgoRegister::get_algo_name(int id)
 
 int AlgoRegister::get_algo_id(const char *name)
 {
-    for(unsigned int i=0; i<algo_vec.size();i++) {
-        AlgoListItem &item = algo_vec[i];
-        if(!item.name_str.compare(name)) {
-            return item.id;
-        }
-    }
+    std::lock_guard<std::mutex> lk(mutex);
+    auto it = algo_ids.find(name);
+    if(it != algo_ids.end())
+        return it->second;
+
     GST_ERROR("Failed to get algo id, algo name = %s\n",name);
     return -1;
 }
 
  void AlgoRegister::init_default_algo()
 {
-     add_algo(ALGO_YOLOV1_TINY,  ALGO_YOLOV1_TINY_NAME);
-     add_algo(ALGO_OF_TRACK,  ALGO_OF_TRACK_NAME);
-     add_algo(ALGO_GOOGLENETV2,  ALGO_GOOGLENETV2_NAME);
-     add_algo(ALGO_MOBILENET_SSD,  ALGO_MOBILENET_SSD_NAME);
-     add_algo(ALGO_TRACK_LP,  ALGO_TRACK_LP_NAME);
-     add_algo(ALGO_LPRNET,  ALGO_LPRNET_NAME);
-     add_algo(ALGO_YOLOV2_TINY,  ALGO_YOLOV2_TINY_NAME);
-     add_algo(ALGO_REID,  ALGO_REID_NAME);
-     add_algo(ALGO_SINK,  ALGO_SINK_NAME);
+     insert_algo(ALGO_YOLOV1_TINY,  ALGO_YOLOV1_TINY_NAME);
+     insert_algo(ALGO_OF_TRACK,  ALGO_OF_TRACK_NAME);
+     insert_algo(ALGO_GOOGLENETV2,  ALGO_GOOGLENETV2_NAME);
+     insert_algo(ALGO_MOBILENET_SSD,  ALGO_MOBILENET_SSD_NAME);
+     insert_algo(ALGO_TRACK_LP,  ALGO_TRACK_LP_NAME);
+     insert_algo(ALGO_LPRNET,  ALGO_LPRNET_NAME);
+     insert_algo(ALGO_YOLOV2_TINY,  ALGO_YOLOV2_TINY_NAME);
+     insert_algo(ALGO_REID,  ALGO_REID_NAME);
+     insert_algo(ALGO_SINK,  ALGO_SINK_NAME);
 }
 
-void AlgoRegister::register_write()
+// Return true if the cache file is not the one which was read or written last
+bool AlgoRegister::cache_changed()
 {
-    std::ofstream ofs;
-     ofs.exceptions ( std::ifstream::failbit |std::ifstream::badbit );
-     try {
-        ofs.open (ALGO_REGISTER_FILE_NAME, std::ofstream::out);
-        for(unsigned int i=0; i<algo_vec.size();i++) {
-            AlgoListItem &item = algo_vec[i];
-            ofs << item.id <<std::endl;
-            ofs << item.name_str.c_str() << std::endl;
-        }
-        ofs.close();
-     }
-     catch (std::ifstream::failure e) {
-        GST_ERROR("Exception opening/writing/closing file\n");
-     }
+    struct stat st;
+    gint64 mtime = 0, size = -1;
+
+    if(!stat(ALGO_REGISTER_FILE_NAME, &st)) {
+        mtime = (gint64)st.st_mtim.tv_sec * G_USEC_PER_SEC + st.st_mtim.tv_nsec / 1000;
+        size = st.st_size;
+    }
+    if(mtime == cache_mtime && size == cache_size)
+        return false;
+    cache_mtime = mtime;
+    cache_size = size;
+    return true;
 }
 
-int  AlgoRegister::register_read()
+// The file is written to a temp file and renamed, so a process which reloads
+// it never reads a partial one.
+void AlgoRegister::write_cache()
+{
+    std::map<int, const char *> sorted(algo_names.begin(), algo_names.end());
+    std::ostringstream oss;
+    GError *error = NULL;
+
+    for(auto &item : sorted) {
+        oss << item.first <<std::endl;
+        oss << item.second << std::endl;
+    }
+    std::string data = oss.str();
+    if(!g_file_set_contents(ALGO_REGISTER_FILE_NAME, data.c_str(), data.size(), &error)) {
+        GST_ERROR("Failed to write %s: %s\n", ALGO_REGISTER_FILE_NAME, error->message);
+        g_error_free(error);
+    }
+    cache_changed();
+}
+
+// The algos are replaced only if the whole file is parsed, otherwise they are kept
+int  AlgoRegister::read_cache()
 {
     std::ifstream ifs (ALGO_REGISTER_FILE_NAME);
-    algo_vec.clear();
+    std::vector<std::pair<int, std::string>> algos;
+    int id;
+    std::string name;
+
+    cache_changed();
 
     // File didn't exist, return 0.
     if(!ifs.good())
         return 0;
 
-    try {
-       //ifs.open (ALGO_REGISTER_FILE_NAME, std::ifstream::in);
-       ifs.exceptions ( std::ifstream::failbit |std::ifstream::badbit  | std::ifstream::eofbit);
-      while (!ifs.eof()) {
-           AlgoListItem item;
-           ifs >>  item.id ;
-           ifs >> item.name_str;
-           algo_vec.push_back(item);
-       }
-       ifs.close();
-    }
-    catch (std::ifstream::failure e) {
-      //std::cerr << "Exception opening/reading/closing file!\n" ;
-       ifs.close();
+    while (ifs >> id >> name)
+        algos.push_back(std::make_pair(id, name));
+    if(!ifs.eof()) {
+        GST_ERROR("Failed to parse %s\n", ALGO_REGISTER_FILE_NAME);
+        return 0;
     }
-
-    if(algo_vec.size()>0)
-        return 1;
-    else
+    ifs.close();
+    if(algos.empty())
         return 0;
+
+    algo_ids.clear();
+    algo_names.clear();
+    generic_algo_num = 0;
+    for(auto &algo : algos)
+        insert_algo(algo.first, algo.second.c_str());
+    return 1;
+}
+
+void AlgoRegister::register_write()
+{
+    std::lock_guard<std::mutex> lk(mutex);
+    write_cache();
+}
+
+int  AlgoRegister::register_read()
+{
+    std::lock_guard<std::mutex> lk(mutex);
+    return read_cache();
 }
 
 void AlgoRegister::register_init()
 {
-    if(inited) return;
+    std::lock_guard<std::mutex> lk(mutex);
+    gint64 now = g_get_monotonic_time();
+
+    if(inited) {
+        // pick up algos registered by other processes
+        if(now - last_check < REGISTER_CHECK_INTERVAL)
+            return;
+        last_check = now;
+        if(!cache_changed())
+            return;
+        GST_INFO("%s is updated, reload it\n", ALGO_REGISTER_FILE_NAME);
+    }
     inited = true;
+    last_check = now;
 
-    if(!register_read()) {
+    // a failed reload keeps the algos read before
+    if(!read_cache() && algo_ids.empty()) {
         init_default_algo();
-        register_write();
+        write_cache();
     }
-
-    //update generic_algo_num
-    generic_algo_num = 0;
-    for(unsigned int i=0; i<algo_vec.size();i++) {
-        AlgoListItem &item = algo_vec[i];
-        if(item.id>=ALGO_MAX_DEFAULT_NUM)
-            generic_algo_num++;
-     }
 }
 
 void AlgoRegister::register_dump()
 {
+    std::lock_guard<std::mutex> lk(mutex);
+    std::map<int, const char *> sorted(algo_names.begin(), algo_names.end());
+
     g_print("algo list:\n");
-    for(unsigned int i=0; i<algo_vec.size();i++) {
-        AlgoListItem &item = algo_vec[i];
-        g_print("\tid = %d, name = %s\n", item.id,  item.name_str.c_str());
-    }
+    for(auto &item : sorted)
+        g_print("\tid = %d, name = %s\n", item.first,  item.second);
     g_print("\n");
 }
 void AlgoRegister::register_reset()
 {
-    algo_vec.clear();
+    std::lock_guard<std::mutex> lk(mutex);
+    algo_ids.clear();
+    algo_names.clear();
     generic_algo_num = 0;
     inited = false;
     if(remove(ALGO_REGISTER_FILE_NAME))
         GST_INFO("Success to remove %s\n", ALGO_REGISTER_FILE_NAME);
     else
         GST_INFO("Failed to remove %s\n", ALGO_REGISTER_FILE_NAME);
+    cache_changed();
 }
 
 static AlgoRegister g_algoRegister;
@@ -220,9 +341,9 @@ static AlgoRegister g_algoRegister;
 extern "C" {
 #endif
 
-void register_add_algo(int id, const char* name)
+int register_add_algo(int id, const char* name)
 {
-    g_algoRegister.add_algo(id,name);
+    return g_algoRegister.add_algo(id,name);
 }
 const char *register_get_algo_name(int id)
 {
@@ -257,6 +378,15 @@ void register_init()
     g_algoRegister.register_dump();
  }
 
+// $(HDDLS_CVDL_MODEL_PATH)/<algoname>/libalgo<algoname>.so
+gchar *register_get_algo_library(const char *name)
+{
+    const gchar *env = g_getenv("HDDLS_CVDL_MODEL_PATH");
+    if(!env)
+        return NULL;
+    return g_strdup_printf("%s/%s/libalgo%s.so", env, name, name);
+}
+
 #ifdef __cplusplus
 };
 #endif
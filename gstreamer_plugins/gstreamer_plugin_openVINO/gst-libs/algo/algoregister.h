@@ -50,7 +50,8 @@ enum {
 
 #define ALGO_REGISTER_FILE_NAME  ".algocache.register"
 
-void register_add_algo(int id, const char* name);
+// return 0 on success, -1 if the algo exists or its library is invalid
+int register_add_algo(int id, const char* name);
 const char *register_get_algo_name(int id);
  int register_get_algo_id(const char *name);
  int register_get_free_algo_id();
@@ -59,6 +60,8 @@ void register_init();
  void register_write();
  void register_reset();
  void register_dump();
+// path of the library of a generic algo, free it with g_free()
+char *register_get_algo_library(const char *name);
  
 #ifdef __cplusplus
 };
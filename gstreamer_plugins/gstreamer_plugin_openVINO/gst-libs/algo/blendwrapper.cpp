@@ -142,7 +142,7 @@ static GstBuffer *generate_osd(BlendHandle handle, GstBuffer *input_buf)
     g_return_val_if_fail(osd_buf, NULL);
 
     cvdl_meta = gst_buffer_get_cvdl_meta(input_buf);
-    if(!cvdl_meta){
+    if(!cvdl_meta || !cvdl_meta->result){
         gst_buffer_unref(osd_buf);
         return NULL;
     }
@@ -165,8 +165,7 @@ static GstBuffer *generate_osd(BlendHandle handle, GstBuffer *input_buf)
     stream_ts << std::setfill('0') << std::setw(2) << hour << ":" << std::setfill('0') << std::setw(2) << minute << ":";
     stream_ts << std::setfill('0') << std::setw(2) << second << "." << std::setw(3) << ms;
 
-    InferenceMeta *inference_result = cvdl_meta->inference_result;
-    int meta_count = cvdl_meta->meta_count;
+    CvdlFrameResult *result = cvdl_meta->result;
     int i;
 #ifdef USE_OPENCV_3_4_x
     cv::Mat mdraw = osd_mem->frame.getMat(0);
@@ -177,8 +176,9 @@ static GstBuffer *generate_osd(BlendHandle handle, GstBuffer *input_buf)
     cv::rectangle(mdraw, cv::Rect(0,0,osd_mem->width, osd_mem->height), cv::Scalar(0, 0, 0, 0), cv::FILLED);
     cv::putText(mdraw, stream_ts.str(), cv::Point(10, 30), 1, 1.8, cv::Scalar(255, 0, 255, 255), 2);//RGBA
 
-    for(i=0;i<meta_count && inference_result;i++){
-
+    for(i=0;i<result->object_count;i++){
+        CvdlObject *inference_result = &result->objects[i];
+        const char *label = CVDL_FRAME_RESULT_LABEL(result, inference_result);
         VideoRect *rect = &inference_result->rect;
         std::string strTxt;
         // Create an output string stream
@@ -194,11 +194,11 @@ static GstBuffer *generate_osd(BlendHandle handle, GstBuffer *input_buf)
              (rect->width/(1.0+rect->height) > 3.0)  ||
              (rect->height/(1.0+rect->width) > 3.0)) {
              // Write label and probility
-            strTxt = std::string(inference_result->label) + std::string("[") + stream_prob.str() + std::string("]") ;
+            strTxt = std::string(label) + std::string("[") + stream_prob.str() + std::string("]") ;
              cv::putText(mdraw, strTxt, cv::Point( rect->x,  rect->y - 15), 1, 1.8, cv::Scalar(255 , 10, 255,255), 2);//RGBA
       } else {
              // Write label and probility
-            strTxt = std::string(inference_result->label);
+            strTxt = std::string(label);
             cv::putText(mdraw, strTxt, cv::Point(x, y), 1, 1.8, cv::Scalar(255, 0, 255, 255), 2);//RGBA
             strTxt = std::string("prob=") + stream_prob.str();
             cv::putText(mdraw, strTxt, cv::Point(x, y+30), 1, 1.8, cv::Scalar(255, 0, 255, 255), 2);//RGBA
@@ -209,9 +209,10 @@ static GstBuffer *generate_osd(BlendHandle handle, GstBuffer *input_buf)
         cv::rectangle(mdraw, target_rect, cv::Scalar(0, 255, 0, 255), 2);
 
         //std::vector<cv::Point> vecCPt;
-        VideoPoint *points = inference_result->track;
+        VideoPoint *points = CVDL_FRAME_RESULT_TRACK(result, inference_result);
         cv::Point lastPt, curPt, prePt;
-        prePt = cv::Point(points[0].x, points[0].y);
+        if(inference_result->track_count > 0)
+            prePt = cv::Point(points[0].x, points[0].y);
         for (int m = 1; m < inference_result->track_count; m++) {
             curPt = cv::Point(points[m].x, points[m].y);
             if (prePt.y > lastPt.y) {
@@ -222,12 +223,6 @@ static GstBuffer *generate_osd(BlendHandle handle, GstBuffer *input_buf)
             }
             prePt = curPt;
         }
-
-        inference_result = inference_result->next;
-    }
-    if(i!=meta_count) {
-        gst_buffer_unref(osd_buf);
-        return NULL;
     }
 
     return osd_buf;
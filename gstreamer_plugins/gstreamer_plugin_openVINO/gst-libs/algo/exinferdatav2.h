@@ -0,0 +1,91 @@
+/*
+ *Copyright (C) 2018 Intel Corporation
+ *
+ *SPDX-License-Identifier: LGPL-2.1-only
+ *
+ *This library is free software; you can redistribute it and/or modify it under the terms
+ * of the GNU Lesser General Public License as published by the Free Software Foundation;
+ * version 2.1.
+ *
+ *This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this library;
+ * if not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef __EX_INFERENCE_DATA_V2_H__
+#define __EX_INFERENCE_DATA_V2_H__
+
+// Version 2 ABI of generic algo library
+//
+// It is plain C, all memory is owned by the caller:
+//   - results are written into a caller-allocated arena, nothing to free
+//   - a whole frame or a N-batch blob is parsed in one call
+//   - post process edits the objects of a frame in place, by index
+// A v2 library exports ex_algo_abi_version() returning EX_ALGO_ABI_VERSION,
+// together with get_data_type(), get_mean_scale() and get_network_config() of v1.
+// Libraries without ex_algo_abi_version() are loaded as v1.
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EX_ALGO_ABI_VERSION 2
+
+// ExObject.flags
+#define EX_OBJECT_FLAG_REMOVED 0x1
+
+typedef struct _ExObject {
+    int id;
+    int objectClass;
+    float prob;
+    // static string owned by the library, or the label of the object passed in
+    const char *label;
+    // It is based on the orignal video frame
+    int x;
+    int y;
+    int w;
+    int h;
+    // which item of a N-batch blob it comes from
+    int batchIndex;
+    int flags;
+}ExObject;
+
+typedef struct _ExResultArena {
+    ExObject *objects;
+    // number of objects the arena can hold
+    int capacity;
+    // number of objects in the arena
+    int count;
+    // output index, for multiple output algo, default is 0
+    int outputIndex;
+    // number of objects not appended because the arena was full, the caller
+    // parses again with a larger arena if it is not 0
+    int dropped;
+}ExResultArena;
+
+// return EX_ALGO_ABI_VERSION
+int ex_algo_abi_version(void);
+
+// parse the inference data of batch_num items, and append the objects into arena,
+// the objects which don't fit are counted in arena->dropped
+// return the number of objects appended, -1 if failed
+int ex_parse_inference_batch(const void *in_data, int data_type, int data_len, int batch_num,
+                             int image_width, int image_height, ExResultArena *arena);
+
+// post process all objects of a frame in arena, mark an object with EX_OBJECT_FLAG_REMOVED to remove it
+// return 1  - something has been changed
+// return 0  - nothing has been changed
+int ex_post_process_objects(ExResultArena *arena);
+
+typedef int (*pfGetAbiVersionFunc)(void);
+typedef int (*pfInferenceBatchParseFunc)(const void *data, int type, int len, int batch_num,
+                                        int image_width, int image_height, ExResultArena *arena);
+typedef int (*pfPostProcessObjectsFunc)(ExResultArena *arena);
+
+#ifdef __cplusplus
+};
+#endif
+#endif
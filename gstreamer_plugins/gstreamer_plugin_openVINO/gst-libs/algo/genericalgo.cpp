@@ -25,6 +25,7 @@
 #include <dlfcn.h>
 #include "exinferdata.h"
 #include "genericalgo.h"
+#include "algoregister.h"
 
 
 using namespace HDDLStreamFilter;
@@ -39,6 +40,11 @@ static void post_callback(CvdlAlgoData *algoData)
     ExInferData exInferData;
     int ret = 0;
 
+    if(genericAlgo->mAbiVersion == EX_ALGO_ABI_VERSION) {
+        genericAlgo->post_process_objects(algoData);
+        return;
+    }
+
     //convert objData to exInferData
     for(guint i=0;i<objDataVec.size();i++) {
         ExObjectData exObjData;
@@ -78,16 +84,16 @@ static void post_callback(CvdlAlgoData *algoData)
 
 GenericAlgo::GenericAlgo(const char *name) : CvdlAlgoBase(post_callback, CVDL_TYPE_DL),
         mHandler(NULL), pfParser(NULL), pfPostProcess(NULL), pfGetType(NULL),
-        pfGetMS(NULL), pfGetNetworkConfig(NULL), mLoaded(false), inType(DataTypeInt8),
+        pfGetMS(NULL), pfGetNetworkConfig(NULL), mAbiVersion(1), pfParseBatch(NULL),
+        pfPostProcessObjects(NULL), mArenaGrown(false), mLoaded(false), inType(DataTypeInt8),
         outType(DataTypeFP32), mCurPts(0)
 {
     mName = std::string(name);
-    const gchar *env = g_getenv("HDDLS_CVDL_MODEL_PATH");
+    gchar *libName = register_get_algo_library(name);
     GST_INFO("Create generic algo name = %s\n", name);
-    if(env) {
-         // $(CVDL_MODEL_FULL_PATH)/<algoname>/libalgo<algoname>.so
-        mLibName = std::string(env) + std::string("/") + std::string(name) + std::string("/") 
-                            + std::string("libalgo") + std::string(name) + std::string(".so");
+    if(libName) {
+        mLibName = std::string(libName);
+        g_free(libName);
         mHandler = dlopen(mLibName.c_str(), RTLD_LAZY);
         if(!mHandler)
             g_print("Failed to dlopen %s\n", mLibName.c_str());
@@ -96,17 +102,29 @@ GenericAlgo::GenericAlgo(const char *name) : CvdlAlgoBase(post_callback, CVDL_TY
     }
 
     if(mHandler) {
-          pfParser  = (pfInferenceResultParseFunc)dlsym(mHandler, "parse_inference_result");
-          pfPostProcess  = (pfPostProcessInferenceDataFunc)dlsym(mHandler, "post_process_inference_data");
+          pfGetAbiVersionFunc pfGetAbiVersion = (pfGetAbiVersionFunc)dlsym(mHandler, "ex_algo_abi_version");
+          if(pfGetAbiVersion)
+              mAbiVersion = pfGetAbiVersion();
+          if(mAbiVersion == EX_ALGO_ABI_VERSION) {
+              pfParseBatch = (pfInferenceBatchParseFunc)dlsym(mHandler, "ex_parse_inference_batch");
+              pfPostProcessObjects = (pfPostProcessObjectsFunc)dlsym(mHandler, "ex_post_process_objects");
+              mArena.resize(GENERIC_ARENA_SIZE);
+          } else {
+              pfParser  = (pfInferenceResultParseFunc)dlsym(mHandler, "parse_inference_result");
+              pfPostProcess  = (pfPostProcessInferenceDataFunc)dlsym(mHandler, "post_process_inference_data");
+          }
           pfGetType = (pfGetDataTypeFunc)dlsym(mHandler, "get_data_type");
           pfGetMS = (pfGetMeanScaleFunc)dlsym(mHandler, "get_mean_scale");
           pfGetNetworkConfig = (pfGetNetworkConfigFunc)dlsym(mHandler,"get_network_config");
     }
 
-    if(pfParser && pfPostProcess &&  pfGetType && pfGetMS && pfGetNetworkConfig)
-        mLoaded = true;
+    if(mAbiVersion == EX_ALGO_ABI_VERSION)
+        mLoaded = pfParseBatch && pfPostProcessObjects;
+    else if(mAbiVersion == 1)
+        mLoaded = pfParser && pfPostProcess;
     else
-        mLoaded = false;
+        g_print("%s: unknown ABI version %d\n", mLibName.c_str(), mAbiVersion);
+    mLoaded = mLoaded && pfGetType && pfGetMS && pfGetNetworkConfig;
 }
 
 GenericAlgo::~GenericAlgo()
@@ -161,23 +179,69 @@ GstFlowReturn GenericAlgo::parse_inference_result(InferenceEngine::Blob::Ptr &re
 {
     GST_LOG("GenericAlgo::parse_inference_result begin: outData = %p\n", outData);
     auto resultBlobFp32 = std::dynamic_pointer_cast<InferenceEngine::TBlob<float> >(resultBlobPtr);
-    //void *paserResult = NULL;
-
-    if(!mLoaded)
+    if(!resultBlobFp32)
         return GST_FLOW_ERROR;
+    return parse_output(resultBlobFp32->data(), DataTypeFP32, resultBlobFp32->size(),
+                        resultBlobFp32->dims(), outData);
+}
 
-    float *input = static_cast<float*>(resultBlobFp32->data());
-    if (precision == sizeof(short)) {
-        GST_ERROR("Don't support FP16!");
+// The library gets the first output in the precision it asked by get_data_type(),
+// so a FP16/U8/I32 output is not converted.
+GstFlowReturn GenericAlgo::parse_inference_outputs(std::vector<IEOutput> &outputs,
+                                                   CvdlAlgoData *outData, int objId)
+{
+    IEOutput &output = outputs[0];
+    GST_LOG("GenericAlgo::parse_inference_outputs begin: outData = %p\n", outData);
+    return parse_output(output.blob->buffer().as<const void *>(), getExDataType(output.precision),
+                        output.blob->size(), output.blob->dims(), outData);
+}
+
+GstFlowReturn GenericAlgo::parse_output(const void *input, ExDataType type, int len,
+                                        const InferenceEngine::SizeVector &dims, CvdlAlgoData *outData)
+{
+    if(!mLoaded)
         return GST_FLOW_ERROR;
-    }
-    int len =  resultBlobFp32->size();
 
     //parse inference result and put them into algoData
     GST_LOG("input data = %p\n", input);
+    if(mAbiVersion == EX_ALGO_ABI_VERSION) {
+        // all items of the blob are parsed into the arena at once, batch is the last of dims
+        int batch = dims.size() > 0 ? (int)dims.back() : 1;
+        ExResultArena arena = {mArena.data(), (int)mArena.size(), 0, 0, 0};
+        if(pfParseBatch(input, type, len, batch, mImageProcessorInVideoWidth,
+                        mImageProcessorInVideoHeight, &arena) < 0) {
+            GST_ERROR("%s: failed to parse inference result!", mName.c_str());
+            return GST_FLOW_ERROR;
+        }
+        // the arena was too small, grow it and parse again
+        if(arena.dropped > 0) {
+            if(!mArenaGrown)
+                g_print("%s: result arena of %d objects is full, grow it to %d\n",
+                    mName.c_str(), arena.capacity, arena.count + arena.dropped);
+            mArenaGrown = true;
+            mArena.resize(arena.count + arena.dropped);
+            arena = {mArena.data(), (int)mArena.size(), 0, 0, 0};
+            if(pfParseBatch(input, type, len, batch, mImageProcessorInVideoWidth,
+                            mImageProcessorInVideoHeight, &arena) < 0) {
+                GST_ERROR("%s: failed to parse inference result!", mName.c_str());
+                return GST_FLOW_ERROR;
+            }
+            if(arena.dropped > 0)
+                GST_WARNING("%s: %d objects are dropped, the arena is still full",
+                    mName.c_str(), arena.dropped);
+        }
+        for(int i=0; i<arena.count && i<arena.capacity; i++) {
+            ObjectData objData;
+            exobject_2_objdata(arena.objects[i], objData);
+            outData->mObjectVec.push_back(objData);
+        }
+        outData->mOutputIndex = arena.outputIndex;
+        return GST_FLOW_OK;
+    }
+
     ExInferData *exInferData = NULL;
     if(pfParser) {
-        exInferData = pfParser(input, outType, len,mImageProcessorInVideoWidth,mImageProcessorInVideoHeight);
+        exInferData = pfParser(const_cast<void *>(input), type, len,mImageProcessorInVideoWidth,mImageProcessorInVideoHeight);
         //exInferData = std::dynamic_pointer_cast<ExInferData>(paserResult);
         // copy exInferData to  algoData->mObjectVec;
         for(guint i=0; i<exInferData->mObjectVec.size();i++) {
@@ -208,7 +272,7 @@ void GenericAlgo::objdata_2_exobjdata(ObjectData &objData,  ExObjectData &exObjD
     exObjData.id = objData.id;
     exObjData.objectClass = objData.objectClass;
     exObjData.prob= objData.prob;
-    exObjData.label= objData.label;
+    exObjData.label= objData.label.str();
     exObjData.x = objData.rect.x;
     exObjData.y = objData.rect.y;
     exObjData.w = objData.rect.width;
@@ -216,6 +280,89 @@ void GenericAlgo::objdata_2_exobjdata(ObjectData &objData,  ExObjectData &exObjD
 }
 
 
+void GenericAlgo::exobject_2_objdata(ExObject &exObj,  ObjectData &objData)
+{
+    objData.id = exObj.id;
+    objData.objectClass = exObj.objectClass ;
+    objData.prob = exObj.prob;
+    if(exObj.label)
+        objData.label = exObj.label;
+    objData.rect.x = exObj.x ;
+    objData.rect.y = exObj.y;
+    objData.rect.width = exObj.w;
+    objData.rect.height = exObj.h;
+}
+
+void GenericAlgo::objdata_2_exobject(ObjectData &objData,  ExObject &exObj)
+{
+    exObj.id = objData.id;
+    exObj.objectClass = objData.objectClass;
+    exObj.prob= objData.prob;
+    exObj.label= objData.label.c_str();
+    exObj.x = objData.rect.x;
+    exObj.y = objData.rect.y;
+    exObj.w = objData.rect.width;
+    exObj.h = objData.rect.height;
+    exObj.batchIndex = 0;
+    exObj.flags = 0;
+}
+
+// v2 ABI: objects are edited in place, the object at index i is still objDataVec[i],
+// so there is no search by id. Objects cannot be added in post process.
+void GenericAlgo::post_process_objects(CvdlAlgoData *algoData)
+{
+    std::vector<ObjectData> &objDataVec = algoData->mObjectVec;
+    guint i, n = 0;
+
+    if(mPostArena.size() < objDataVec.size())
+        mPostArena.resize(objDataVec.size());
+    for(i=0;i<objDataVec.size();i++)
+        objdata_2_exobject(objDataVec[i], mPostArena[i]);
+    ExResultArena arena = {mPostArena.data(), (int)objDataVec.size(), (int)objDataVec.size(),
+                           algoData->mOutputIndex, 0};
+
+    if(!pfPostProcessObjects(&arena))
+        return;
+
+    // remove the objects marked by the library
+    for(i=0;i<objDataVec.size();i++) {
+        ExObject &exObj = mPostArena[i];
+        if(exObj.flags & EX_OBJECT_FLAG_REMOVED)
+            continue;
+        // label points to objDataVec[i].label if it was not changed
+        bool labelChanged = exObj.label != objDataVec[i].label.c_str();
+        if(n != i)
+            objDataVec[n] = objDataVec[i];
+        if(!labelChanged)
+            exObj.label = NULL;
+        exobject_2_objdata(exObj, objDataVec[n]);
+        n++;
+    }
+    objDataVec.resize(n);
+    algoData->mOutputIndex = arena.outputIndex;
+}
+
+ExDataType GenericAlgo::getExDataType(InferenceEngine::Precision precision)
+{
+    switch(precision) {
+    case InferenceEngine::Precision::I8:
+        return DataTypeInt8;
+    case InferenceEngine::Precision::U8:
+        return DataTypeUint8;
+    case InferenceEngine::Precision::I16:
+        return DataTypeInt16;
+    case InferenceEngine::Precision::U16:
+        return DataTypeUint16;
+    case InferenceEngine::Precision::I32:
+        return DataTypeInt32;
+    case InferenceEngine::Precision::FP16:
+        return DataTypeFP16;
+    default:
+        break;
+    }
+    return DataTypeFP32;
+}
+
 InferenceEngine::Precision GenericAlgo::getIEPrecision(ExDataType type) 
 {
     switch(type) {
@@ -24,6 +24,10 @@
 #include <gst/gstbuffer.h>
 #include "mathutils.h"
 #include "exinferdata.h"
+#include "exinferdatav2.h"
+
+// initial number of objects in the result arena of v2 ABI
+#define GENERIC_ARENA_SIZE 256
 
 class GenericAlgo : public CvdlAlgoBase 
 {
@@ -34,12 +38,21 @@ public:
     virtual GstFlowReturn algo_dl_init(const char* modeFileName);
     virtual GstFlowReturn parse_inference_result(InferenceEngine::Blob::Ptr &resultBlobPtr,
                                                  int precision, CvdlAlgoData *outData, int objId);
+    virtual GstFlowReturn parse_inference_outputs(std::vector<IEOutput> &outputs,
+                                                  CvdlAlgoData *outData, int objId);
+    // parse one output of type into outData
+    GstFlowReturn parse_output(const void *input, ExDataType type, int len,
+                               const InferenceEngine::SizeVector &dims, CvdlAlgoData *outData);
     void set_default_label_name();
     void set_label_names(const char** label_names){mLabelNames = label_names;}
 
     void exobjdata_2_objdata(ExObjectData &exObjData,  ObjectData &objData);
     void objdata_2_exobjdata(ObjectData &objData,  ExObjectData &exObjData);
+    void exobject_2_objdata(ExObject &exObj,  ObjectData &objData);
+    void objdata_2_exobject(ObjectData &objData,  ExObject &exObj);
+    void post_process_objects(CvdlAlgoData *algoData);
     InferenceEngine::Precision getIEPrecision(ExDataType type) ;
+    ExDataType getExDataType(InferenceEngine::Precision precision);
 
     void *mHandler;
     pfInferenceResultParseFunc pfParser;
@@ -48,6 +61,17 @@ public:
     pfGetMeanScaleFunc pfGetMS;
     pfGetNetworkConfigFunc pfGetNetworkConfig;
 
+    // v2 ABI, it is used if the library exports ex_algo_abi_version()
+    int mAbiVersion;
+    pfInferenceBatchParseFunc pfParseBatch;
+    pfPostProcessObjectsFunc pfPostProcessObjects;
+    // result arena of v2 ABI, it is used with mAlgoDataMutex
+    std::vector<ExObject> mArena;
+    // arena of post process, it is only used in the algo thread
+    std::vector<ExObject> mPostArena;
+    // the arena has been grown, it is reported only once
+    bool mArenaGrown;
+
     bool mLoaded; // If dynamic library can be loaded
     std::string mLibName;
 
@@ -87,9 +87,8 @@ GstFlowReturn GoogleNetv2Algo::parse_inference_result(InferenceEngine::Blob::Ptr
             float prob = probBase[topIndexes[i]];
             if(prob < THRESHOLD_PROB)
                 continue;
-            std::string strLabel = g_vehicleLabel[topIndexes[i]];
             objData.prob = prob;
-            objData.label = strLabel;
+            objData.label = ObjectLabel::intern(g_vehicleLabel[topIndexes[i]].c_str());
             objData.objectClass =  topIndexes[i];
             outData->mObjectVec.push_back(objData);
             GST_LOG("GoogleNetv2Algo-%ld-%d-%ld: prob = %f, label = %s\n", 
@@ -25,6 +25,7 @@
 #include <gst/gstbuffer.h>
 #include <gst/gstpad.h>
 #include <gst/gstinfo.h>
+#include <sstream>
 #include "ieloader.h"
 #include "algobase.h"
 
@@ -48,11 +49,6 @@ if (InferenceEngine::OK != (call)) {                            \
     return GST_FLOW_ERROR;                                    \
 }
 
-#define IECALLNORETCHECK(call)                                       \
-if (InferenceEngine::OK != (call)) {                            \
-    std::cout << #call " failed: " << resp.msg << std::endl;    \
-}
-
 using namespace InferenceEngine;
 using namespace std;
 
@@ -101,6 +97,84 @@ static void data_norm_SSE(float* pfOut, unsigned char* pcInput,  int data_len, f
     }
 }
 
+// IEEE half precision, round to nearest even
+static uint16_t f32_to_f16(float value)
+{
+    uint32_t x, mant, half, rem;
+    int exp;
+
+    memcpy(&x, &value, sizeof(x));
+    uint32_t sign = (x >> 16) & 0x8000;
+    exp = (int)((x >> 23) & 0xff) - 127 + 15;
+    mant = x & 0x7fffff;
+    if(((x >> 23) & 0xff) == 0xff)
+        return sign | 0x7c00 | (mant ? 0x200 : 0);
+    if(exp >= 31)
+        return sign | 0x7c00;
+    if(exp <= 0) {
+        // subnormal
+        if(exp < -10)
+            return sign;
+        mant |= 0x800000;
+        int shift = 14 - exp;
+        half = mant >> shift;
+        rem = mant & ((1u << shift) - 1);
+        if(rem > (1u << (shift - 1)) || (rem == (1u << (shift - 1)) && (half & 1)))
+            half++;
+        return sign | half;
+    }
+    half = sign | (exp << 10) | (mant >> 13);
+    rem = mant & 0x1fff;
+    // a carry into the exponent is still right
+    if(rem > 0x1000 || (rem == 0x1000 && (half & 1)))
+        half++;
+    return half;
+}
+
+static float f16_to_f32(uint16_t half)
+{
+    uint32_t sign = (uint32_t)(half & 0x8000) << 16;
+    uint32_t exp = (half >> 10) & 0x1f;
+    uint32_t mant = half & 0x3ff;
+    uint32_t x;
+    float value;
+
+    if(exp == 0 && mant == 0) {
+        x = sign;
+    } else if(exp == 0) {
+        // subnormal
+        exp = 127 - 15 + 1;
+        while(!(mant & 0x400)) {
+            mant <<= 1;
+            exp--;
+        }
+        x = sign | (exp << 23) | ((mant & 0x3ff) << 13);
+    } else if(exp == 31) {
+        x = sign | 0x7f800000 | (mant << 13);
+    } else {
+        x = sign | ((exp - 15 + 127) << 23) | (mant << 13);
+    }
+    memcpy(&value, &x, sizeof(value));
+    return value;
+}
+
+// copy the planar image into the input blob, which is planar(NCHW) or interleaved(NHWC)
+template<typename T, typename F>
+static void planar_to_blob(T *dst, const unsigned char *src, int pixels, int channels,
+                           bool interleaved, F convert)
+{
+    if(!interleaved) {
+        for(int i = 0; i < pixels * channels; i++)
+            dst[i] = convert(src[i]);
+        return;
+    }
+    for(int c = 0; c < channels; c++) {
+        const unsigned char *plane = src + c * pixels;
+        for(int i = 0; i < pixels; i++)
+            dst[i * channels + c] = convert(plane[i]);
+    }
+}
+
 #if 0
 static void data_norm_C(float* pfOut, unsigned char* pcInput,  int data_len,  float scale, float mean)
  {
@@ -113,46 +187,110 @@ static void data_norm_C(float* pfOut, unsigned char* pcInput,  int data_len,  fl
 IELoader::IELoader()
 {
     mNeedSecondInputData = false;
+    mSecDataSrcPtr = NULL;
+    mSecDataSrcCount = 0;
+    mNetwork = NULL;
+    mWarmup = false;
+    mTargetDev = InferenceEngine::TargetDevice::eHDDL;
 }
 
 IELoader::~IELoader()
 {
-    //IE will be release automatically.
+    if(mNetwork) {
+        mNetwork->remove_stream(this);
+        IEService::get_instance()->release_network(mNetwork);
+        mNetwork = NULL;
+    }
 }
 
 
+// The plugin will be loaded with the network in IEService
 GstFlowReturn IELoader::set_device(InferenceEngine::TargetDevice dev)
 {
-    mTargetDev = dev;
     switch (dev) {
     case InferenceEngine::TargetDevice::eCPU:
-        mIEPlugin = InferenceEnginePluginPtr("libMKLDNNPlugin.so");
-        break;
     case InferenceEngine::TargetDevice::eGPU:
-        mIEPlugin = InferenceEnginePluginPtr("libclDNNPlugin.so");
-        break;
     case InferenceEngine::TargetDevice::eHDDL:
-        mIEPlugin = InferenceEnginePluginPtr(HDDL_PLUGIN);
-        break;
+        mTargetDev = dev;
+        return GST_FLOW_OK;
     default:
         g_print("Not support device [ %d ]\n", (int)dev);
         return GST_FLOW_ERROR;
-        break;
     }
-    if(mIEPlugin)
+}
+
+// Get the network from IEService, the IELoaders with the same model and config
+// share one network and its infer requests, even if they are in different cvdlfilters.
+GstFlowReturn IELoader::read_model(std::string strModelXml,
+        std::string strModelBin, int modelType, std::string network_config)
+{
+    std::ostringstream key;
+    key << (int)mTargetDev << ":" << strModelXml << ":" << modelType << ":" << network_config
+        << ":" << (int)mInputPrecision << ":" << (int)mOutputPrecision
+        << ":" << mNeedSecondInputData << ":" << mSecDataSrcCount << ":" << (int)mInputLayout;
+    for(auto &item : mOutputPrecisions)
+        key << ":" << item.first << "=" << (int)item.second;
+
+    if(mNetwork)
         return GST_FLOW_OK;
-    else
+
+    gint64 start = g_get_monotonic_time();
+    bool loaded = false;
+    mModelType = modelType;
+    mModelXml = strModelXml;
+    mModelBin = strModelBin;
+    mNetwork = IEService::get_instance()->acquire_network(key.str(),
+        [this, &loaded, strModelXml, strModelBin, modelType, network_config](IENetwork *network) {
+            loaded = true;
+            return load_network(network, strModelXml, strModelBin, modelType, network_config);
+        });
+    if(!mNetwork)
         return GST_FLOW_ERROR;
+
+    // startup record of this algo, a shared network costs nothing but the lookup
+    IEStartupStat stat = loaded ? mNetwork->mStartupStat : IEStartupStat();
+    g_print("IE startup: stream=%s model=%s shared=%d parse_xml=%ldms read_weights=%ldms"
+        " load_network=%ldms create_requests=%ldms warmup=%ldms total=%ldms\n",
+        mStreamName.empty() ? strModelXml.c_str() : mStreamName.c_str(), strModelXml.c_str(),
+        !loaded, stat.parseXml/1000, stat.readWeights/1000, stat.loadNetwork/1000,
+        stat.createRequests/1000, stat.warmup/1000, (g_get_monotonic_time() - start)/1000);
+
+    mOutputDim[0] = mNetwork->mOutputDim[0];
+    mOutputDim[1] = mNetwork->mOutputDim[1];
+    if(mStreamName.empty())
+        mStreamName = strModelXml;
+    mNetwork->add_stream(this);
+    return GST_FLOW_OK;
 }
-GstFlowReturn IELoader::read_model(std::string strModelXml,
+
+GstFlowReturn IELoader::load_network(IENetwork *network, std::string strModelXml,
         std::string strModelBin, int modelType, std::string network_config)
 {
     std::unique_lock<std::mutex> _lock(requestCreateMutex);
     std::string config_xml;
 
+    switch (mTargetDev) {
+    case InferenceEngine::TargetDevice::eCPU:
+        network->mIEPlugin = InferenceEnginePluginPtr("libMKLDNNPlugin.so");
+        break;
+    case InferenceEngine::TargetDevice::eGPU:
+        network->mIEPlugin = InferenceEnginePluginPtr("libclDNNPlugin.so");
+        break;
+    default:
+        network->mIEPlugin = InferenceEnginePluginPtr(HDDL_PLUGIN);
+        break;
+    }
+    if(!network->mIEPlugin) {
+        g_print("Failed to load plugin for device [ %d ]\n", (int)mTargetDev);
+        return GST_FLOW_ERROR;
+    }
+
     InferenceEngine::ResponseDesc resp;
     InferenceEngine::StatusCode ret = InferenceEngine::StatusCode::OK;
 
+    IEStartupStat &stat = network->mStartupStat;
+    gint64 t = g_get_monotonic_time();
+
     InferenceEngine::CNNNetReader netReader = InferenceEngine::CNNNetReader();
     netReader.ReadNetwork(strModelXml);
     if (!netReader.isParseSuccess()) {
@@ -160,6 +298,8 @@ GstFlowReturn IELoader::read_model(std::string strModelXml,
         return GST_FLOW_ERROR;
     }
     //g_print("Success to read %s\n", strModelXml.c_str());
+    stat.parseXml = g_get_monotonic_time() - t;
+    t += stat.parseXml;
 
     netReader.ReadWeights(strModelBin);
     if (!netReader.isParseSuccess()) {
@@ -167,6 +307,8 @@ GstFlowReturn IELoader::read_model(std::string strModelXml,
         return GST_FLOW_ERROR;
     }
     //g_print("Success to read %s\n", strModelBin.c_str());
+    stat.readWeights = g_get_monotonic_time() - t;
+    t += stat.readWeights;
 
     InferenceEngine::CNNNetwork cnnNetwork = netReader.getNetwork();
     InferenceEngine::InputsDataMap networkInputs;
@@ -178,15 +320,15 @@ GstFlowReturn IELoader::read_model(std::string strModelXml,
     auto inputInfo = networkInputs.begin();
     g_return_val_if_fail(inputInfo != networkInputs.end(), GST_FLOW_ERROR);
     inputInfo->second->setInputPrecision(mInputPrecision);
-    mFirstInputName = inputInfo->first;
-    inputInfo->second->setLayout(Layout::NCHW);//HW: NCHW, SW: NHWC
+    network->mFirstInputName = inputInfo->first;
+    inputInfo->second->setLayout(mInputLayout);//HW: NCHW, SW: NHWC
 
     if(mNeedSecondInputData) {
         inputInfo++;
         g_return_val_if_fail(inputInfo != networkInputs.end(), GST_FLOW_ERROR);
         inputInfo->second->setInputPrecision(mInputPrecision);
-        mSecondInputName = inputInfo->first;
-        GST_INFO("IE blobs second input name is %s\n", mSecondInputName.c_str());
+        network->mSecondInputName = inputInfo->first;
+        GST_INFO("IE blobs second input name is %s\n", network->mSecondInputName.c_str());
 
         //Improvement need: make it generic!
         auto secondInputDims = inputInfo->second->getDims();
@@ -196,20 +338,31 @@ GstFlowReturn IELoader::read_model(std::string strModelXml,
         }
     }
 
-    // Output data precision
+    // Output data precision, all outputs are kept for multi-head networks
     networkOutputs = cnnNetwork.getOutputsInfo();
     g_return_val_if_fail(!networkOutputs.empty(), GST_FLOW_ERROR);
-    auto firstOutputInfo = networkOutputs.begin();
-    g_return_val_if_fail(firstOutputInfo != networkOutputs.end(), GST_FLOW_ERROR);
-    firstOutputInfo->second->precision = mOutputPrecision;
-    mFirstOutputName = firstOutputInfo->first;
+    for(auto &item : mOutputPrecisions) {
+        if(networkOutputs.find(item.first) == networkOutputs.end()) {
+            g_print("No output %s in model %s\n", item.first.c_str(), strModelXml.c_str());
+            return GST_FLOW_ERROR;
+        }
+    }
+    for(auto &outputInfo : networkOutputs) {
+        auto precision = mOutputPrecisions.find(outputInfo.first);
+        IEOutputInfo info;
+        info.name = outputInfo.first;
+        info.precision = precision != mOutputPrecisions.end() ? precision->second : mOutputPrecision;
+        info.dims = outputInfo.second->dims;
+        outputInfo.second->precision = info.precision;
+        network->mOutputs.push_back(info);
+        GST_INFO("IE output %s, precision = %s", info.name.c_str(), info.precision.name());
+    }
+    network->mFirstOutputName = network->mOutputs[0].name;
 
-    InferenceEngine::OutputsDataMap outputInfo(cnnNetwork.getOutputsInfo());
-    auto outputInfoIter = outputInfo.begin();
-    if(outputInfoIter  != outputInfo.end()){
-        InferenceEngine::SizeVector outputDims = outputInfoIter->second->dims;
-         mOutputDim[1] = (int)outputDims[1]; 
-         mOutputDim[0] = (int)outputDims[0];
+    InferenceEngine::SizeVector &outputDims = network->mOutputs[0].dims;
+    if(outputDims.size() >= 2){
+         network->mOutputDim[1] = (int)outputDims[1];
+         network->mOutputDim[0] = (int)outputDims[0];
     }
 
     std::map<std::string, std::string> networkConfig;
@@ -217,7 +370,6 @@ GstFlowReturn IELoader::read_model(std::string strModelXml,
         = InferenceEngine::PluginConfigParams::LOG_INFO;
     networkConfig[VPU_CONFIG_KEY(HW_STAGES_OPTIMIZATION)] = CONFIG_VALUE(YES);
 
-    mModelType = modelType;
     switch(modelType) {
         case IE_MODEL_DETECTION:
             networkConfig[VPU_CONFIG_KEY(NETWORK_CONFIG)] = "data=data,scale=64";
@@ -241,17 +393,50 @@ GstFlowReturn IELoader::read_model(std::string strModelXml,
    }
 
     // Executable Network for inference engine
-    ret = mIEPlugin->LoadNetwork(mExeNetwork, cnnNetwork, networkConfig, &resp);
+    t = g_get_monotonic_time();
+    ret = network->mIEPlugin->LoadNetwork(network->mExeNetwork, cnnNetwork, networkConfig, &resp);
     if (InferenceEngine::StatusCode::OK != ret) {
         // GENERAL_ERROR = -1
         g_print("Failed to  LoadNetwork, ret_code = %d, models=%s\n", ret, strModelBin.c_str());
         return GST_FLOW_ERROR;
     }
+    stat.loadNetwork = g_get_monotonic_time() - t;
+    t += stat.loadNetwork;
+
+    // First create 16 request, they are shared by all streams of this network.
+    for (int r = 0; r < REQUEST_NUM; r++) {
+        IECALLCHECK(network->mExeNetwork->CreateInferRequest(network->mInferRequest[r], &resp));
+    }
+    stat.createRequests = g_get_monotonic_time() - t;
+    t += stat.createRequests;
+
+    if(mWarmup) {
+        if(warmup_network(network) != GST_FLOW_OK)
+            return GST_FLOW_ERROR;
+        stat.warmup = g_get_monotonic_time() - t;
+    }
+    return GST_FLOW_OK;
+}
+
+// The first inference of each request pays the lazy initialization of the device,
+// run it with zero input before the network is used by any stream.
+GstFlowReturn IELoader::warmup_network(IENetwork *network)
+{
+    InferenceEngine::ResponseDesc resp;
 
-    // First create 16 request for current thread.
     for (int r = 0; r < REQUEST_NUM; r++) {
-        IECALLCHECK(mExeNetwork->CreateInferRequest(mInferRequest[r], &resp));
-        mRequestEnable[r] = true;
+        InferenceEngine::Blob::Ptr inputBlobPtr;
+        IECALLCHECK(network->mInferRequest[r]->GetBlob(network->mFirstInputName.c_str(), inputBlobPtr, &resp));
+        memset(inputBlobPtr->buffer(), 0, inputBlobPtr->byteSize());
+        if(mNeedSecondInputData) {
+            IECALLCHECK(network->mInferRequest[r]->GetBlob(network->mSecondInputName.c_str(), inputBlobPtr, &resp));
+            memset(inputBlobPtr->buffer(), 0, inputBlobPtr->byteSize());
+        }
+        IECALLCHECK(network->mInferRequest[r]->StartAsync(&resp));
+    }
+    // all requests run together, as the device does with real frames
+    for (int r = 0; r < REQUEST_NUM; r++) {
+        IECALLCHECK(network->mInferRequest[r]->Wait(InferenceEngine::IInferRequest::WaitMode::RESULT_READY, &resp));
     }
     return GST_FLOW_OK;
 }
@@ -286,20 +471,27 @@ GstFlowReturn IELoader::convert_input_to_blob(const cv::UMat& img,
         return GST_FLOW_ERROR;
     }
 
+    // Src data has been converted to be BGR planar format
+    int nPixels = w * h * numBlobChannels;
+    bool interleaved = mInputLayout == InferenceEngine::Layout::NHWC && numBlobChannels > 1;
+    float mean = mInputMean, scale = mInputScale;
+
     if (InferenceEngine::Precision::U8 == mInputPrecision) {
         InferenceEngine::TBlob<unsigned char>::Ptr inputBlobDataPtr = 
             std::dynamic_pointer_cast<InferenceEngine::TBlob<unsigned char> >(inputBlobPtr);
         if (inputBlobDataPtr != nullptr) {
             unsigned char *inputDataPtr = inputBlobDataPtr->data();
-            // Src data has been converted to be BGR planar format
-            int nPixels = w * h * numBlobChannels;
             //for (int i = 0; i < nPixels; i++)
             //    inputDataPtr[i] = src.data[i];
             #if 0
             memcpy(inputDataPtr, src.data, nPixels*sizeof(char));
             #else
             unsigned char *src_buf = src.data;
-            std::copy(src_buf, src_buf + nPixels, inputDataPtr);
+            if(interleaved)
+                planar_to_blob(inputDataPtr, src_buf, w * h, numBlobChannels, true,
+                               [](unsigned char v) { return v; });
+            else
+                std::copy(src_buf, src_buf + nPixels, inputDataPtr);
             #endif
         }
     }else if(InferenceEngine::Precision::FP32 == mInputPrecision){
@@ -307,16 +499,23 @@ GstFlowReturn IELoader::convert_input_to_blob(const cv::UMat& img,
             std::dynamic_pointer_cast<InferenceEngine::TBlob<float> >(inputBlobPtr);
         if (inputBlobDataPtr != nullptr) {
             float *inputDataPtr = inputBlobDataPtr->data();
-
-            // Src data has been converted to be BGR planar format
-            int nPixels = w * h * numBlobChannels;
             #if 1
             // hot code, SSE optimized
-            data_norm_SSE(inputDataPtr, src.data, nPixels,  mInputScale, mInputMean);
+            if(interleaved)
+                planar_to_blob(inputDataPtr, src.data, w * h, numBlobChannels, true,
+                               [mean, scale](unsigned char v) { return ((float)v - mean) * scale; });
+            else
+                data_norm_SSE(inputDataPtr, src.data, nPixels,  mInputScale, mInputMean);
             #else
             data_norm_C(inputDataPtr, src.data, nPixels,  mInputScale, mInputMean);
             #endif
         }
+    }else if(InferenceEngine::Precision::FP16 == mInputPrecision){
+        // FP16 input halves the data copied to the device
+        uint16_t *inputDataPtr = inputBlobPtr->buffer().as<uint16_t *>();
+        g_return_val_if_fail(inputDataPtr, GST_FLOW_ERROR);
+        planar_to_blob(inputDataPtr, src.data, w * h, numBlobChannels, interleaved,
+                       [mean, scale](unsigned char v) { return f32_to_f16(((float)v - mean) * scale); });
     }else {
         GST_ERROR("InferenceEngine::Precision not support: %d", (int)mInputPrecision);
         return GST_FLOW_ERROR;
@@ -342,50 +541,27 @@ GstFlowReturn IELoader::second_input_to_blob(InferenceEngine::Blob::Ptr& inputBl
     //g_print("input sencond data!\n");
     return GST_FLOW_OK;
 }
-int IELoader::get_enable_request()
-{
-    std::unique_lock<std::mutex> lk(mRequstMutex);
-    int target_id = -1;
-
-    mCondVar.wait(lk, [this, &target_id]{
-        for(int i = 0; i< REQUEST_NUM; i++) {
-            if (mRequestEnable[i]) {
-                target_id = i;
-                return true;
-            }
-        }
-        return false;
-    });
-
-    if(target_id!=-1)
-        mRequestEnable[target_id] = false;
-    return target_id;
-}
-
-void IELoader::release_request(int reqestId)
-{
-    if(reqestId>=0) {
-        std::unique_lock<std::mutex> lk(mRequstMutex);
-        mRequestEnable[reqestId] = true;
-        mCondVar.notify_all();
-    }
-}
 GstFlowReturn IELoader::get_input_size(int *w, int *h, int *c)
 {
     GstFlowReturn ret = GST_FLOW_ERROR;
     InferenceEngine::ResponseDesc resp;
 
-    int reqestId = get_enable_request();
+    g_return_val_if_fail(mNetwork, GST_FLOW_ERROR);
+    int reqestId = mNetwork->get_enable_request();
     if(reqestId >= 0)
     {
-        InferenceEngine::IInferRequest::Ptr inferRequestAsyn = mInferRequest[reqestId];
+        InferenceEngine::IInferRequest::Ptr inferRequestAsyn = mNetwork->mInferRequest[reqestId];
         InferenceEngine::Blob::Ptr inputBlobPtr;
-        IECALLCHECK(inferRequestAsyn->GetBlob(mFirstInputName.c_str(), inputBlobPtr, &resp));
+        if(InferenceEngine::OK != inferRequestAsyn->GetBlob(mNetwork->mFirstInputName.c_str(), inputBlobPtr, &resp)) {
+            std::cout << "GetBlob failed: " << resp.msg << std::endl;
+            mNetwork->release_request(reqestId);
+            return GST_FLOW_ERROR;
+        }
         *w = (int)inputBlobPtr->dims()[0];
         *h = (int)inputBlobPtr->dims()[1];
         *c = (int)inputBlobPtr->dims()[2];
         ret = GST_FLOW_OK;
-        release_request(reqestId);
+        mNetwork->release_request(reqestId);
     } else {
         GST_ERROR("Cannot get valid requestid!!!\n");
     }
@@ -400,84 +576,83 @@ GstFlowReturn IELoader::get_out_size(int *outDim0, int *outDim1)
     return GST_FLOW_ERROR;
 }
 
-
-GstFlowReturn IELoader::do_inference_async(void *data, uint64_t frmId, int objId,
-                                                  cv::UMat &src, AsyncCallback cb)
+const std::vector<IEOutputInfo> &IELoader::get_outputs()
 {
-    InferenceEngine::ResponseDesc resp;
-    CvdlAlgoData *algoData = static_cast<CvdlAlgoData*> (data);
-
-    int reqestId = get_enable_request();
-    if(reqestId >= 0)
-    {
-        InferenceEngine::IInferRequest::Ptr inferRequestAsyn = mInferRequest[reqestId];
-        InferenceEngine::Blob::Ptr inputBlobPtr;
-        IECALLCHECK(inferRequestAsyn->GetBlob(mFirstInputName.c_str(), inputBlobPtr, &resp));
+    static const std::vector<IEOutputInfo> none;
+    return mNetwork ? mNetwork->mOutputs : none;
+}
 
-        // Load images.
-        if (src.empty()) {
-            g_print("input image empty!!!");
-            release_request(reqestId);
-            return GST_FLOW_ERROR;
-        }
-        convert_input_to_blob(src, inputBlobPtr);
+InferenceEngine::Blob::Ptr IELoader::output_to_fp32(const IEOutput &output)
+{
+    if(output.precision == InferenceEngine::Precision::FP32)
+        return output.blob;
+
+    InferenceEngine::TBlob<float>::Ptr blob =
+        std::dynamic_pointer_cast<InferenceEngine::TBlob<float>>(output.fp32);
+    if(!blob || blob->size() != output.blob->size()) {
+        GST_ERROR("Output %s has no FP32 blob to convert into", output.name.c_str());
+        return nullptr;
+    }
+    float *dst = blob->data();
+    size_t size = output.blob->size();
+
+    switch(output.precision) {
+    case InferenceEngine::Precision::FP16: {
+        const uint16_t *src = output.blob->buffer().as<const uint16_t *>();
+        for(size_t i = 0; i < size; i++)
+            dst[i] = f16_to_f32(src[i]);
+        break;
+    }
+    case InferenceEngine::Precision::U8: {
+        const unsigned char *src = output.blob->buffer().as<const unsigned char *>();
+        std::copy(src, src + size, dst);
+        break;
+    }
+    case InferenceEngine::Precision::I32: {
+        const int32_t *src = output.blob->buffer().as<const int32_t *>();
+        std::copy(src, src + size, dst);
+        break;
+    }
+    default:
+        GST_ERROR("Output %s: precision %s is not supported", output.name.c_str(),
+                  output.precision.name());
+        return nullptr;
+    }
+    return blob;
+}
 
-        // set data for second input blob
-        if(mNeedSecondInputData) {
-            InferenceEngine::Blob::Ptr inputBlobPtrSecond;
-            IECALLCHECK(inferRequestAsyn->GetBlob(mSecondInputName.c_str(), inputBlobPtrSecond, &resp));
-            if (!inputBlobPtrSecond){
-                release_request(reqestId);
-                g_print("inputBlobPtrSecond is null!\n");
-                return GST_FLOW_ERROR;
-            }
-            second_input_to_blob(inputBlobPtrSecond);
-         }
+void IELoader::drop_jobs()
+{
+    if(mNetwork)
+        mNetwork->drop_jobs(this);
+}
 
-        algoData->ie_start = g_get_monotonic_time();
-        // send a request
-        IECALLCHECK(inferRequestAsyn->StartAsync(&resp));
-
-        // Start thread listen to result
-        auto WaitAsync = [this, algoData, frmId, objId, cb](InferenceEngine::IInferRequest::Ptr inferRequestAsyn, int reqestId)
-        {
-            //CvdlAlgoBase *algo;
-            InferenceEngine::ResponseDesc resp;
-            IECALLNORETCHECK(inferRequestAsyn->Wait(InferenceEngine::IInferRequest::WaitMode::RESULT_READY, &resp));
-            algoData->ie_duration = g_get_monotonic_time() - algoData->ie_start;
-            int duration = algoData->ie_duration/1000;
-            GST_INFO("%s: IE wait for %d ms\n", algoData->algoBase->mName.c_str(), duration);
-            InferenceEngine::Blob::Ptr resultBlobPtr;
-            IECALLNORETCHECK(inferRequestAsyn->GetBlob(mFirstOutputName.c_str(), resultBlobPtr, &resp));
-
-            if (this->mOutputPrecision == InferenceEngine::Precision::FP32)
-            {
-                CvdlAlgoBase *algo = algoData->algoBase;
-                GST_LOG("WaitAsync - do_inference_async begin: algo = %p(%p), algoData = %p\n",
-                    algo, algoData->algoBase, algoData);
-                //avoid race condition when push object
-                algo->mAlgoDataMutex.lock();
-                algo->parse_inference_result(resultBlobPtr, sizeof(float), algoData, objId);
-                algo->mAlgoDataMutex.unlock();
-                GST_LOG("WaitAsync - do_inference_async finish: algo = %p(%p), algoData = %p\n",
-                    algo,algoData->algoBase, algoData);
-            } else {
-                GST_ERROR("Don't support other output precision except FP32!");
-                release_request(reqestId);
-                return;
-            }
-            GST_LOG("Got inference result: frmId = %ld",frmId);
-            // put result into out_queue
-            cb(algoData);
-            release_request(reqestId);
-        };
+bool IELoader::get_oldest_request(int *reqestId, gint64 *age)
+{
+    gint64 start = 0;
+    if(!mNetwork || !mNetwork->get_oldest_request(this, reqestId, &start))
+        return false;
+    *age = g_get_monotonic_time() - start;
+    return true;
+}
 
-        //WaitAsync(inferRequestAsyn, reqestId);
-        std::thread t1(WaitAsync, inferRequestAsyn, reqestId);
-        t1.detach();
-    }
 
-    return GST_FLOW_OK;
+// Submit the job to the network in IEService, it will be put into a infer request
+// when it is the turn of this stream.
+GstFlowReturn IELoader::do_inference_async(void *data, uint64_t frmId, int objId,
+                                                  cv::UMat &src, AsyncCallback cb, GstBuffer *srcBuf)
+{
+    g_return_val_if_fail(mNetwork, GST_FLOW_ERROR);
+
+    IEJob job;
+    job.loader = this;
+    job.algoData = data;
+    job.frmId = frmId;
+    job.objId = objId;
+    job.src = src;
+    job.srcBuf = srcBuf;
+    job.cb = cb;
+    return mNetwork->submit(job);
 }
 
 GstFlowReturn IELoader::do_inference_sync(void *data, uint64_t frmId, int objId,
@@ -487,16 +662,17 @@ GstFlowReturn IELoader::do_inference_sync(void *data, uint64_t frmId, int objId,
     InferenceEngine::ResponseDesc resp;
     CvdlAlgoData *algoData = static_cast<CvdlAlgoData*> (data);
 
-    int reqestId = get_enable_request();
+    g_return_val_if_fail(mNetwork, GST_FLOW_ERROR);
+    int reqestId = mNetwork->get_enable_request();
     if(reqestId >= 0)
     {
-        InferenceEngine::IInferRequest::Ptr inferRequestSync = mInferRequest[reqestId];
+        InferenceEngine::IInferRequest::Ptr inferRequestSync = mNetwork->mInferRequest[reqestId];
         InferenceEngine::Blob::Ptr inputBlobPtr;
-        IECALLCHECK(inferRequestSync->GetBlob(mFirstInputName.c_str(), inputBlobPtr, &resp));
+        inferRequestSync->GetBlob(mNetwork->mFirstInputName.c_str(), inputBlobPtr, &resp);
 
         // Load images.
-        if (src.empty()) {
-            release_request(reqestId);
+        if (!inputBlobPtr || src.empty()) {
+            mNetwork->release_request(reqestId);
             GST_ERROR("input image empty!!!");
             return GST_FLOW_ERROR;
         }
@@ -504,9 +680,9 @@ GstFlowReturn IELoader::do_inference_sync(void *data, uint64_t frmId, int objId,
          // set data for second input blob
         if(mNeedSecondInputData) {
             InferenceEngine::Blob::Ptr inputBlobPtrSecond;
-            IECALLCHECK(inferRequestSync->GetBlob(mSecondInputName.c_str(), inputBlobPtrSecond, &resp));
+            inferRequestSync->GetBlob(mNetwork->mSecondInputName.c_str(), inputBlobPtrSecond, &resp);
             if (!inputBlobPtrSecond){
-                release_request(reqestId);
+                mNetwork->release_request(reqestId);
                 g_print("inputBlobPtrSecond is null!\n");
                 return GST_FLOW_ERROR;
             }
@@ -514,14 +690,16 @@ GstFlowReturn IELoader::do_inference_sync(void *data, uint64_t frmId, int objId,
          }
          ret = inferRequestSync->Infer(&resp);
          if (ret == InferenceEngine::StatusCode::OK){
-                InferenceEngine::Blob::Ptr resultBlobPtr;
-                ret = inferRequestSync->GetBlob(mFirstOutputName.c_str(), resultBlobPtr, &resp);
-                if(ret == InferenceEngine::StatusCode::OK && resultBlobPtr){
+                std::vector<IEOutput> outputs;
+                if(mNetwork->get_outputs(reqestId, outputs) == GST_FLOW_OK){
                     CvdlAlgoBase *algo = algoData->algoBase;
-                    algo->parse_inference_result(resultBlobPtr, sizeof(float), algoData, objId);
+                    // same as the async path, streams share the algo parser
+                    algo->mAlgoDataMutex.lock();
+                    algo->parse_inference_outputs(outputs, algoData, objId);
+                    algo->mAlgoDataMutex.unlock();
                 }
             }
-            release_request(reqestId);
+            mNetwork->release_request(reqestId);
         }
         return GST_FLOW_OK;
 }
@@ -27,6 +27,8 @@
 #include <condition_variable>
 #include <opencv2/opencv.hpp>
 #include <inference_engine.hpp>
+#include "ieservice.h"
+#include "algoplacement.h"
 
 
 #ifndef CVDL_MODEL_DIR_DEFAULT
@@ -35,7 +37,6 @@
 #endif
 
 #define CHECK(X) if(!(X)){ GST_ERROR("CHECK ERROR!"); std::exit(EXIT_FAILURE); }
-#define REQUEST_NUM 16
 
 
 enum{
@@ -49,8 +50,6 @@ enum{
     IE_MODEL_LP_NONE
 };
 
-using AsyncCallback = std::function<void(void* algoData)>;
-
 class IELoader {
 public:
     IELoader();
@@ -60,18 +59,56 @@ public:
     GstFlowReturn read_model(std::string strModelXml, std::string strModelBin, int modelType, std::string network_config);
     GstFlowReturn convert_input_to_blob(const cv::UMat& img, InferenceEngine::Blob::Ptr& inputBlobPtr);
     GstFlowReturn second_input_to_blob(InferenceEngine::Blob::Ptr& inputBlobPtr);
+    // srcBuf is the buffer of src, it will be held until src is put into infer request
     GstFlowReturn do_inference_async(void *algoData, uint64_t frmId, int objId,
-                                            cv::UMat &src, AsyncCallback cb);
+                                            cv::UMat &src, AsyncCallback cb, GstBuffer *srcBuf=NULL);
     GstFlowReturn do_inference_sync(void *data, uint64_t frmId, int objId,
                                                   cv::UMat &src);
     GstFlowReturn get_input_size(int *w, int *h, int *c);
     GstFlowReturn get_out_size(int *outDim0, int *outDim1);
+    // complete the jobs of this stream which have not been put into infer requests
+    void drop_jobs();
+    // the oldest running infer request of this stream and its age(us), return false if none
+    bool get_oldest_request(int *reqestId, gint64 *age);
     // must be called before read_model()
     void set_precision(InferenceEngine::Precision in, InferenceEngine::Precision out)
     {
         mInputPrecision = in;
         mOutputPrecision = out;
     }
+    // precision of a named output, the other outputs use the output precision of
+    // set_precision(), must be called before read_model()
+    void set_output_precision(std::string name, InferenceEngine::Precision precision)
+    {
+        mOutputPrecisions[name] = precision;
+    }
+    // layout of the first input, NCHW for planar or NHWC for interleaved data,
+    // must be called before read_model()
+    void set_input_layout(InferenceEngine::Layout layout)
+    {
+        mInputLayout = layout;
+    }
+    // outputs of the network, it is valid after read_model()
+    const std::vector<IEOutputInfo> &get_outputs();
+    // a FP32 copy of a FP16/U8/I32 output in output.fp32, or the blob itself if it is FP32,
+    // return nullptr if the precision is not supported
+    static InferenceEngine::Blob::Ptr output_to_fp32(const IEOutput &output);
+    // run a synthetic inference on every request after the network is loaded,
+    // must be called before read_model()
+    void set_warmup(bool enable)
+    {
+        mWarmup = enable;
+    }
+    // name of this stream in the statistic of inference service
+    void set_stream_name(std::string name)
+    {
+        mStreamName = name;
+    }
+    // CPUs of the threads which parse the inference results of this stream
+    void set_placement(const AlgoPlacement &placement)
+    {
+        mPlacement = placement;
+    }
     void set_second_input(bool enable, void *data, int count, InferenceEngine::Precision precision) {
         mNeedSecondInputData = enable;
         mSecDataSrcPtr = data;
@@ -91,9 +128,11 @@ public:
     InferenceEngine::TargetDevice mTargetDev;
     InferenceEngine::Precision mInputPrecision = InferenceEngine::Precision::U8;
     InferenceEngine::Precision mOutputPrecision = InferenceEngine::Precision::FP32;
+    std::map<std::string, InferenceEngine::Precision> mOutputPrecisions;
+    InferenceEngine::Layout mInputLayout = InferenceEngine::Layout::NCHW;
 
     // mean/scale for input, which is used convert u8 image data to float data
-    // make sure mInputPrecision=InferenceEngine::Precision::FP32
+    // make sure mInputPrecision=InferenceEngine::Precision::FP32 or FP16
     float mInputMean;
     float mInputScale;
     void set_mean_and_scale(float mean, float scale)
@@ -101,26 +140,20 @@ public:
           mInputMean = mean;
           mInputScale = scale;
     }
+    std::string mStreamName;
+    AlgoPlacement mPlacement;
 private:
-    int get_enable_request();
-    void release_request(int reqestId);
+    GstFlowReturn load_network(IENetwork *network, std::string strModelXml, std::string strModelBin,
+                                        int modelType, std::string network_config);
+    GstFlowReturn warmup_network(IENetwork *network);
+
+    bool mWarmup;
 
     std::string mModelXml;
     std::string mModelBin;
 
-    InferenceEngine::InferenceEnginePluginPtr mIEPlugin; // plugin must be first so it would be last in the destruction order
-    InferenceEngine::IExecutableNetwork::Ptr  mExeNetwork;
-
-    std::string mFirstInputName;
-    std::string mFirstOutputName;
-    std::string mSecondInputName;
-
-    std::mutex mRequstMutex;
-    std::condition_variable mCondVar;
-   
-    // <request, used or not>
-    InferenceEngine::IInferRequest::Ptr mInferRequest[REQUEST_NUM];
-    bool mRequestEnable[REQUEST_NUM] = {true};
+    // shared with other IELoaders of the same model by IEService
+    IENetwork *mNetwork;
 };
 
 #endif
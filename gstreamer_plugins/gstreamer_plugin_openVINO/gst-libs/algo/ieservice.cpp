@@ -0,0 +1,407 @@
+/*
+ *Copyright (C) 2018 Intel Corporation
+ *
+ *SPDX-License-Identifier: LGPL-2.1-only
+ *
+ *This library is free software; you can redistribute it and/or modify it under the terms
+ * of the GNU Lesser General Public License as published by the Free Software Foundation;
+ * version 2.1.
+ *
+ *This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this library;
+ * if not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <iostream>
+#include <gst/gstbuffer.h>
+#include <gst/gstinfo.h>
+#include "ieservice.h"
+#include "ieloader.h"
+#include "algobase.h"
+
+#define IECALLNORETCHECK(call)                                       \
+if (InferenceEngine::OK != (call)) {                            \
+    std::cout << #call " failed: " << resp.msg << std::endl;    \
+}
+
+IENetwork::IENetwork(std::string key) : mKey(key), mRefCount(1), mRequestFree(0),
+    mLastStream(NULL), mStarted(false), mStop(false)
+{
+    mOutputDim[0] = mOutputDim[1] = 0;
+    mStartupStat = IEStartupStat();
+    for (int r = 0; r < REQUEST_NUM; r++) {
+        mRequestEnable[r] = false;
+        mRequestStart[r] = 0;
+        mRequestOwner[r] = NULL;
+    }
+}
+
+IENetwork::~IENetwork()
+{
+    if(mStarted) {
+        std::unique_lock<std::mutex> lk(mMutex);
+        // wait all requests finished
+        mStop = true;
+        mCondVar.wait(lk, [this]{ return mRequestFree >= REQUEST_NUM; });
+    }
+    //IE will be release automatically.
+}
+
+// Requests have been created, start to run jobs
+void IENetwork::start()
+{
+    std::unique_lock<std::mutex> lk(mMutex);
+    for (int r = 0; r < REQUEST_NUM; r++)
+        mRequestEnable[r] = true;
+    mRequestFree = REQUEST_NUM;
+    mStarted = true;
+}
+
+int IENetwork::get_enable_request()
+{
+    std::unique_lock<std::mutex> lk(mMutex);
+    int target_id = -1;
+
+    mCondVar.wait(lk, [this, &target_id]{
+        for(int i = 0; i< REQUEST_NUM; i++) {
+            if (mRequestEnable[i]) {
+                target_id = i;
+                return true;
+            }
+        }
+        return false;
+    });
+
+    if(target_id!=-1) {
+        mRequestEnable[target_id] = false;
+        mRequestFree--;
+    }
+    return target_id;
+}
+
+void IENetwork::free_request(int reqestId)
+{
+    std::unique_lock<std::mutex> lk(mMutex);
+    mRequestEnable[reqestId] = true;
+    mRequestStart[reqestId] = 0;
+    mRequestOwner[reqestId] = NULL;
+    mRequestFree++;
+    mCondVar.notify_all();
+}
+
+// the pending jobs get the request
+void IENetwork::release_request(int reqestId)
+{
+    if(reqestId>=0) {
+        free_request(reqestId);
+        run_jobs();
+    }
+}
+
+void IENetwork::add_stream(IELoader *loader)
+{
+    std::unique_lock<std::mutex> lk(mMutex);
+    IEStreamStat &stat = mStreamStats[loader];
+    stat.inferNum = 0;
+    stat.startTime = stat.lastTime = g_get_monotonic_time();
+}
+
+void IENetwork::drop_jobs(IELoader *loader)
+{
+    std::deque<IEJob> jobs;
+
+    std::unique_lock<std::mutex> lk(mMutex);
+    auto it = mJobQueues.find(loader);
+    if(it != mJobQueues.end())
+        jobs.swap(it->second);
+    lk.unlock();
+
+    if(jobs.size()>0)
+        g_print("IEService: drop %ld jobs of %s\n", jobs.size(), loader->mStreamName.c_str());
+    // the algo counts them as done, so that it doesn't wait for them
+    for(auto &job : jobs) {
+        job.src.release();
+        if(job.srcBuf)
+            gst_buffer_unref(job.srcBuf);
+        job.cb(job.algoData, true);
+    }
+}
+
+void IENetwork::remove_stream(IELoader *loader)
+{
+    // the algo has dropped its jobs when it stopped, this is for the rest
+    drop_jobs(loader);
+
+    std::unique_lock<std::mutex> lk(mMutex);
+    mJobQueues.erase(loader);
+    if(mLastStream == loader)
+        mLastStream = NULL;
+
+    auto st = mStreamStats.find(loader);
+    if(st != mStreamStats.end()) {
+        IEStreamStat &stat = st->second;
+        gint64 duration = stat.lastTime - stat.startTime;
+        g_print("IEService: %s - %ld inferences in %ld ms, %.2f infer/s\n",
+            loader->mStreamName.c_str(), stat.inferNum, duration/1000,
+            stat.inferNum * 1000000.0 / (duration + 1));
+        mStreamStats.erase(st);
+    }
+}
+
+bool IENetwork::get_oldest_request(IELoader *loader, int *reqestId, gint64 *start)
+{
+    std::unique_lock<std::mutex> lk(mMutex);
+    bool found = false;
+    for(int i = 0; i < REQUEST_NUM; i++) {
+        if(mRequestOwner[i] != loader || mRequestStart[i] == 0)
+            continue;
+        if(!found || mRequestStart[i] < *start) {
+            *reqestId = i;
+            *start = mRequestStart[i];
+            found = true;
+        }
+    }
+    return found;
+}
+
+GstFlowReturn IENetwork::submit(IEJob &job)
+{
+    std::unique_lock<std::mutex> lk(mMutex);
+    if(mStop)
+        return GST_FLOW_ERROR;
+    if(job.srcBuf)
+        gst_buffer_ref(job.srcBuf);
+    mJobQueues[job.loader].push_back(job);
+    lk.unlock();
+
+    run_jobs();
+    return GST_FLOW_OK;
+}
+
+// Get the job of next stream after mLastStream, so that each stream gets requests in turn
+// with mMutex
+bool IENetwork::pop_job(IEJob &job)
+{
+    auto it = mLastStream ? mJobQueues.upper_bound(mLastStream) : mJobQueues.begin();
+    for(size_t i = 0; i < mJobQueues.size(); i++, it++) {
+        if(it == mJobQueues.end())
+            it = mJobQueues.begin();
+        if(!it->second.empty()) {
+            job = it->second.front();
+            it->second.pop_front();
+            mLastStream = it->first;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Put pending jobs of all streams into free requests one by one. Only the hand-out of
+// requests is under mMutex, the input of a job is converted by the calling thread, so
+// the streams which submit jobs or finish requests at the same time do it in parallel.
+void IENetwork::run_jobs()
+{
+    IEJob job;
+    int reqestId;
+
+    while(true) {
+        std::unique_lock<std::mutex> lk(mMutex);
+        if(mRequestFree<=0 || !pop_job(job))
+            break;
+        for(reqestId = 0; reqestId < REQUEST_NUM; reqestId++) {
+            if (mRequestEnable[reqestId])
+                break;
+        }
+        mRequestEnable[reqestId] = false;
+        mRequestStart[reqestId] = g_get_monotonic_time();
+        mRequestOwner[reqestId] = job.loader;
+        mRequestFree--;
+        lk.unlock();
+
+        start_job(reqestId, job);
+    }
+}
+
+void IENetwork::start_job(int reqestId, IEJob &job)
+{
+    InferenceEngine::ResponseDesc resp;
+    InferenceEngine::IInferRequest::Ptr inferRequestAsyn = mInferRequest[reqestId];
+    CvdlAlgoData *algoData = static_cast<CvdlAlgoData*> (job.algoData);
+    IELoader *loader = job.loader;
+    GstFlowReturn ret = GST_FLOW_ERROR;
+
+    InferenceEngine::Blob::Ptr inputBlobPtr;
+    if(InferenceEngine::OK != inferRequestAsyn->GetBlob(mFirstInputName.c_str(), inputBlobPtr, &resp)) {
+        g_print("Failed to get input blob: %s\n", resp.msg);
+    } else if (job.src.empty()) {
+        g_print("input image empty!!!");
+    } else {
+        ret = loader->convert_input_to_blob(job.src, inputBlobPtr);
+    }
+
+    // set data for second input blob
+    if(ret == GST_FLOW_OK && loader->mNeedSecondInputData) {
+        InferenceEngine::Blob::Ptr inputBlobPtrSecond;
+        inferRequestAsyn->GetBlob(mSecondInputName.c_str(), inputBlobPtrSecond, &resp);
+        if (!inputBlobPtrSecond){
+            g_print("inputBlobPtrSecond is null!\n");
+            ret = GST_FLOW_ERROR;
+        } else {
+            ret = loader->second_input_to_blob(inputBlobPtrSecond);
+        }
+    }
+
+    // input data has been copied into the request
+    job.src.release();
+    if(job.srcBuf)
+        gst_buffer_unref(job.srcBuf);
+    job.srcBuf = NULL;
+
+    if(ret == GST_FLOW_OK) {
+        algoData->ie_start = g_get_monotonic_time();
+        // send a request
+        if(InferenceEngine::OK != inferRequestAsyn->StartAsync(&resp)) {
+            g_print("StartAsync failed: %s\n", resp.msg);
+            ret = GST_FLOW_ERROR;
+        }
+    }
+
+    // The object is done without result, otherwise the algo will wait for it forever
+    if(ret != GST_FLOW_OK) {
+        job.cb(algoData, false);
+        free_request(reqestId);
+        return;
+    }
+
+    // Start thread listen to result
+    AsyncCallback cb = job.cb;
+    int objId = job.objId;
+    uint64_t frmId = job.frmId;
+    AlgoPlacement placement = loader->mPlacement;
+    auto WaitAsync = [this, loader, algoData, frmId, objId, cb, placement](InferenceEngine::IInferRequest::Ptr inferRequestAsyn, int reqestId)
+    {
+        InferenceEngine::ResponseDesc resp;
+        // the result is parsed and pushed to next algo in this thread
+        placement.apply();
+        IECALLNORETCHECK(inferRequestAsyn->Wait(InferenceEngine::IInferRequest::WaitMode::RESULT_READY, &resp));
+        algoData->ie_duration = g_get_monotonic_time() - algoData->ie_start;
+        int duration = algoData->ie_duration/1000;
+        GST_INFO("%s: IE wait for %d ms\n", algoData->algoBase->mName.c_str(), duration);
+        std::vector<IEOutput> outputs;
+        if (get_outputs(reqestId, outputs) == GST_FLOW_OK)
+        {
+            CvdlAlgoBase *algo = algoData->algoBase;
+            //avoid race condition when push object
+            algo->mAlgoDataMutex.lock();
+            algo->parse_inference_outputs(outputs, algoData, objId);
+            algo->mAlgoDataMutex.unlock();
+        } else {
+            GST_ERROR("Failed to get the outputs of request %d!", reqestId);
+        }
+        GST_LOG("Got inference result: frmId = %ld",frmId);
+
+        mMutex.lock();
+        auto st = mStreamStats.find(loader);
+        if(st != mStreamStats.end()) {
+            st->second.inferNum++;
+            st->second.lastTime = g_get_monotonic_time();
+        }
+        mMutex.unlock();
+
+        // put result into out_queue
+        cb(algoData, false);
+        release_request(reqestId);
+    };
+
+    std::thread t1(WaitAsync, inferRequestAsyn, reqestId);
+    t1.detach();
+}
+
+// all outputs of a finished request, so that a multi-head network is parsed in one pass
+GstFlowReturn IENetwork::get_outputs(int reqestId, std::vector<IEOutput> &outputs)
+{
+    InferenceEngine::ResponseDesc resp;
+    InferenceEngine::IInferRequest::Ptr &request = mInferRequest[reqestId];
+    // only the thread holding the request uses its FP32 blobs
+    std::vector<InferenceEngine::Blob::Ptr> &fp32Blobs = mOutputFp32[reqestId];
+
+    outputs.clear();
+    fp32Blobs.resize(mOutputs.size());
+    for(size_t i = 0; i < mOutputs.size(); i++) {
+        IEOutputInfo &info = mOutputs[i];
+        IEOutput output;
+        output.name = info.name;
+        output.precision = info.precision;
+        if(InferenceEngine::OK != request->GetBlob(info.name.c_str(), output.blob, &resp)
+           || !output.blob) {
+            g_print("Failed to get output blob %s: %s\n", info.name.c_str(), resp.msg);
+            outputs.clear();
+            return GST_FLOW_ERROR;
+        }
+        // allocated by the first inference of the request
+        if(info.precision != InferenceEngine::Precision::FP32) {
+            if(!fp32Blobs[i] || fp32Blobs[i]->size() != output.blob->size()) {
+                fp32Blobs[i] = InferenceEngine::make_shared_blob<float>(
+                    InferenceEngine::Precision::FP32, output.blob->dims());
+                fp32Blobs[i]->allocate();
+            }
+            output.fp32 = fp32Blobs[i];
+        }
+        outputs.push_back(output);
+    }
+    return outputs.empty() ? GST_FLOW_ERROR : GST_FLOW_OK;
+}
+
+IEService *IEService::get_instance()
+{
+    static IEService service;
+    return &service;
+}
+
+IENetwork *IEService::acquire_network(std::string key, std::function<GstFlowReturn(IENetwork *)> load)
+{
+    std::unique_lock<std::mutex> lk(mMutex);
+    // the same model is being loaded by another stream, wait for it
+    mLoadCond.wait(lk, [this, &key]{ return mLoading.find(key) == mLoading.end(); });
+    auto it = mNetworks.find(key);
+    if(it != mNetworks.end()) {
+        it->second->mRefCount++;
+        return it->second;
+    }
+
+    // loading a model takes seconds, the streams of other networks go on
+    mLoading.insert(key);
+    lk.unlock();
+
+    IENetwork *network = new IENetwork(key);
+    if(load(network) != GST_FLOW_OK) {
+        delete network;
+        network = NULL;
+    } else {
+        network->start();
+    }
+
+    lk.lock();
+    mLoading.erase(key);
+    if(network)
+        mNetworks[key] = network;
+    mLoadCond.notify_all();
+    return network;
+}
+
+void IEService::release_network(IENetwork *network)
+{
+    if(!network)
+        return;
+
+    std::unique_lock<std::mutex> lk(mMutex);
+    if(--network->mRefCount > 0)
+        return;
+    mNetworks.erase(network->mKey);
+    lk.unlock();
+
+    delete network;
+}
@@ -0,0 +1,170 @@
+/*
+ *Copyright (C) 2018 Intel Corporation
+ *
+ *SPDX-License-Identifier: LGPL-2.1-only
+ *
+ *This library is free software; you can redistribute it and/or modify it under the terms
+ * of the GNU Lesser General Public License as published by the Free Software Foundation;
+ * version 2.1.
+ *
+ *This library is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY;
+ * without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License along with this library;
+ * if not, write to the Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef __IE_SERVICE_H__
+#define __IE_SERVICE_H__
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <gst/gst.h>
+#include <opencv2/opencv.hpp>
+#include <inference_engine.hpp>
+
+#define REQUEST_NUM 16
+
+class IELoader;
+// dropped: the job was not run, e.g. its stream is stopping
+using AsyncCallback = std::function<void(void* algoData, bool dropped)>;
+
+// An inference job submitted by an algo of a cvdlfilter
+struct IEJob {
+    IELoader *loader;
+    void *algoData;
+    uint64_t frmId;
+    int objId;
+    cv::UMat src;
+    // hold the buffer of src until it has been put into the request
+    GstBuffer *srcBuf;
+    AsyncCallback cb;
+};
+
+// A named output of the network
+struct IEOutputInfo {
+    std::string name;
+    InferenceEngine::Precision precision;
+    InferenceEngine::SizeVector dims;
+};
+
+// A named output of an inference result
+struct IEOutput {
+    std::string name;
+    InferenceEngine::Precision precision;
+    InferenceEngine::Blob::Ptr blob;
+    // FP32 blob of the request which a non-FP32 blob is converted into, it is
+    // reused by every inference of the request, nullptr if blob is FP32
+    InferenceEngine::Blob::Ptr fp32;
+};
+
+// Inference statistic of one stream(IELoader) on a network
+struct IEStreamStat {
+    guint64 inferNum;
+    gint64 startTime;
+    gint64 lastTime;
+};
+
+// Time(us) of each phase to load a network
+struct IEStartupStat {
+    gint64 parseXml;
+    gint64 readWeights;
+    gint64 loadNetwork;
+    gint64 createRequests;
+    gint64 warmup;
+};
+
+// A loaded network and its infer requests, which is shared by all IELoaders
+// with the same model and config in this process.
+class IENetwork {
+public:
+    IENetwork(std::string key);
+    ~IENetwork();
+
+    int get_enable_request();
+    void release_request(int reqestId);
+
+    // jobs of all streams are put into requests round robin, by the threads which
+    // submit jobs or release requests
+    GstFlowReturn submit(IEJob &job);
+    void add_stream(IELoader *loader);
+    void remove_stream(IELoader *loader);
+    // complete the jobs of loader which have not been started, as dropped
+    void drop_jobs(IELoader *loader);
+    void start();
+    // the oldest running request of loader, return false if it has none
+    bool get_oldest_request(IELoader *loader, int *reqestId, gint64 *start);
+    // get the blobs of all outputs of a finished request, they are valid until it is released
+    GstFlowReturn get_outputs(int reqestId, std::vector<IEOutput> &outputs);
+
+    std::string mKey;
+    int mRefCount;
+
+    InferenceEngine::InferenceEnginePluginPtr mIEPlugin;
+    InferenceEngine::IExecutableNetwork::Ptr  mExeNetwork;
+    InferenceEngine::IInferRequest::Ptr mInferRequest[REQUEST_NUM];
+    // FP32 blobs of the non-FP32 outputs of each request, by the index in mOutputs
+    std::vector<InferenceEngine::Blob::Ptr> mOutputFp32[REQUEST_NUM];
+
+    std::string mFirstInputName;
+    std::string mFirstOutputName;
+    std::string mSecondInputName;
+    int mOutputDim[2];
+    // all outputs in the order of the network, the first one is mFirstOutputName
+    std::vector<IEOutputInfo> mOutputs;
+
+    // filled by the IELoader which loads this network
+    IEStartupStat mStartupStat;
+
+private:
+    void run_jobs();
+    bool pop_job(IEJob &job);
+    void start_job(int reqestId, IEJob &job);
+    // release a request without running pending jobs
+    void free_request(int reqestId);
+
+    std::mutex mMutex;
+    std::condition_variable mCondVar;
+    bool mRequestEnable[REQUEST_NUM];
+    int mRequestFree;
+    // when a request was started and which stream it runs for, for stall detection
+    gint64 mRequestStart[REQUEST_NUM];
+    IELoader *mRequestOwner[REQUEST_NUM];
+
+    // pending jobs of each stream, and the stream got the last request
+    std::map<IELoader *, std::deque<IEJob>> mJobQueues;
+    std::map<IELoader *, IEStreamStat> mStreamStats;
+    IELoader *mLastStream;
+
+    bool mStarted;
+    bool mStop;
+};
+
+// Process-wide inference service, the algos of all cvdlfilters share the networks
+// and infer requests of the same model by it.
+class IEService {
+public:
+    static IEService *get_instance();
+
+    // Get the network with the key, call load() to create it if it doesn't exist
+    IENetwork *acquire_network(std::string key, std::function<GstFlowReturn(IENetwork *)> load);
+    void release_network(IENetwork *network);
+
+private:
+    IEService() {}
+    std::mutex mMutex;
+    std::map<std::string, IENetwork *> mNetworks;
+    // keys of the networks being loaded, they are loaded without mMutex
+    std::set<std::string> mLoading;
+    std::condition_variable mLoadCond;
+};
+
+#endif
@@ -142,6 +142,10 @@ GstFlowReturn ImageProcessor::process_image_crc(GstBuffer* inbuf,
 {
     VideoDisplayID display;
 
+    /* NV12 frame in system memory, it has no VASurface */
+    if(!gst_buffer_get_mfx_meta(inbuf))
+        return process_image_crc_host(inbuf, outbuf, crop);
+
     /* Input data must be NV12 surface from mfxdec element */
     mSrcFrame->fourcc = video_format_to_va_fourcc (GST_VIDEO_INFO_FORMAT (&mInVideoInfo));
     mSrcFrame->surface= gst_get_mfx_surface (inbuf, &mInVideoInfo, &display);
@@ -187,6 +191,83 @@ GstFlowReturn ImageProcessor::process_image_crc(GstBuffer* inbuf,
     return GST_FLOW_ERROR;
 }
 
+/* CRC on CPU for NV12 frame in system memory, such as the synthetic frames of cvdl-bench.
+ * The output is the same as OclVppCrc: BGR, BGR_Plannar or Gray
+ */
+GstFlowReturn ImageProcessor::process_image_crc_host(GstBuffer* inbuf,
+    GstBuffer** outbuf, VideoRect *crop)
+{
+    GstVideoFrame frame;
+    int width  = mInVideoInfo.width;
+    int height = mInVideoInfo.height;
+
+    *outbuf = NULL;
+    if (GST_VIDEO_INFO_FORMAT (&mInVideoInfo) != GST_VIDEO_FORMAT_NV12) {
+        GST_ERROR ("Only support NV12 input in system memory!");
+        return GST_FLOW_ERROR;
+    }
+
+    // NV12 crop must be aligned to 2
+    int x = MIN ((int)crop->x & ~1, width - 2);
+    int y = MIN ((int)crop->y & ~1, height - 2);
+    int w = MAX (MIN ((int)crop->width, width - x) & ~1, 2);
+    int h = MAX (MIN ((int)crop->height, height - y) & ~1, 2);
+
+    if (!gst_video_frame_map (&frame, &mInVideoInfo, inbuf, GST_MAP_READ)) {
+        GST_ERROR ("Failed to map NV12 frame!");
+        return GST_FLOW_ERROR;
+    }
+
+    // copy the crop into a continuous NV12 image
+    cv::Mat nv12(h * 3 / 2, w, CV_8UC1);
+    guint8 *yPlane  = (guint8 *)GST_VIDEO_FRAME_PLANE_DATA (&frame, 0);
+    guint8 *uvPlane = (guint8 *)GST_VIDEO_FRAME_PLANE_DATA (&frame, 1);
+    int yStride  = GST_VIDEO_FRAME_PLANE_STRIDE (&frame, 0);
+    int uvStride = GST_VIDEO_FRAME_PLANE_STRIDE (&frame, 1);
+    for (int i = 0; i < h; i++)
+        memcpy (nv12.ptr(i), yPlane + (y + i) * yStride + x, w);
+    for (int i = 0; i < h / 2; i++)
+        memcpy (nv12.ptr(h + i), uvPlane + (y / 2 + i) * uvStride + x, w);
+    gst_video_frame_unmap (&frame);
+
+    GstBuffer *out_buf = NULL;
+    OclMemory *out_mem = NULL;
+    if (!(out_buf = ocl_buffer_alloc (mPool)))
+        return GST_FLOW_ERROR;
+    out_mem = ocl_memory_acquire (out_buf);
+    if (!out_mem) {
+        GST_ERROR ("Failed to acquire ocl memory from outbuf");
+        gst_buffer_unref (out_buf);
+        return GST_FLOW_ERROR;
+    }
+
+    int outWidth  = mOutVideoInfo.width;
+    int outHeight = mOutVideoInfo.height;
+    cv::Mat src, resized;
+    if (mOclFormat == CRC_FORMAT_GRAY)
+        src = nv12.rowRange(0, h);
+    else
+        cv::cvtColor (nv12, src, cv::COLOR_YUV2BGR_NV12);
+    cv::resize (src, resized, cv::Size(outWidth, outHeight));
+
+    {
+        cv::Mat dst = out_mem->frame.getMat (cv::ACCESS_WRITE);
+        if (mOclFormat == CRC_FORMAT_BGR_PLANNAR) {
+            // B, G, R planes one by one
+            std::vector<cv::Mat> planes;
+            for (int c = 0; c < 3; c++)
+                planes.push_back (cv::Mat(outHeight, outWidth, CV_8UC1,
+                                          dst.ptr() + c * outWidth * outHeight));
+            cv::split (resized, planes);
+        } else {
+            resized.copyTo (dst);
+        }
+    }
+
+    *outbuf = out_buf;
+    return GST_FLOW_OK;
+}
+
 /* blend cvdl osd onto orignal NV12 surface
  *    input: osd buffer
  *   *output: nv12 video buffer
@@ -78,6 +78,7 @@ public:
 private:
     void setup_ocl_context(VideoDisplayID display);
     GstFlowReturn process_image_crc(GstBuffer* inbuf, GstBuffer** outbuf, VideoRect *crop);
+    GstFlowReturn process_image_crc_host(GstBuffer* inbuf, GstBuffer** outbuf, VideoRect *crop);
     GstFlowReturn process_image_blend(GstBuffer* inbuf, GstBuffer* inbuf2, GstBuffer** outbuf, VideoRect *rect);
 
     VideoDisplayID mDisplay;
@@ -107,7 +107,7 @@ static void post_callback(CvdlAlgoData *algoData)
     algoData->mObjectVec.clear();
     for(unsigned int i=0; i<objectVecCp.size();i++) {
          objItem =  objectVecCp[i];
-        objItem.label=std::string("vehicle");
+        objItem.label = ObjectLabel::intern("vehicle");
         objItem.prob = 1.0;
         algoData->mObjectVec.push_back(objItem);//car
     
@@ -136,7 +136,7 @@ bool MobileNetSSDAlgo::get_result(float * box,CvdlAlgoData* &outData)
         ObjectData object;
         object.id = objectNum;
         object.objectClass = label;
-        object.label = std::string(labelName);
+        object.label = ObjectLabel::intern(labelName);
         object.prob = confidence;
         object.rect = cv::Rect(xmin, ymin, xmax - xmin + 1, ymax - ymin + 1);
         object.rectROI = cv::Rect(-1,-1,-1,-1); //for License Plate
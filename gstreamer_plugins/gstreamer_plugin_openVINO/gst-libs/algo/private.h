@@ -25,15 +25,15 @@
 #define LOG_DIR "~/hddls_log/"
 
 // Each algo in the algo chain can link to multiple downstream algo
-// Here we set 2 by default
-#define MAX_DOWN_STREAM_ALGO_NUM 2
+// Here we set 4 by default
+#define MAX_DOWN_STREAM_ALGO_NUM 4
 
-// PIPELINE can output multiple output,  one output with one buffer_queue
-// Here we set 1
-#define MAX_PIPELINE_OUT_NUM 1
+// PIPELINE can output multiple output, every output is a branch which
+// will be joined by SinkAlgo
+#define MAX_PIPELINE_OUT_NUM 4
 
 // SinkAlgo item can accept multiple preItem, one is a algo branch
-#define MAX_PRE_SINK_ALGO_NUM 2
+#define MAX_PRE_SINK_ALGO_NUM MAX_PIPELINE_OUT_NUM
 
 
 const static guint CVDL_OBJECT_FLAG_DONE =0x1;
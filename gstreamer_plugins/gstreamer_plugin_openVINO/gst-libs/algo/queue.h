@@ -23,6 +23,7 @@
 #include <thread>
 #include <mutex>
 #include <deque>
+#include <chrono>
 #include <condition_variable>
 
 template<class T>
@@ -55,6 +56,8 @@ public:
             return false;
         });
 
+        // a flush wakes up one get only
+        _flush = false;
         if ((int)_q.size() > _max_size) {
             _max_size = _q.size();
         }
@@ -80,6 +83,54 @@ public:
         return get(ret, [](const T &) {return true;});
     }
 
+    // wait at most timeout_ms for an element, return false if timeout
+    bool get_for(T &ret, int timeout_ms)
+    {
+        std::unique_lock<std::mutex> lk(_m);
+
+        _cv.wait_for(lk, std::chrono::milliseconds(timeout_ms), [this]
+        {
+            if(_closed) return true;
+            if(_flush) {
+                    _flush = false;
+                    return true;
+            }
+            return !_q.empty();
+        });
+
+        _flush = false;
+        if (_q.empty() || _closed) {
+            return false;
+        }
+
+        if ((int)_q.size() > _max_size) {
+            _max_size = _q.size();
+        }
+
+        ret = _q.front();
+        _q.pop_front();
+        _cv_notfull.notify_all();
+        return true;
+    }
+
+    // get the front element without waiting, return false if it is empty
+    bool try_get(T &ret)
+    {
+        std::unique_lock<std::mutex> lk(_m);
+
+        if (_q.empty() || _closed) {
+            return false;
+        }
+
+        if ((int)_q.size() > _max_size) {
+            _max_size = _q.size();
+        }
+
+        ret = _q.front();
+        _q.pop_front();
+        _cv_notfull.notify_all();
+        return true;
+    }
 
     void put(const T & obj)
     {
@@ -113,6 +164,17 @@ public:
         _cv.notify_all();
     }
 
+    // call func with the front element under lock, return false if it is empty
+    template<class Func>
+    bool peek_front(Func func)
+    {
+        std::unique_lock<std::mutex> lk(_m);
+        if(_q.empty())
+            return false;
+        func(_q.front());
+        return true;
+    }
+
     int size(void){
         std::unique_lock<std::mutex> lk(_m);
         return _q.size();
@@ -22,6 +22,7 @@
   *   It is the last algoitem of algopipeline
   */
 
+#include <algorithm>
 #include "sinkalgo.h"
 #include <ocl/oclmemory.h>
 #include <ocl/crcmeta.h>
@@ -29,7 +30,8 @@
 
 using namespace HDDLStreamFilter;
 
-SinkAlgo::SinkAlgo():CvdlAlgoBase(NULL, CVDL_TYPE_NONE)
+SinkAlgo::SinkAlgo():CvdlAlgoBase(NULL, CVDL_TYPE_NONE), mNextFrameId(0),
+    mReorderTime(0), mEosPending(false), mOutFrameNum(0), mLateFrameNum(0)
 {
     mName = std::string(ALGO_SINK_NAME);
 }
@@ -37,6 +39,11 @@ SinkAlgo::SinkAlgo():CvdlAlgoBase(NULL, CVDL_TYPE_NONE)
 SinkAlgo::~SinkAlgo()
 {
     CvdlAlgoData *algoData = NULL;
+    std::map<guint64, ReorderItem>::iterator it;
+
+    if(mReorderTime > 0)
+        g_print("SinkAlgo: output %d frames, dropped %d late frames\n", mOutFrameNum, mLateFrameNum);
+
     while(mInQueue.size()>0)  {
             mInQueue.get(algoData);
             if(algoData->mGstBuffer) {
@@ -45,10 +52,155 @@ SinkAlgo::~SinkAlgo()
             algoData->mObjectVec.clear();
             delete algoData;
     }
+
+    for(it = mReorderMap.begin(); it != mReorderMap.end(); ++it) {
+        algoData = it->second.algoData;
+        if(algoData) {
+            gst_buffer_unref(algoData->mGstBuffer);
+            delete algoData;
+        }
+    }
+    mReorderMap.clear();
+    mArrivals.clear();
 }
 
-// dequeue a buffer with cvdlMeta data
-GstBuffer* SinkAlgo::dequeue_buffer()
+void SinkAlgo::skip_frame(guint64 frameId)
+{
+    if(mReorderTime <= 0)
+        return;
+    reorder_push(frameId, NULL);
+
+    // wake up dequeue_buffer, which may be holding frames for this one
+    mInQueue.flush();
+}
+
+void SinkAlgo::reorder_push(guint64 frameId, CvdlAlgoData *algoData)
+{
+    std::unique_lock<std::mutex> lk(mReorderMutex);
+
+    // the frames after it have been output, drop it to keep the output in order
+    if(frameId < mNextFrameId) {
+        if(algoData) {
+            GST_LOG("SinkAlgo: drop late frame %ld\n", frameId);
+            gst_buffer_unref(algoData->mGstBuffer);
+            delete algoData;
+            mLateFrameNum++;
+        }
+        return;
+    }
+
+    ReorderItem item = {algoData, g_get_monotonic_time()};
+    auto it = mReorderMap.find(frameId);
+    if(it != mReorderMap.end())
+        mArrivals.erase(std::make_pair(it->second.arrivalTime, frameId));
+    mReorderMap[frameId] = item;
+    mArrivals.insert(std::make_pair(item.arrivalTime, frameId));
+}
+
+void SinkAlgo::reorder_erase(std::map<guint64, ReorderItem>::iterator it)
+{
+    mArrivals.erase(std::make_pair(it->second.arrivalTime, it->first));
+    mReorderMap.erase(it);
+}
+
+// get the next frame in mFrameId order, if the oldest frame has been held for more than
+// mReorderTime, then give up waiting for the missing frames before it.
+CvdlAlgoData *SinkAlgo::reorder_pop(bool flush)
+{
+    std::unique_lock<std::mutex> lk(mReorderMutex);
+    std::map<guint64, ReorderItem>::iterator it;
+    CvdlAlgoData *algoData = NULL;
+    gint64 oldest, now = g_get_monotonic_time();
+
+    while(!mReorderMap.empty()) {
+        it = mReorderMap.begin();
+        if(it->first == mNextFrameId) {
+            algoData = it->second.algoData;
+            reorder_erase(it);
+            mNextFrameId++;
+            if(algoData)
+                return algoData;
+            continue;
+        }
+
+        oldest = mArrivals.begin()->first;
+        if(!flush && now - oldest < mReorderTime)
+            break;
+        GST_LOG("SinkAlgo: give up waiting for frame %ld - %ld\n",
+            mNextFrameId, mReorderMap.begin()->first - 1);
+        mNextFrameId = mReorderMap.begin()->first;
+    }
+    return NULL;
+}
+
+// how long(ms) to wait for a new frame before checking the deadline of held frames
+int SinkAlgo::reorder_wait_time()
+{
+    std::unique_lock<std::mutex> lk(mReorderMutex);
+    gint64 oldest, now = g_get_monotonic_time();
+
+    if(mReorderMap.empty())
+        return 100;
+
+    oldest = mArrivals.begin()->first;
+    return (oldest + mReorderTime - now) / 1000 + 1;
+}
+
+// Pack all objects of a frame into one CvdlFrameResult, class labels are passed as ids,
+// free text labels are copied into the frame result
+CvdlFrameResult *SinkAlgo::create_frame_result(std::vector<ObjectData> &objectVec)
+{
+    unsigned int color = 0x00FF00;
+    int trackTotal = 0, labelSize = 0;
+    unsigned int i;
+
+    if(objectVec.size()==0)
+        return NULL;
+
+    for(i=0; i<objectVec.size(); i++) {
+        trackTotal += std::min((int)objectVec[i].trajectoryPoints.size(), MAX_TRAJECTORY_POINTS_NUM);
+        if(objectVec[i].label.id() == CVDL_LABEL_NONE && objectVec[i].label.size() > 0)
+            labelSize += objectVec[i].label.size() + 1;
+    }
+
+    CvdlFrameResult *result = cvdl_frame_result_new(objectVec.size(), trackTotal, labelSize);
+
+    int offset = 0;
+    // offset 0 of labels is the empty label
+    int labelOffset = 1;
+    for(i=0; i<objectVec.size(); i++) {
+        ObjectData &objData = objectVec[i];
+        CvdlObject *object = &result->objects[i];
+        int count = std::min((int)objData.trajectoryPoints.size(), MAX_TRAJECTORY_POINTS_NUM);
+
+        object->probility = objData.prob;
+        object->rect.x = objData.rect.x;
+        object->rect.y = objData.rect.y;
+        object->rect.width = objData.rect.width;
+        object->rect.height = objData.rect.height;
+        object->color = color;
+        object->label_id = objData.label.id();
+        if(object->label_id == CVDL_LABEL_NONE && objData.label.size() > 0) {
+            object->label_offset = labelOffset;
+            memcpy(result->labels + labelOffset, objData.label.c_str(), objData.label.size() + 1);
+            labelOffset += objData.label.size() + 1;
+        }
+        object->track_offset = offset;
+        object->track_count = count;
+        std::copy(objData.trajectoryPoints.begin(), objData.trajectoryPoints.begin() + count,
+                  result->tracks + offset);
+        offset += count;
+        //debug
+        GST_LOG("%d - sinkalgo_output-%d: prob = %f, label = %s, rect=(%d,%d)-(%dx%d)\n",
+                mFrameDoneNum, i, objData.prob, objData.label.c_str(),
+                objData.rect.x, objData.rect.y, objData.rect.width, objData.rect.height);
+    }
+    return result;
+}
+
+// dequeue a buffer with cvdlMeta data, NULL with *eos = TRUE means the EOS buffer
+// was got, other NULL is a timeout
+GstBuffer* SinkAlgo::dequeue_buffer(gboolean *eos)
 {
     GstBuffer* buf = NULL;
     CvdlAlgoData *algoData = NULL;
@@ -56,59 +208,68 @@ GstBuffer* SinkAlgo::dequeue_buffer()
 
     while(true)
     {
-        if(!mInQueue.get(algoData)) {
+        if(mReorderTime > 0) {
+            algoData = reorder_pop(mEosPending);
+            if(algoData)
+                break;
+            if(mEosPending) {
+                mEosPending = false;
+                *eos = TRUE;
+                return NULL;
+            }
+            if(!mInQueue.get_for(algoData, reorder_wait_time()))
+                return NULL;
+        } else if(!mInQueue.get(algoData)) {
             std::this_thread::sleep_for(std::chrono::milliseconds(100));
             return NULL;
         }
+        mLastDequeue = g_get_monotonic_time();
         // Send an invalid buffer for quit this task
         if(algoData->mGstBuffer==NULL) {
             g_print("%s() - got EOS buffer!\n",__func__);
             delete algoData;
+            // output the held frames before EOS
+            if(mReorderTime > 0) {
+                mEosPending = true;
+                continue;
+            }
+            *eos = TRUE;
             return NULL;
         }
-        if(algoData->mObjectVec.size()>0)
+        // join all branches of this frame, wait until the last branch is done
+        if(algoData->mJoin) {
+            algoData = algo_data_join(algoData);
+            if(!algoData)
+                continue;
+        }
+        if(algoData->mObjectVec.size()==0) {
+            if(mReorderTime > 0)
+                reorder_push(algoData->mFrameId, NULL);
+            gst_buffer_unref(algoData->mGstBuffer);
+            delete algoData;
+            continue;
+        }
+        if(mReorderTime <= 0)
             break;
+        reorder_push(algoData->mFrameId, algoData);
     }
+    mOutFrameNum++;
     buf = algoData->mGstBuffer;
     GST_LOG("cvdlfilter-dequeue: buf = %p(%d)\n", algoData->mGstBuffer,
         GST_MINI_OBJECT_REFCOUNT(algoData->mGstBuffer));
 
-    // put object data as meta data
-    VideoSurfaceID surface;
-    VideoDisplayID display;
-    unsigned int color = 0x00FF00;
-    surface= gst_get_mfx_surface (buf, NULL, &display);
-
-    for(unsigned int i=0; i<algoData->mObjectVec.size(); i++) {
-        VideoRect rect;
-        std::vector<VideoPoint> &trajectoryPoints 
-            = algoData->mObjectVec[i].trajectoryPoints;
-        VideoPoint points[MAX_TRAJECTORY_POINTS_NUM];
-        int count = trajectoryPoints.size();
-        if(count>MAX_TRAJECTORY_POINTS_NUM)
-            count = MAX_TRAJECTORY_POINTS_NUM;
-        for(int i=0; i<count; i++)
-            points[i] = trajectoryPoints[i];
-        rect.x     = algoData->mObjectVec[i].rect.x;
-        rect.y     = algoData->mObjectVec[i].rect.y;
-        rect.width = algoData->mObjectVec[i].rect.width;
-        rect.height= algoData->mObjectVec[i].rect.height;
-        if(i==0)
-            meta_data =
-            cvdl_meta_create(display, surface, &rect, algoData->mObjectVec[i].label.c_str(), 
-                             algoData->mObjectVec[i].prob, color, points, count);
-        else
-            cvdl_meta_add (meta_data, &rect, algoData->mObjectVec[i].label.c_str(),
-                            algoData->mObjectVec[i].prob, color, points, count);
-        //debug
-        GST_LOG("%d - sinkalgo_output-%ld-%d: prob = %f, label = %s, rect=(%d,%d)-(%dx%d)\n", 
-                mFrameDoneNum, algoData->mFrameId,i,algoData->mObjectVec[i].prob,
-                algoData->mObjectVec[i].label.c_str(),
-                rect.x, rect.y, rect.width, rect.height);
-    }
+    if(mLatencyStat)
+        record_latency(algoData);
+
+    // put object data as meta data, a frame in system memory has no surface
+    VideoSurfaceID surface = INVALID_SURFACE_ID;
+    VideoDisplayID display = 0;
+    if(gst_buffer_get_mfx_meta(buf))
+        surface= gst_get_mfx_surface (buf, NULL, &display);
 
-    if(meta_data) {
-        ((CvdlMeta *)meta_data)->meta_count = algoData->mObjectVec.size();
+    CvdlFrameResult *result = create_frame_result(algoData->mObjectVec);
+    if(result) {
+        meta_data = cvdl_meta_create(display, surface, result);
         gst_buffer_set_cvdl_meta(buf, (CvdlMeta *)meta_data);
     }
     delete algoData;
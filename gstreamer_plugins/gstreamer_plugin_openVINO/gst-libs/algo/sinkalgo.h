@@ -19,16 +19,19 @@
 #define __SINK_ALGO_H__
 
 #include <vector>
+#include <map>
+#include <set>
 #include "algobase.h"
 #include <gst/gstbuffer.h>
 #include "algopipeline.h"
+#include <ocl/metadata.h>
 
 class SinkAlgo : public CvdlAlgoBase 
 {
 public:
     SinkAlgo();
     virtual ~SinkAlgo();
-    virtual GstBuffer* dequeue_buffer();
+    virtual GstBuffer* dequeue_buffer(gboolean *eos);
     virtual int set_data_caps(GstCaps *incaps)
     {
         //DO nothing
@@ -42,8 +45,44 @@ public:
         else
             g_print("Failed to set linked item to sinkAlgo!\n");
    }
+
+    virtual void skip_frame(guint64 frameId);
+
+    // max time(ms) to hold a frame which arrives earlier than its previous frames,
+    // 0 - output frames in arrival order
+    void set_reorder_time(int ms)
+    {
+        mReorderTime = (gint64)ms * 1000;
+    }
+
 private:
+    struct ReorderItem {
+        // NULL means this frame has been dropped by upstream algo
+        CvdlAlgoData *algoData;
+        gint64 arrivalTime;
+    };
+    void reorder_push(guint64 frameId, CvdlAlgoData *algoData);
+    void reorder_erase(std::map<guint64, ReorderItem>::iterator it);
+    // flush: output the held frames without waiting for the missing ones
+    CvdlAlgoData *reorder_pop(bool flush);
+    int reorder_wait_time();
+    CvdlFrameResult *create_frame_result(std::vector<ObjectData> &objectVec);
+
     CvdlAlgoBase *pLinkedItem[MAX_PRE_SINK_ALGO_NUM];
+
+    // reorder buffer keyed by frame id, so that frames are output by mFrameId order
+    std::mutex mReorderMutex;
+    std::map<guint64, ReorderItem> mReorderMap;
+    // the held frames by arrival time, the oldest one is the first
+    std::set<std::pair<gint64, guint64>> mArrivals;
+    guint64 mNextFrameId;
+    gint64 mReorderTime; /* in microseconds */
+    // got the EOS buffer, it is returned after the held frames
+    bool mEosPending;
+
+    int mOutFrameNum;
+    // frames dropped as they arrived after the hold time of them expired
+    int mLateFrameNum;
 };
 
 #endif
@@ -299,7 +299,7 @@ void Yolov1TinyAlgo::get_result(Yolov1TinyInternalData *internalData, CvdlAlgoDa
 
             object.id = objectNum;
             object.objectClass = nclass;
-            object.label = std::string(labels[nclass]);
+            object.label = ObjectLabel::intern(labels[nclass]);
             object.prob = prob;
 
             RectF b = internalData->mBoxes[idx];
@@ -298,7 +298,7 @@ bool Yolov2TinyAlgo::parse (const float * output, CvdlAlgoData* &outData)
         ObjectData object;
         object.id = objectNum;
         object.objectClass = box.classId;
-        object.label = std::string(mLabelNames[box.classId]);
+        object.label = ObjectLabel::intern(mLabelNames[box.classId]);
         object.prob = box.prob;
         object.rect = rect;
         object.rectROI = rect;
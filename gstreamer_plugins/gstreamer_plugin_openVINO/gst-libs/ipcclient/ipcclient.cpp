@@ -37,6 +37,7 @@
 #include <sstream>
 
 #include "jsonpacker.h"
+#include <ocl/metadata.h>
 
 using namespace std;
 #include <thread>
@@ -137,47 +138,6 @@ static void item_free_func(gpointer data)
      ipcclient_send_data(handle, error_info, info.size(), eErrorInfo);
  }
 
-#if 0
-static std::string covert_infer_data_to_string(void *data, guint64 pts, int infer_index)
-{
-    InferenceData *infer_data = (InferenceData *)data;
-    std::ostringstream   data_str; 
-    double ts = pts/1000000000.0;
-    data_str  << "frame_index=" << infer_data->frame_index <<", ";
-    data_str  << "infer_index=" << infer_index <<", ";
-    data_str  << "ts="   << ts << "s,";
-    data_str  << "prob="  << infer_data->probility << ",";
-    data_str  << "label=" << infer_data->label << ",";
-    data_str  << "rect=("  << infer_data->rect.x << ","
-              << infer_data->rect.y << ")@" << infer_data->rect.width
-              << "x" << infer_data->rect.height;
-    data_str  << std::endl;
-    std::string str = data_str.str();
-
-    return str;
-}
-#endif
-static std::string covert_infer_data_to_json_string(void *data, guint64 pts, int infer_index)
-{
-    InferenceData *infer_data = (InferenceData *)data;
-    JsonPackage json_data;
-
-    json_data.add_object_int("frame_index",infer_data->frame_index);
-    json_data.add_object_int("infer_index",infer_index);
-    json_data.add_object_int64("pts",pts);
-    json_data.add_object_double("prob",infer_data->probility);
-    json_data.add_object_string("label",infer_data->label);
-    json_data.add_object_rect("rect", infer_data->rect.x, infer_data->rect.y,
-                                     infer_data->rect.width, infer_data->rect.height);
-    const char* string_data = json_data.object_to_string();
-
-    if(string_data)
-        return std::string(string_data) + std::string("\n");
-    else
-        return std::string("none data!\n");
-}
-
-
 /* meta data json format
   *   {
   *       frame_index:<int>
@@ -209,40 +169,40 @@ static std::string covert_infer_data_to_json_string(void *data, guint64 pts, int
   *      ]
   *
   */
-static std::string covert_infer_data_to_json_string_full_frame(void *data, int count, guint64 pts, int infer_index)
+static std::string covert_frame_result_to_json_string(CvdlFrameResult *result, int frame_index,
+                                                      guint64 pts, int infer_index)
 {
-    InferenceData *infer_data = (InferenceData *)data;
     JsonPackage json_data;
     struct json_object* array_obj = NULL;
     struct json_object* obj = NULL, *sub_obj = NULL, *rect_obj = NULL;
 
-    json_data.add_object_int("frame_index",infer_data->frame_index);
+    json_data.add_object_int("frame_index",frame_index);
     json_data.add_object_int("infer_index",infer_index);
     json_data.add_object_int64("pts",pts);
-    json_data.add_object_int("obj_count",count);
+    json_data.add_object_int("obj_count",result->object_count);
 
     array_obj = json_object_new_array();
-    for(int i=0; i<count; i++) {
+    for(int i=0; i<result->object_count; i++) {
+        CvdlObject *object = &result->objects[i];
         obj = json_object_new_object();
-        sub_obj = json_object_new_double(infer_data->probility);
+        sub_obj = json_object_new_double(object->probility);
         json_object_object_add(obj, "prob", sub_obj);
 
-        sub_obj = json_object_new_string(infer_data->label);
+        sub_obj = json_object_new_string(CVDL_FRAME_RESULT_LABEL(result, object));
         json_object_object_add(obj, "label", sub_obj);
 
         rect_obj = json_object_new_object();
-        sub_obj = json_object_new_int(infer_data->rect.x);
+        sub_obj = json_object_new_int(object->rect.x);
         json_object_object_add(rect_obj, "x", sub_obj);
-        sub_obj = json_object_new_int(infer_data->rect.y);
+        sub_obj = json_object_new_int(object->rect.y);
         json_object_object_add(rect_obj, "y", sub_obj);
-        sub_obj = json_object_new_int(infer_data->rect.width);
+        sub_obj = json_object_new_int(object->rect.width);
         json_object_object_add(rect_obj, "w", sub_obj);
-        sub_obj = json_object_new_int(infer_data->rect.height);
+        sub_obj = json_object_new_int(object->rect.height);
         json_object_object_add(rect_obj, "h", sub_obj);
         json_object_object_add(obj, "rect", rect_obj);
 
         json_object_array_add(array_obj, obj);
-        infer_data++;
     }
     json_data.add_object_object("objects",array_obj);
     const char* string_data = json_data.object_to_string();
@@ -253,40 +213,13 @@ static std::string covert_infer_data_to_json_string_full_frame(void *data, int c
         return std::string("none data!\n");
 }
 
-
-int ipcclient_send_infer_data(IPCClientHandle handle, void *data, guint64 pts, int infer_index)
+int ipcclient_send_frame_result(IPCClientHandle handle, void *result, int frame_index, guint64 pts, int infer_index)
 {
-#if 0
-    std::string str = covert_infer_data_to_string(data, pts, infer_index);
-#else
-    std::string str = covert_infer_data_to_json_string(data, pts, infer_index);
-#endif
+    std::string str = covert_frame_result_to_json_string((CvdlFrameResult *)result, frame_index, pts, infer_index);
     const char*txt_cache = str.c_str();
     int data_len = str.size();
     ipcclient_send_data(handle, (const char *)txt_cache, data_len, eMetaText);
-    g_print("send data size=%d, %s\n",data_len, txt_cache);
-
-    //debug
-    //ipcclient_upload_error_info(handle, (char *)txt_cache);
-
-   return data_len;
-}
-
-
-int ipcclient_send_infer_data_full_frame(IPCClientHandle handle, void *data, int count, guint64 pts, int infer_index)
-{
-#if 0
-    std::string str = covert_infer_data_to_string(data, pts, infer_index);
-#else
-    std::string str = covert_infer_data_to_json_string_full_frame(data, count, pts, infer_index);
-#endif
-    const char*txt_cache = str.c_str();
-    int data_len = str.size();
-    ipcclient_send_data(handle, (const char *)txt_cache, data_len, eMetaText);
-    g_print("send data size=%d, %s\n",data_len, txt_cache);
-
-    //debug
-    //ipcclient_upload_error_info(handle, (char *)txt_cache);
+    GST_LOG("send data size=%d, %s", data_len, txt_cache);
 
    return data_len;
 }
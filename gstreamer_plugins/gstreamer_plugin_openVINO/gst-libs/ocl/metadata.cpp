@@ -23,6 +23,8 @@
 
 using namespace std;
 #include <string>
+#include <mutex>
+#include <unordered_map>
 
 #ifdef __cplusplus
 extern "C" {
@@ -212,36 +214,104 @@ gst_buffer_get_inference_meta (GstBuffer * buffer)
 //
 //-------------------------------------------------------------------------------------------
 
-/* called when allocate cvdlfilter output buffer*/
-gpointer
-cvdl_meta_create (VideoDisplayID display, VideoSurfaceID surface,
-                       VideoRect *rect, const char *label,
-                       float prob, guint32 color,
-                       VideoPoint *points, int count)
-{
-    CvdlMeta *meta = g_new0 (CvdlMeta, 1);
+// Label names are kept in chunks which never move, so that cvdl_label_name()
+// reads them without lock while other threads add labels.
+#define LABEL_CHUNK_BITS 10
+#define LABEL_CHUNK_SIZE (1 << LABEL_CHUNK_BITS)
+#define LABEL_MAX_CHUNKS 1024
 
-    meta->surface_id = surface;
-    meta->display_id = display;
-    meta->inference_result =
-        (InferenceMeta *)inference_meta_create(rect, label, prob, color);
+static std::mutex label_mutex;
+static std::unordered_map<std::string, int> label_ids;
+static const char **label_chunks[LABEL_MAX_CHUNKS];
+// id 0 is CVDL_LABEL_NONE
+static gint label_count = 1;
 
-    for(int i=0; i<count; i++) {
-        meta->inference_result->track[i] = points[i];
+int
+cvdl_label_intern (const char *label)
+{
+    if (!label || !label[0])
+        return CVDL_LABEL_NONE;
+
+    std::lock_guard<std::mutex> lk(label_mutex);
+    auto it = label_ids.find(label);
+    if (it != label_ids.end())
+        return it->second;
+
+    int id = label_count;
+    if (id >= LABEL_MAX_CHUNKS * LABEL_CHUNK_SIZE) {
+        static gboolean warned = FALSE;
+        if (!warned)
+            g_print ("Label table is full, new labels are dropped\n");
+        warned = TRUE;
+        return CVDL_LABEL_NONE;
     }
-    meta->inference_result->track_count = count;
-    return (gpointer) meta;
+    const char **chunk = label_chunks[id >> LABEL_CHUNK_BITS];
+    if (!chunk) {
+        chunk = g_new0 (const char *, LABEL_CHUNK_SIZE);
+        label_chunks[id >> LABEL_CHUNK_BITS] = chunk;
+    }
+    // keys of unordered_map are not moved by rehash
+    it = label_ids.insert(std::make_pair(std::string(label), id)).first;
+    chunk[id & (LABEL_CHUNK_SIZE - 1)] = it->first.c_str();
+    g_atomic_int_set (&label_count, id + 1);
+    return id;
+}
+
+const char *
+cvdl_label_name (int id)
+{
+    if (id <= CVDL_LABEL_NONE || id >= g_atomic_int_get (&label_count))
+        return "";
+    return label_chunks[id >> LABEL_CHUNK_BITS][id & (LABEL_CHUNK_SIZE - 1)];
 }
 
+// all parts are in one allocation, objects, tracks and labels are zeroed,
+// labels has an extra byte at offset 0 for the empty label
+CvdlFrameResult *
+cvdl_frame_result_new (int object_count, int track_total, int label_size)
+{
+    gsize size = sizeof(CvdlFrameResult) + object_count * sizeof(CvdlObject)
+               + track_total * sizeof(VideoPoint) + label_size + 1;
+    guint8 *block = (guint8 *)g_malloc0 (size);
+    CvdlFrameResult *result = (CvdlFrameResult *)block;
+
+    block += sizeof(CvdlFrameResult);
+    result->ref_count = 1;
+    result->object_count = object_count;
+    result->objects = (CvdlObject *)block;
+    block += object_count * sizeof(CvdlObject);
+    result->track_total = track_total;
+    result->tracks = (VideoPoint *)block;
+    block += track_total * sizeof(VideoPoint);
+    result->label_size = label_size + 1;
+    result->labels = (gchar *)block;
+    return result;
+}
+
+CvdlFrameResult *
+cvdl_frame_result_ref (CvdlFrameResult *result)
+{
+    if(result)
+        g_atomic_int_inc (&result->ref_count);
+    return result;
+}
+
+void
+cvdl_frame_result_unref (CvdlFrameResult *result)
+{
+    if(result && g_atomic_int_dec_and_test (&result->ref_count))
+        g_free (result);
+}
 
+/* called when allocate cvdlfilter output buffer*/
 gpointer
-cvdl_meta_add (gpointer meta, VideoRect *rect, const char *label,
-                    float prob, guint32 color, VideoPoint *points, int count)
+cvdl_meta_create (VideoDisplayID display, VideoSurfaceID surface, CvdlFrameResult *result)
 {
-    CvdlMeta *cvdl_meta = ( CvdlMeta *)meta;
+    CvdlMeta *meta = g_new0 (CvdlMeta, 1);
 
-    //inference_meta_add((gpointer)cvdl_meta->inference_result);
-    inference_meta_add(cvdl_meta->inference_result, rect, label, prob, color, points, count);
+    meta->surface_id = surface;
+    meta->display_id = display;
+    meta->result = result;
     return (gpointer) meta;
 }
 
@@ -250,20 +320,21 @@ cvdl_meta_free (gpointer meta)
 {
     CvdlMeta *cvdl_meta = ( CvdlMeta *)meta;
 
-    inference_meta_free ((gpointer)cvdl_meta->inference_result);
+    cvdl_frame_result_unref (cvdl_meta->result);
     g_free(meta);
     return ;
 }
 
 
+// the frame result is immutable, so it is shared rather than copied
 static CvdlMeta*
 cvdl_meta_copy(CvdlMeta *meta_src) {
     CvdlMeta *meta_dst = NULL;
 
-    meta_dst = g_slice_new (CvdlMeta);
+    meta_dst = g_new0 (CvdlMeta, 1);
     //memcpy(meta_dst, meta_src, sizeof(CvdlMeta));
     std::copy(meta_src, meta_src+1, meta_dst);
-    meta_dst->inference_result = inference_meta_copy(meta_src->inference_result);
+    meta_dst->result = cvdl_frame_result_ref(meta_src->result);
 
     return meta_dst;
 }
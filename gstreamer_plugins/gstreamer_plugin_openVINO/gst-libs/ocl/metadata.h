@@ -54,13 +54,58 @@ typedef struct _InferenceMetaHolder{
     int meta_count;
 }InferenceMetaHolder;
 
+// Process-wide label table for the fixed class vocabularies of the models.
+// Objects of such classes carry the label as a small id, which is resolved to
+// its string only where it is drawn or sent out. Ids and the strings they
+// resolve to stay valid for the life of the process, so free text labels such
+// as plate numbers must not be interned, they are kept by each frame result.
+#define CVDL_LABEL_NONE 0
+
+int
+cvdl_label_intern (const char *label);
+const char *
+cvdl_label_name (int id);
+
+// One object in CvdlFrameResult
+typedef struct _CvdlObject{
+    float     probility;
+    VideoRect rect;
+    guint32   color;
+    // id in the label table, CVDL_LABEL_NONE for a free text label
+    int       label_id;
+    // free text label is labels + label_offset, offset 0 is an empty string
+    int       label_offset;
+    // trajectory points are tracks[track_offset ... track_offset+track_count-1]
+    int       track_offset;
+    int       track_count;
+} CvdlObject;
+
+// Inference result of a frame, which is allocated in one block:
+//   header | objects | tracks | labels
+// It is immutable after created, and shared by refcount from cvdlfilter
+// to blender, resconvert and ipcsink without copy.
+typedef struct _CvdlFrameResult{
+    gint ref_count;
+    int object_count;
+    CvdlObject *objects;
+    int track_total;
+    VideoPoint *tracks;
+    int label_size;
+    // free text labels of the objects, each one is NUL terminated
+    gchar *labels;
+} CvdlFrameResult;
+
+#define CVDL_FRAME_RESULT_LABEL(result, object) \
+    ((object)->label_id != CVDL_LABEL_NONE ? cvdl_label_name ((object)->label_id) \
+                                           : (result)->labels + (object)->label_offset)
+#define CVDL_FRAME_RESULT_TRACK(result, object) ((result)->tracks + (object)->track_offset)
+
 typedef struct _CvdlMeta{
     VideoSurfaceID surface_id;
     VideoDisplayID display_id;
     guint32     width;
     guint32     height;
-    InferenceMeta *inference_result;
-    int meta_count;
+    CvdlFrameResult *result;
 } CvdlMeta;
 
 typedef struct _CvdlMetaHolder{
@@ -86,12 +131,17 @@ void gst_buffer_set_inference_meta (GstBuffer * buffer, InferenceMeta* meta);
 InferenceMeta* gst_buffer_get_inference_meta (GstBuffer * buffer);
 
 
+// label_size is the total size of free text labels, including their NUL
+CvdlFrameResult *
+cvdl_frame_result_new (int object_count, int track_total, int label_size);
+CvdlFrameResult *
+cvdl_frame_result_ref (CvdlFrameResult *result);
+void
+cvdl_frame_result_unref (CvdlFrameResult *result);
+
+// the meta takes the reference of result
 gpointer
-cvdl_meta_create (VideoDisplayID display, VideoSurfaceID surface, VideoRect *rect, const char *label,
-                        float prob, guint32 color, VideoPoint *points, int count);
-gpointer
-cvdl_meta_add (gpointer meta, VideoRect *rect, const char *label, float prob, guint32 color,
-                        VideoPoint *points, int count);
+cvdl_meta_create (VideoDisplayID display, VideoSurfaceID surface, CvdlFrameResult *result);
 void
 cvdl_meta_free (gpointer meta);
 
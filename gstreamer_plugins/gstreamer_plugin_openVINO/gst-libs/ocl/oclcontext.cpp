@@ -19,6 +19,7 @@
 #include "oclcontext.h"
 #include <vector>
 #include <iterator>
+#include <sstream>
 
 
 #ifdef HAVE_CONFIG_H
@@ -44,6 +45,16 @@ namespace HDDLStreamFilter {
 #define HDDLS_CVDL_KERNEL_PATH_DEFAULT "/usr/lib/x86_64-linux-gnu/libgstcvdl/kernels"
 #endif
 
+// sub directory of user cache dir for compiled kernels, HDDLS_CVDL_KERNEL_CACHE overrides it
+#define HDDLS_CVDL_KERNEL_CACHE_DEFAULT "hddls-cvdl/kernels"
+
+// a compiled program can be loaded by ProgramSource::fromBinary() since OpenCV 3.4.2,
+// the kernels are always built from source with an older one
+#if CV_VERSION_MAJOR > 3 || (CV_VERSION_MAJOR == 3 && (CV_VERSION_MINOR > 4 || \
+    (CV_VERSION_MINOR == 4 && CV_VERSION_REVISION >= 2)))
+#define HAVE_OCL_PROGRAM_CACHE 1
+#endif
+
 ///internal class hold device id and make sure *.cl compile in serial
 class OclDevice {
 
@@ -71,7 +82,10 @@ private:
     size_t readFile (const char* filename, guint8 **data);
     gpointer getExtensionFunctionAddress (const char* name);
     gboolean releaseKernelCVMap ();
-    cv::ocl::Kernel loadKernelCV (const char* name, const char* file);
+    cv::ocl::Program loadProgramCV (const char* file);
+    std::string getProgramCachePath (const char* file, const char* source, const cv::String& options);
+    cv::ocl::Program loadProgramCache (const std::string& path, const char* file, const cv::String& options);
+    void saveProgramCache (const std::string& path, const cv::ocl::Program& program);
 
     static WeakPtr<OclDevice> m_instance;
     static Lock m_lock;
@@ -82,6 +96,7 @@ private:
     cv::ocl::Context m_ocvContext;
     #endif
     //OclKernelCVMap m_kernel_cv_map;
+    // programs are built once and shared, kernels are not
     OclProgramCVMap m_program_cv_map;
 
     cl_context m_context;
@@ -387,18 +402,99 @@ OclDevice::readFile (const char* filename, guint8 **data)
 }
 
 
-cv::ocl::Kernel
-OclDevice::loadKernelCV (const char* name, const char* file)
+// The compiled program is only valid for the same device, driver, build options and source
+std::string
+OclDevice::getProgramCachePath (const char* file, const char* source, const cv::String& options)
+{
+#ifdef HAVE_OCL_PROGRAM_CACHE
+    const gchar *env = g_getenv("HDDLS_CVDL_KERNEL_CACHE");
+    std::string dir;
+
+    if(env)
+        dir = env;
+    else
+        dir = std::string(g_get_user_cache_dir()) + "/" + HDDLS_CVDL_KERNEL_CACHE_DEFAULT;
+    // empty HDDLS_CVDL_KERNEL_CACHE disables the cache
+    if(dir.empty())
+        return std::string();
+
+    cv::ocl::Device device = cv::ocl::Device::getDefault();
+    std::ostringstream key;
+    key << device.name() << "|" << device.driverVersion() << "|" << options << "|" << source;
+    std::string keyStr = key.str();
+    gchar *hash = g_compute_checksum_for_string(G_CHECKSUM_SHA1, keyStr.c_str(), keyStr.size());
+    std::string path = dir + "/" + file + "-" + hash + ".bin";
+    g_free(hash);
+    return path;
+#else
+    return std::string();
+#endif
+}
+
+cv::ocl::Program
+OclDevice::loadProgramCache (const std::string& path, const char* file, const cv::String& options)
+{
+    gchar *binary = NULL;
+    gsize size = 0;
+
+    if(path.empty() || !g_file_get_contents(path.c_str(), &binary, &size, NULL))
+        return cv::ocl::Program();
+
+#ifdef HAVE_OCL_PROGRAM_CACHE
+    cv::String buildError;
+    cv::ocl::ProgramSource source = cv::ocl::ProgramSource::fromBinary("hddls", file,
+        (const unsigned char *)binary, size, options);
+    cv::ocl::Program program(source, options, buildError);
+    g_free(binary);
+    if(!program.ptr())
+        GST_WARNING("Invalid program cache %s: %s\n", path.c_str(), buildError.c_str());
+    else
+        GST_INFO("Load program from %s\n", path.c_str());
+    return program;
+#else
+    g_free(binary);
+    return cv::ocl::Program();
+#endif
+}
+
+// write it into a temp file and rename, so that other processes never see a partial file
+void
+OclDevice::saveProgramCache (const std::string& path, const cv::ocl::Program& program)
+{
+    std::vector<char> binary;
+    GError *error = NULL;
+
+    if(path.empty() || !program.ptr())
+        return;
+    program.getBinary(binary);
+    if(binary.empty())
+        return;
+
+    gchar *dir = g_path_get_dirname(path.c_str());
+    g_mkdir_with_parents(dir, 0755);
+    g_free(dir);
+    if(!g_file_set_contents(path.c_str(), binary.data(), binary.size(), &error)) {
+        GST_WARNING("Failed to save program cache %s: %s\n", path.c_str(), error->message);
+        g_error_free(error);
+    }
+}
+
+// with m_lock
+cv::ocl::Program
+OclDevice::loadProgramCV (const char* file)
 {
-    cv::ocl::Kernel kernel;
     cv::ocl::Program program;
     const gchar *env = g_getenv("HDDLS_CVDL_KERNEL_PATH");
 
+    OclProgramCVMapIterator it = m_program_cv_map.find (file);
+    if(it != m_program_cv_map.end())
+        return it->second;
+
     std::ostringstream   path_str;
     if(env) {
-        path_str   <<   env   <<   "/"   <<    (file ? file : name)   <<  ".cl";
+        path_str   <<   env   <<   "/"   <<    file   <<  ".cl";
     } else {
-        path_str   <<   HDDLS_CVDL_KERNEL_PATH_DEFAULT   <<   "/"   <<    (file ? file : name)   <<  ".cl";
+        path_str   <<   HDDLS_CVDL_KERNEL_PATH_DEFAULT   <<   "/"   <<    file   <<  ".cl";
     }
     std::string str =  path_str.str();
     const char *filename = str.c_str();
@@ -406,35 +502,26 @@ OclDevice::loadKernelCV (const char* name, const char* file)
     guint8 *data = NULL;
     if (!readFile (filename, &data)) {
         g_print("It cannot find kernel source from %s\nplease set HDDLS_CVDL_KERNEL_PATH!\n", filename);
-        return cv::ocl::Kernel();
+        return cv::ocl::Program();
     }
 
-    cv::ocl::ProgramSource programSource((const char*)data);
-    //if (programSource.empty()) {
-    //    g_print("Error in create programSource...\n");
-    //    return cv::ocl::Kernel();
-    //}
-
     cv::String buildOptions("-I. -cl-fast-relaxed-math -cl-kernel-arg-info");
     cv::String buildError;
-    program = cv::ocl::Program(programSource, buildOptions, buildError);
-    GST_INFO("Build program: %s\n", buildError.c_str());
-    g_free (data);
-    //if(program.empty()) {
-    //    g_print("Error in build program...\n");
-    //    return cv::ocl::Kernel();
-    //}
 
-    kernel.create(name, program);
-    if(kernel.empty()){
-        g_print("Error in create kernel...\n");
-        return cv::ocl::Kernel();
+    // try the compiled program first, build it from source if no valid one
+    std::string cachePath = getProgramCachePath(file, (const char*)data, buildOptions);
+    program = loadProgramCache(cachePath, file, buildOptions);
+    if(!program.ptr()) {
+        cv::ocl::ProgramSource programSource((const char*)data);
+        program = cv::ocl::Program(programSource, buildOptions, buildError);
+        GST_INFO("Build program: %s\n", buildError.c_str());
+        saveProgramCache(cachePath, program);
     }
-    m_program_cv_map[file] = program;
-    return kernel;
+    g_free (data);
 
-    //m_kernel_cv_map[name] = kernel;
-    //return kernel;
+    if(program.ptr())
+        m_program_cv_map[file] = program;
+    return program;
 }
 
 
@@ -448,20 +535,17 @@ OclDevice::acquireKernelCV(const char* name, const char* file)
     }
     AutoLock lock(m_lock);
 
-    #if 0
-    OclKernelCVMapIterator it = m_kernel_cv_map.find (name);
-    return ((it == m_kernel_cv_map.end()) ? loadKernelCV(name, file) : it->second);
-    #else
-    OclProgramCVMapIterator it = m_program_cv_map.find (file);
-    if(it == m_program_cv_map.end()) {
-        return loadKernelCV(name, file);
-    }
+    cv::ocl::Program program = loadProgramCV(file ? file : name);
+    if(!program.ptr())
+        return cv::ocl::Kernel();
 
-    // kernel must be created every time, if not NV12 plane will be got with garbage
+    // kernel must be created every time, if not NV12 plane will be got with garbage.
+    // A caller such as OclVppBase keeps its own kernel, it is not shared by callers.
     cv::ocl::Kernel kernel;
-    kernel.create(name, it->second);
+    kernel.create(name, program);
+    if(kernel.empty())
+        g_print("Error in create kernel...\n");
     return kernel;
-    #endif
 }
 
 
@@ -52,9 +52,33 @@ enum
     PROP_0,
     // Property for algo pipeline, which decide what algo will it run
     PROP_ALGO_PIPELINE_DESC,
+    // Property for max time to hold an out-of-order frame
+    PROP_REORDER_TIME,
+    // Property for running synthetic inferences when a network is loaded
+    PROP_WARMUP,
+    // Property for max time a frame waits in the queue of an algo
+    PROP_STALL_TIMEOUT,
+    // Property for max time of an infer request
+    PROP_INFER_TIMEOUT,
+    // Property for the queue size and latency regarded as full load of algo pipeline
+    PROP_QOS_QUEUE_SIZE,
+    PROP_QOS_LATENCY,
+    // Property for CPUs and NUMA node of algo threads
+    PROP_PLACEMENT,
     PROP_NUM
 };
 
+#define DEFAULT_REORDER_TIME 0
+#define DEFAULT_WARMUP FALSE
+#define DEFAULT_STALL_TIMEOUT 5000
+#define DEFAULT_INFER_TIMEOUT 2000
+#define DEFAULT_QOS_QUEUE_SIZE 16
+#define DEFAULT_QOS_LATENCY 1000
+// Max time(ms) without input data
+#define WATCH_DOG_NO_DATA_TIMEOUT 100000
+// Max time(ms) to wait the replaced algo pipeline output its cached frames
+#define ALGO_SWAP_DRAIN_TIMEOUT 2000
+
 struct _CvdlFilterPrivate
 {
     gboolean negotiated;
@@ -85,24 +109,68 @@ static GstStaticPadTemplate cvdl_src_factory =
     );
 
 
+// Tell upstream decoder how busy algo pipeline is by an overflow QoS event,
+// proportion is the load of algo pipeline, 1.0 means full.
+// It is sent only when the load level changes, so that the decoder can skip
+// the frames which will never be analysed.
+static void
+cvdl_filter_update_qos(CvdlFilter *cvdlfilter, int cache_buf_size)
+{
+    GstBaseTransform *trans = GST_BASE_TRANSFORM_CAST (cvdlfilter);
+    gdouble proportion = 0.0, latency;
+    gint level;
+
+    if(cvdlfilter->qos_queue_size > 0)
+        proportion = (gdouble)cache_buf_size / cvdlfilter->qos_queue_size;
+    if(cvdlfilter->qos_latency > 0) {
+        // swapLock keeps algoHandle from being swapped and destroyed while it is read
+        g_mutex_lock(&cvdlfilter->swapLock);
+        latency = algo_pipeline_get_oldest_age(cvdlfilter->algoHandle) / (cvdlfilter->qos_latency * 1000.0);
+        g_mutex_unlock(&cvdlfilter->swapLock);
+        proportion = MAX(proportion, latency);
+    }
+
+    level = proportion >= 2.0 ? 2 : (proportion >= 1.0 ? 1 : 0);
+    // leave a level only when the load is clearly below it
+    if(level == cvdlfilter->qosLevel ||
+       (level < cvdlfilter->qosLevel && proportion > cvdlfilter->qosLevel - 0.5))
+        return;
+
+    GST_INFO_OBJECT(cvdlfilter, "QoS level %d -> %d, proportion = %f",
+        cvdlfilter->qosLevel, level, proportion);
+    cvdlfilter->qosLevel = level;
+    gst_pad_push_event(trans->sinkpad,
+        gst_event_new_qos(GST_QOS_TYPE_OVERFLOW, proportion, 0, GST_CLOCK_TIME_NONE));
+}
+
 static GstFlowReturn
 cvdl_handle_buffer(CvdlFilter *cvdlfilter, GstBuffer* buffer, guint w, guint h)
 {
     GstFlowReturn ret = GST_FLOW_OK;
 
+    g_mutex_lock(&cvdlfilter->swapLock);
     int cache_buf_size = algo_pipeline_get_all_queue_size(cvdlfilter->algoHandle);
+    g_mutex_unlock(&cvdlfilter->swapLock);
     GST_LOG("cache buffer size = %d\n", cache_buf_size);
 
 #ifdef SYNC_WITH_DECODER
     // wait algo task
     while(cache_buf_size >= 5) {
         g_usleep(10000);// 10ms
+        g_mutex_lock(&cvdlfilter->swapLock);
         cache_buf_size = algo_pipeline_get_all_queue_size(cvdlfilter->algoHandle);
+        g_mutex_unlock(&cvdlfilter->swapLock);
         GST_LOG("loop - cache buffer size = %d\n", cache_buf_size);
     }
 #endif
+    if(cvdlfilter->qos_queue_size > 0 || cvdlfilter->qos_latency > 0)
+        cvdl_filter_update_qos(cvdlfilter, cache_buf_size);
+
     // put buffer into a queue
+    // algoHandle may be swapped by swapThread, the swap happens between 2 frames
+    g_mutex_lock(&cvdlfilter->swapLock);
     algo_pipeline_put_buffer(cvdlfilter->algoHandle, buffer, w, h);
+    g_mutex_unlock(&cvdlfilter->swapLock);
 
     cvdlfilter->frame_num_in++;
     void *data;
@@ -155,6 +223,7 @@ cvdl_filter_transform_chain (GstPad * pad, GstObject * parent, GstBuffer * buffe
     if(cvdlfilter->frame_num==0)
         cvdlfilter->startTimePos = g_get_monotonic_time();
     cvdlfilter->frame_num++;
+    cvdlfilter->lastInputTime = g_get_monotonic_time();
     GST_DEBUG_OBJECT (trans, "src_info: index=%d ",cvdlfilter->frame_num);
     GST_DEBUG_OBJECT (trans, "got buffer with timestamp %" GST_TIME_FORMAT,
                               GST_TIME_ARGS (duration));
@@ -205,61 +274,221 @@ cvdl_filter_transform_caps (GstBaseTransform* trans,
     return newcaps;
 }
 
-static void
-cvdl_filter_finalize (GObject * object)
+static char* error_to_string(int code){
+    char* error_info = NULL;
+
+    switch(code) {
+        case eCvdlFilterErrorCode_IE:
+            error_info = g_strdup("IE Error");
+            break;
+        case eCvdlFilterErrorCode_OCL:
+            error_info = g_strdup("OCL Error");
+            break;
+        case eCvdlFilterErrorCode_EmptyPipe:
+        case eCvdlFilterErrorCode_InvalidPipe:
+            error_info = g_strdup("pipeline Error");
+            break;
+        default:
+            error_info = g_strdup("Unknown");
+            break;
+    }
+    return error_info;
+}
+
+// Build a new algo pipeline with current algo_pipeline_desc and switch to it,
+// the old algo pipeline keeps running until the new one is ready, then it will
+// be drained by push task and destroyed here.
+static gpointer
+cvdl_filter_swap_func (gpointer userData)
 {
-    CvdlFilter *cvdlfilter = CVDL_FILTER (object);
+    CvdlFilter *cvdlfilter = CVDL_FILTER (userData);
     CvdlFilterPrivate *priv = cvdlfilter->priv;
-
+    GstElement *element = GST_ELEMENT (cvdlfilter);
+    AlgoPipelineConfig *config = NULL;
+    AlgoPipelineHandle handle, old;
+    gint64 start = g_get_monotonic_time();
+    gint64 end_time;
+    gchar *desc;
+    int count = 0;
+    int ret = eCvdlFilterErrorCode_None;
+
+    g_mutex_lock(&cvdlfilter->swapLock);
+    desc = g_strdup(cvdlfilter->algo_pipeline_desc);
+    g_mutex_unlock(&cvdlfilter->swapLock);
+
+    // 1. build and warm up the new algo pipeline
+    config = algo_pipeline_config_create(desc, &count, element);
+    g_free(desc);
+    if(!config) {
+        char *error_info = "Failed to create algo config!";
+        pipeline_report_error_info(element,error_info);
+        g_print("%s\n", error_info);
+        return NULL;
+    }
+    handle = algo_pipeline_create(config, count, element);
+    algo_pipeline_config_destroy(config);
+    if(!handle) {
+        // keep the current algo pipeline running
+        GST_ELEMENT_WARNING (cvdlfilter, LIBRARY, INIT, (NULL),
+            ("Failed to create algo pipeline, keep the current one"));
+        return NULL;
+    }
+    algo_pipeline_set_reorder_time(handle, cvdlfilter->reorder_time);
+    algo_pipeline_set_warmup(handle, cvdlfilter->warmup);
+    algo_pipeline_set_placement(handle, cvdlfilter->placement);
+    algo_pipeline_start(handle);
     if(priv->inCaps)
-        gst_caps_unref(priv->inCaps);
-    priv->inCaps=NULL;
+        ret = algo_pipeline_set_caps_all(handle, priv->inCaps);
+    if(ret!=eCvdlFilterErrorCode_None) {
+        // keep the current algo pipeline running
+        char* error_info = error_to_string(ret);
+        pipeline_report_error_info(element,error_info);
+        g_free(error_info);
+        algo_pipeline_stop(handle);
+        algo_pipeline_destroy(handle);
+        return NULL;
+    }
 
-    gst_video_info_init (&cvdlfilter->sink_info);
-    gst_video_info_init (&cvdlfilter->src_info);
+    // 2. switch to it, the next frame will be put into the new algo pipeline
+    g_mutex_lock(&cvdlfilter->swapLock);
+    if(cvdlfilter->swapCancelled) {
+        g_mutex_unlock(&cvdlfilter->swapLock);
+        algo_pipeline_stop(handle);
+        algo_pipeline_destroy(handle);
+        return NULL;
+    }
+    old = cvdlfilter->algoHandle;
+    cvdlfilter->algoHandle = handle;
+    cvdlfilter->drainAlgoHandle = old;
+    g_mutex_unlock(&cvdlfilter->swapLock);
+    g_print("cvdlfilter: algo pipeline was switched in %ld ms\n",
+        (g_get_monotonic_time() - start)/1000);
+
+    // 3. wait the old algo pipeline finish its cached frames, and they are pushed by push task,
+    // which signals swapCond for every frame of the old algo pipeline
+    end_time = g_get_monotonic_time() + ALGO_SWAP_DRAIN_TIMEOUT * G_TIME_SPAN_MILLISECOND;
+    g_mutex_lock(&cvdlfilter->swapLock);
+    while(!cvdlfilter->swapCancelled && algo_pipeline_get_all_queue_size(old) > 0) {
+        if(!g_cond_wait_until(&cvdlfilter->swapCond, &cvdlfilter->swapLock, end_time))
+            break;
+    }
+
+    // EOS makes push task return from the old algo pipeline and release it
+    algo_pipeline_flush_buffer(old);
+    while(!cvdlfilter->swapCancelled && cvdlfilter->drainAlgoHandle)
+        g_cond_wait(&cvdlfilter->swapCond, &cvdlfilter->swapLock);
+    // if cancelled, it will be destroyed by the state change
+    if(cvdlfilter->drainAlgoHandle)
+        old = NULL;
+    g_mutex_unlock(&cvdlfilter->swapLock);
+
+    if(old) {
+        algo_pipeline_stop(old);
+        algo_pipeline_destroy(old);
+    }
+    return NULL;
+}
+
+static void
+cvdl_filter_swap_start (CvdlFilter *cvdlfilter)
+{
+    // only one swap at a time
+    if(cvdlfilter->swapThread)
+        g_thread_join(cvdlfilter->swapThread);
+    cvdlfilter->swapThread = g_thread_new("algo_swap", cvdl_filter_swap_func, cvdlfilter);
+}
+
+static void
+cvdl_filter_swap_cancel (CvdlFilter *cvdlfilter)
+{
+    g_mutex_lock(&cvdlfilter->swapLock);
+    cvdlfilter->swapCancelled = TRUE;
+    g_cond_broadcast(&cvdlfilter->swapCond);
+    g_mutex_unlock(&cvdlfilter->swapLock);
+
+    if(cvdlfilter->swapThread)
+        g_thread_join(cvdlfilter->swapThread);
+    cvdlfilter->swapThread = NULL;
+    cvdlfilter->swapCancelled = FALSE;
+}
 
-    // stop the data push task
+// where the algo threads ran, so that pipelines can be packed on a host by it
+static void
+cvdl_filter_print_placement (AlgoPipelineHandle handle)
+{
+    AlgoPlacementReport report;
+    int i;
+
+    for(i=0; i<algo_pipeline_get_algo_num(handle); i++) {
+        if(!algo_pipeline_get_placement(handle, i, &report) || !report.thread_id)
+            continue;
+        g_print("cvdlfilter: %s(%d) thread %d on CPU %d, CPUs = %s, NUMA node = %d, workers = %d\n",
+            report.algo_name, i, report.thread_id, report.cpu,
+            report.cpus[0] ? report.cpus : "all", report.node, report.workers);
+    }
+}
+
+// stop push task, and destroy the algo pipelines
+static void
+cvdl_filter_stop_algo_pipeline (CvdlFilter *cvdlfilter)
+{
+    AlgoPipelineHandle drain;
+
+    cvdl_filter_swap_cancel(cvdlfilter);
+
+    // stop the data push task, it releases drainAlgoHandle when it gets the EOS
+    drain = cvdlfilter->drainAlgoHandle;
     gst_task_set_state(cvdlfilter->mPushTask, GST_TASK_STOPPED);
+    algo_pipeline_flush_buffer(drain);
     algo_pipeline_flush_buffer(cvdlfilter->algoHandle);
     gst_task_join(cvdlfilter->mPushTask);
-    gst_object_unref(cvdlfilter->mPushTask);
 
-    // destroy algo pipeline
+    if(drain) {
+        algo_pipeline_stop(drain);
+        algo_pipeline_destroy(drain);
+    }
+    cvdlfilter->drainAlgoHandle = 0;
     if(cvdlfilter->algoHandle) {
+        if(cvdlfilter->placement)
+            cvdl_filter_print_placement(cvdlfilter->algoHandle);
         algo_pipeline_stop(cvdlfilter->algoHandle);
         algo_pipeline_destroy(cvdlfilter->algoHandle);
     }
     cvdlfilter->algoHandle = 0;
+    cvdlfilter->qosLevel = 0;
+}
+
+static void
+cvdl_filter_finalize (GObject * object)
+{
+    CvdlFilter *cvdlfilter = CVDL_FILTER (object);
+    CvdlFilterPrivate *priv = cvdlfilter->priv;
+
+    if(priv->inCaps)
+        gst_caps_unref(priv->inCaps);
+    priv->inCaps=NULL;
+
+    gst_video_info_init (&cvdlfilter->sink_info);
+    gst_video_info_init (&cvdlfilter->src_info);
+
+    // stop the data push task and destroy algo pipeline
+    cvdl_filter_stop_algo_pipeline(cvdlfilter);
+    gst_object_unref(cvdlfilter->mPushTask);
 
     if(cvdlfilter->algo_pipeline_desc)
         g_free(cvdlfilter->algo_pipeline_desc);
     cvdlfilter->algo_pipeline_desc = NULL;
+    g_free(cvdlfilter->placement);
+    cvdlfilter->placement = NULL;
     g_rec_mutex_clear(&cvdlfilter->mMutex);
+    g_mutex_clear(&cvdlfilter->swapLock);
+    g_cond_clear(&cvdlfilter->swapCond);
+    g_mutex_clear(&cvdlfilter->wdLock);
+    g_cond_clear(&cvdlfilter->wdCond);
 
     G_OBJECT_CLASS (parent_class)->finalize (object);
 }
 
-static char* error_to_string(int code){
-    char* error_info = NULL;
-
-    switch(code) {
-        case eCvdlFilterErrorCode_IE:
-            error_info = g_strdup("IE Error");
-            break;
-        case eCvdlFilterErrorCode_OCL:
-            error_info = g_strdup("OCL Error");
-            break;
-        case eCvdlFilterErrorCode_EmptyPipe:
-        case eCvdlFilterErrorCode_InvalidPipe:
-            error_info = g_strdup("pipeline Error");
-            break;
-        default:
-            error_info = g_strdup("Unknown");
-            break;
-    }
-    return error_info;
-}
-
 static GstStateChangeReturn
 cvdl_filter_change_state (GstElement * element, GstStateChange transition)
 {
@@ -282,18 +511,26 @@ cvdl_filter_change_state (GstElement * element, GstStateChange transition)
             config = algo_pipeline_config_create(cvdlfilter->algo_pipeline_desc, &count, element);
 
         if(config) {
-            cvdlfilter->algoHandle = algo_pipeline_create(config, count, element);
-            algo_pipeline_start(cvdlfilter->algoHandle);
-            if(config)
-                algo_pipeline_config_destroy(config);
-
-            if(priv->inCaps)
-                ret = algo_pipeline_set_caps_all(cvdlfilter->algoHandle, priv->inCaps);
-
-            if(ret!=eCvdlFilterErrorCode_None) {
-                char* error_info = error_to_string(ret);
-                pipeline_report_error_info(element,error_info);
-                g_free(error_info);
+            AlgoPipelineHandle handle = algo_pipeline_create(config, count, element);
+            algo_pipeline_config_destroy(config);
+            if(!handle) {
+                GST_ELEMENT_WARNING (cvdlfilter, LIBRARY, INIT, (NULL),
+                    ("Failed to create algo pipeline"));
+            } else {
+                cvdlfilter->algoHandle = handle;
+                algo_pipeline_set_reorder_time(cvdlfilter->algoHandle, cvdlfilter->reorder_time);
+                algo_pipeline_set_warmup(cvdlfilter->algoHandle, cvdlfilter->warmup);
+                algo_pipeline_set_placement(cvdlfilter->algoHandle, cvdlfilter->placement);
+                algo_pipeline_start(cvdlfilter->algoHandle);
+
+                if(priv->inCaps)
+                    ret = algo_pipeline_set_caps_all(cvdlfilter->algoHandle, priv->inCaps);
+
+                if(ret!=eCvdlFilterErrorCode_None) {
+                    char* error_info = error_to_string(ret);
+                    pipeline_report_error_info(element,error_info);
+                    g_free(error_info);
+                }
             }
          } else {
             char *error_info = "Failed to create algo config!";
@@ -309,6 +546,8 @@ cvdl_filter_change_state (GstElement * element, GstStateChange transition)
     case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
         if(gst_task_get_state(cvdlfilter->mWDTask) != GST_TASK_STARTED) {
             cvdlfilter->mQuited = false;
+            cvdlfilter->stallReported = FALSE;
+            cvdlfilter->lastInputTime = g_get_monotonic_time();
             gst_task_start(cvdlfilter->mWDTask);
         }
         break;
@@ -319,7 +558,10 @@ cvdl_filter_change_state (GstElement * element, GstStateChange transition)
   result = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
   switch (transition) {
       case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
+        g_mutex_lock(&cvdlfilter->wdLock);
         cvdlfilter->mQuited = true;
+        g_cond_broadcast(&cvdlfilter->wdCond);
+        g_mutex_unlock(&cvdlfilter->wdLock);
         gst_task_set_state(cvdlfilter->mWDTask, GST_TASK_STOPPED);
         gst_task_join(cvdlfilter->mWDTask);
 
@@ -337,15 +579,8 @@ cvdl_filter_change_state (GstElement * element, GstStateChange transition)
         //
          break;
      case GST_STATE_CHANGE_PAUSED_TO_READY:
-         // stop the data push task
-         gst_task_set_state(cvdlfilter->mPushTask, GST_TASK_STOPPED);
-         algo_pipeline_flush_buffer(cvdlfilter->algoHandle);
-         gst_task_join(cvdlfilter->mPushTask);
-         if(cvdlfilter->algoHandle) {
-            algo_pipeline_stop(cvdlfilter->algoHandle);
-            algo_pipeline_destroy(cvdlfilter->algoHandle);
-         }
-         cvdlfilter->algoHandle = 0;
+         // stop the data push task and destroy algo pipeline
+         cvdl_filter_stop_algo_pipeline(cvdlfilter);
          break;
     case GST_STATE_CHANGE_READY_TO_NULL:
          cvdlfilter->stopTimePos = g_get_monotonic_time();
@@ -364,10 +599,41 @@ static void
 cvdl_filter_set_property (GObject* object, guint prop_id, const GValue* value, GParamSpec* pspec)
 {
     CvdlFilter *cvdlfilter = CVDL_FILTER (object);
+    gboolean running;
 
     switch (prop_id) {
         case PROP_ALGO_PIPELINE_DESC:
+            g_mutex_lock(&cvdlfilter->swapLock);
+            g_free(cvdlfilter->algo_pipeline_desc);
             cvdlfilter->algo_pipeline_desc = g_value_dup_string (value);
+            running = (cvdlfilter->algoHandle != 0);
+            g_mutex_unlock(&cvdlfilter->swapLock);
+            // algo pipeline is running, swap it without stopping the gst pipeline
+            if(running)
+                cvdl_filter_swap_start(cvdlfilter);
+            break;
+        case PROP_REORDER_TIME:
+            cvdlfilter->reorder_time = g_value_get_int (value);
+            break;
+        case PROP_WARMUP:
+            cvdlfilter->warmup = g_value_get_boolean (value);
+            break;
+        case PROP_STALL_TIMEOUT:
+            cvdlfilter->stall_timeout = g_value_get_int (value);
+            break;
+        case PROP_INFER_TIMEOUT:
+            cvdlfilter->infer_timeout = g_value_get_int (value);
+            break;
+        case PROP_QOS_QUEUE_SIZE:
+            cvdlfilter->qos_queue_size = g_value_get_int (value);
+            break;
+        case PROP_QOS_LATENCY:
+            cvdlfilter->qos_latency = g_value_get_int (value);
+            break;
+        case PROP_PLACEMENT:
+            // it takes effect when the algo pipeline is created or swapped
+            g_free(cvdlfilter->placement);
+            cvdlfilter->placement = g_value_dup_string (value);
             break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
@@ -388,6 +654,27 @@ cvdl_filter_get_property (GObject* object, guint prop_id, GValue* value, GParamS
             else
                 g_value_set_string (value, default_algo_pipeline_desc);
             break;
+        case PROP_REORDER_TIME:
+            g_value_set_int (value, cvdlfilter->reorder_time);
+            break;
+        case PROP_WARMUP:
+            g_value_set_boolean (value, cvdlfilter->warmup);
+            break;
+        case PROP_STALL_TIMEOUT:
+            g_value_set_int (value, cvdlfilter->stall_timeout);
+            break;
+        case PROP_INFER_TIMEOUT:
+            g_value_set_int (value, cvdlfilter->infer_timeout);
+            break;
+        case PROP_QOS_QUEUE_SIZE:
+            g_value_set_int (value, cvdlfilter->qos_queue_size);
+            break;
+        case PROP_QOS_LATENCY:
+            g_value_set_int (value, cvdlfilter->qos_latency);
+            break;
+        case PROP_PLACEMENT:
+            g_value_set_string (value, cvdlfilter->placement);
+            break;
         default:
             G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
             break;
@@ -537,8 +824,12 @@ cvdl_filter_set_caps (GstBaseTransform* trans, GstCaps* incaps, GstCaps* outcaps
     priv->width = info.width;
     priv->height = info.height;
 
+    if(priv->inCaps)
+        gst_caps_unref(priv->inCaps);
     priv->inCaps = gst_caps_ref(incaps);
+    g_mutex_lock(&cvdlfilter->swapLock);
     algo_pipeline_set_caps_all(cvdlfilter->algoHandle, incaps);
+    g_mutex_unlock(&cvdlfilter->swapLock);
 
     return TRUE;
 }
@@ -578,6 +869,49 @@ cvdl_filter_class_init (CvdlFilterClass * klass)
              "yolov1tiny ! opticalflowtrack ! googlenetv2",
              G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+    g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_REORDER_TIME,
+         g_param_spec_int ("reorder-time", "ReorderTime",
+             "Max time(ms) to hold a frame which is done earlier than its previous frames, 0 - disable reordering",
+             0, 10000, DEFAULT_REORDER_TIME,
+             G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_WARMUP,
+         g_param_spec_boolean ("warmup", "Warmup",
+             "Run a synthetic inference on every infer request when a network is loaded, so that the first frames don't pay the device initialization",
+             DEFAULT_WARMUP,
+             G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_STALL_TIMEOUT,
+         g_param_spec_int ("stall-timeout", "StallTimeout",
+             "Max time(ms) a frame waits in the queue of an algo before a cvdl-stall message is posted, 0 - disable",
+             0, 600000, DEFAULT_STALL_TIMEOUT,
+             G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_INFER_TIMEOUT,
+         g_param_spec_int ("infer-timeout", "InferTimeout",
+             "Max time(ms) of an infer request before a cvdl-stall message is posted, 0 - disable",
+             0, 600000, DEFAULT_INFER_TIMEOUT,
+             G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_QOS_QUEUE_SIZE,
+         g_param_spec_int ("qos-queue-size", "QosQueueSize",
+             "Number of cached frames in algo pipeline regarded as full load, overflow QoS events are sent upstream beyond it, 0 - disable",
+             0, 1000, DEFAULT_QOS_QUEUE_SIZE,
+             G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_QOS_LATENCY,
+         g_param_spec_int ("qos-latency", "QosLatency",
+             "Max time(ms) a frame waits in algo queues regarded as full load, overflow QoS events are sent upstream beyond it, 0 - disable",
+             0, 600000, DEFAULT_QOS_LATENCY,
+             G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
+    g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_PLACEMENT,
+         g_param_spec_string ("placement", "Placement",
+             "CPUs of algo threads, \"<cpus>;<algo>=<cpus>;...\", cpus is a CPU list like \"0-3,8\" or \"node<N>\" for NUMA node N, "
+             "memory of the threads is preferred on the node of their CPUs, NULL - not pinned",
+             NULL,
+             G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
     gst_element_class_add_pad_template (elem_class, gst_static_pad_template_get (&cvdl_src_factory));
     gst_element_class_add_pad_template (elem_class, gst_static_pad_template_get (&cvdl_sink_factory));
 
@@ -599,10 +933,30 @@ static void push_buffer_func(gpointer userData)
     GstBaseTransform *trans = GST_BASE_TRANSFORM_CAST (userData);
     GstBuffer *outbuf = NULL;
     void *data = NULL;
+    AlgoPipelineHandle handle;
+    gboolean draining, eos;
+
+    // the frames of a replaced algo pipeline are pushed before the new one
+    g_mutex_lock(&cvdl_filter->swapLock);
+    draining = (cvdl_filter->drainAlgoHandle != 0);
+    handle = draining ? cvdl_filter->drainAlgoHandle : cvdl_filter->algoHandle;
+    g_mutex_unlock(&cvdl_filter->swapLock);
 
     // get data from output queue, and attach it into outbuf
     // if no data in output queue, return NULL;
-    algo_pipeline_get_buffer(cvdl_filter->algoHandle, &outbuf);
+    eos = !algo_pipeline_get_buffer(handle, &outbuf);
+
+    if(draining) {
+        g_mutex_lock(&cvdl_filter->swapLock);
+        // got EOS of the replaced algo pipeline, release it to swapThread,
+        // a NULL outbuf without EOS is a timeout, its frames may still come
+        if(eos)
+            cvdl_filter->drainAlgoHandle = 0;
+        g_cond_broadcast(&cvdl_filter->swapCond);
+        g_mutex_unlock(&cvdl_filter->swapLock);
+        if(eos)
+            return;
+    }
 
     cvdl_filter->frame_num_out++;
     if(outbuf) {
@@ -619,24 +973,77 @@ static void push_buffer_func(gpointer userData)
 }
 
 
+// period(ms) of watch dog, a quarter of the smallest SLO
+static gint64 watch_dog_period(CvdlFilter *cvdl_filter)
+{
+    gint period = 500;
+
+    if(cvdl_filter->stall_timeout > 0 && cvdl_filter->stall_timeout/4 < period)
+        period = cvdl_filter->stall_timeout/4;
+    if(cvdl_filter->infer_timeout > 0 && cvdl_filter->infer_timeout/4 < period)
+        period = cvdl_filter->infer_timeout/4;
+    if(period < 50)
+        period = 50;
+    return period;
+}
+
 // watch dog thread
+// It checks the heartbeats of each algo: the oldest frame in its queue and its running infer requests,
+// a cvdl-stall element message is posted on the bus when one of them is over its SLO.
 static void watch_dog_func(gpointer userData)
 {
     CvdlFilter* cvdl_filter = (CvdlFilter* )userData;
-    int num = 200;
-    int current_frame_num = cvdl_filter->frame_num;
-
-    while(num-->0 && !cvdl_filter->mQuited) {
-        if(cvdl_filter->frame_num > current_frame_num)
+    AlgoStallReport report;
+    GstStructure *s = NULL;
+    gboolean stalled = FALSE;
+    gint64 end_time;
+
+    g_mutex_lock(&cvdl_filter->wdLock);
+    end_time = g_get_monotonic_time() + watch_dog_period(cvdl_filter) * G_TIME_SPAN_MILLISECOND;
+    while(!cvdl_filter->mQuited) {
+        if(!g_cond_wait_until(&cvdl_filter->wdCond, &cvdl_filter->wdLock, end_time))
             break;
-        g_usleep(500000); //500ms
     }
+    g_mutex_unlock(&cvdl_filter->wdLock);
+    if(cvdl_filter->mQuited)
+        return;
 
-    if(num<=0) {
+    if(g_get_monotonic_time() - cvdl_filter->lastInputTime > WATCH_DOG_NO_DATA_TIMEOUT * G_TIME_SPAN_MILLISECOND) {
         cvdl_filter->mQuited = true;
         char *error_info = "Not get data for too long!\n";
         pipeline_report_error_info((GstElement *)cvdl_filter,error_info);
+        // nothing to do until it is restarted
+        gst_task_pause(cvdl_filter->mWDTask);
+        return;
     }
+
+    g_mutex_lock(&cvdl_filter->swapLock);
+    if(cvdl_filter->algoHandle)
+        stalled = algo_pipeline_check_stall(cvdl_filter->algoHandle, cvdl_filter->stall_timeout,
+                                            cvdl_filter->infer_timeout, &report);
+    // report once for each stall
+    if(stalled && !cvdl_filter->stallReported) {
+        g_print("cvdlfilter: %s(%d) stalls, %s for %ld ms, idle for %ld ms, queue size = %d\n",
+            report.algo_name, report.algo_index,
+            report.type == eAlgoStallType_Infer ? "infer" : "queue",
+            report.duration/1000, report.idle/1000, report.queue_size);
+        s = gst_structure_new("cvdl-stall",
+            "algo", G_TYPE_STRING, report.algo_name,
+            "algo-index", G_TYPE_INT, report.algo_index,
+            "type", G_TYPE_STRING, report.type == eAlgoStallType_Infer ? "infer" : "queue",
+            "request", G_TYPE_INT, report.request_id,
+            "duration-ms", G_TYPE_INT64, report.duration/1000,
+            "idle-ms", G_TYPE_INT64, report.idle/1000,
+            "queue-size", G_TYPE_INT, report.queue_size,
+            NULL);
+    }
+    cvdl_filter->stallReported = stalled;
+    g_mutex_unlock(&cvdl_filter->swapLock);
+
+    // post it without swapLock, the bus handler may set properties
+    if(s)
+        gst_element_post_message(GST_ELEMENT(cvdl_filter),
+            gst_message_new_element(GST_OBJECT(cvdl_filter), s));
 }
 
 static void
@@ -655,9 +1062,25 @@ cvdl_filter_init (CvdlFilter* cvdl_filter)
     gst_video_info_init (&cvdl_filter->src_info);
 
     cvdl_filter->frame_num = 0;
+    cvdl_filter->reorder_time = DEFAULT_REORDER_TIME;
+    cvdl_filter->warmup = DEFAULT_WARMUP;
+    cvdl_filter->stall_timeout = DEFAULT_STALL_TIMEOUT;
+    cvdl_filter->infer_timeout = DEFAULT_INFER_TIMEOUT;
+    cvdl_filter->lastInputTime = g_get_monotonic_time();
+    cvdl_filter->stallReported = FALSE;
+    cvdl_filter->qos_queue_size = DEFAULT_QOS_QUEUE_SIZE;
+    cvdl_filter->qos_latency = DEFAULT_QOS_LATENCY;
+    cvdl_filter->qosLevel = 0;
+    cvdl_filter->placement = NULL;
     cvdl_filter->startTimePos = g_get_monotonic_time();
     cvdl_filter->mQuited = false;
 
+    cvdl_filter->drainAlgoHandle = 0;
+    cvdl_filter->swapCancelled = FALSE;
+    cvdl_filter->swapThread = NULL;
+    g_mutex_init (&cvdl_filter->swapLock);
+    g_cond_init (&cvdl_filter->swapCond);
+
     // create task for push data to next filter/element
     g_rec_mutex_init (&cvdl_filter->mMutex);
     cvdl_filter->mPushTask = gst_task_new (push_buffer_func, (gpointer)cvdl_filter, NULL);
@@ -666,6 +1089,8 @@ cvdl_filter_init (CvdlFilter* cvdl_filter)
     gst_task_set_leave_callback (cvdl_filter->mPushTask, NULL, NULL, NULL);
 
     // create Watch dog task
+    g_mutex_init (&cvdl_filter->wdLock);
+    g_cond_init (&cvdl_filter->wdCond);
     g_rec_mutex_init (&cvdl_filter->mWDMutex);
     cvdl_filter->mWDTask = gst_task_new (watch_dog_func, (gpointer)cvdl_filter, NULL);
     gst_task_set_lock (cvdl_filter->mWDTask, &cvdl_filter->mWDMutex);
@@ -55,6 +55,10 @@ struct _CvdlFilter
 
     CvdlFilterPrivate*  priv;
     gchar* algo_pipeline_desc;
+    // max time(ms) to hold an out-of-order frame for reordering
+    gint reorder_time;
+    // warm up infer requests when networks are loaded
+    gboolean warmup;
 
     GstTask *mPushTask;
     GRecMutex mMutex;
@@ -65,6 +69,30 @@ struct _CvdlFilter
     GstTask *mWDTask;
     GRecMutex mWDMutex;
     gboolean mQuited;
+    // wake up watch dog when quit
+    GMutex wdLock;
+    GCond wdCond;
+    // SLO(ms) of each algo, 0 - disable
+    gint stall_timeout;
+    gint infer_timeout;
+    gint64 lastInputTime;
+    gboolean stallReported;
+    // load of algo pipeline to send QoS events upstream, 0 - disable
+    gint qos_queue_size;
+    gint qos_latency;
+    // 0 - normal, 1 - full, 2 - overloaded
+    gint qosLevel;
+    // CPUs of algo threads, see algo_pipeline_set_placement()
+    gchar *placement;
+
+    // hot swap of algo pipeline, with swapLock
+    // algoHandle is replaced by a new one which is built in swapThread,
+    // and the old one is drained in push task before it is destroyed.
+    AlgoPipelineHandle drainAlgoHandle;
+    gboolean swapCancelled;
+    GMutex swapLock;
+    GCond swapCond;
+    GThread *swapThread;
     // debug
     int frame_num_in;
     int frame_num_out;
@@ -37,6 +37,16 @@ GST_DEBUG_CATEGORY_STATIC (gst_ipc_sink_debug);
 #define GST_IPC_SINK_GET_PRIVATE(obj)  \
    (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GST_TYPE_IPC_SINK, GstIpcSinkPrivate))
 
+// bit buffer and txt buffer with the same pts
+typedef struct _IpcSinkPair
+{
+    GstClockTime ts;
+    GstBuffer *bit_buf;
+    GstBuffer *txt_buf;
+    // monotonic time to give up waiting the other buffer
+    gint64 deadline;
+} IpcSinkPair;
+
 struct _GstIpcSinkPrivate
 {
     // number of received and processed buffers
@@ -44,6 +54,22 @@ struct _GstIpcSinkPrivate
     guint64 bit_processed_num;
     guint64 txt_received_num;
     guint64 txt_processed_num;
+
+    // with LOCK
+    // unmatched pairs, keyed by pts
+    GHashTable *pair_table;
+    // unmatched pairs in arrival order, the head has the earliest deadline
+    GQueue pair_queue;
+    // pairs to be sent
+    GQueue ready_queue;
+    // the latest pts which has been sent without its bit/txt buffer
+    GstClockTime expired_ts;
+    guint64 expired_num;
+    // the latest pts received from each pad, buffers arrive in pts order
+    GstClockTime bit_last_ts;
+    GstClockTime txt_last_ts;
+    // don't wait unmatched pairs any more, such as EOS
+    gboolean flushing;
 };
 
 // IpcSink properties
@@ -53,11 +79,13 @@ enum
     PROP_IPC_SERVER_URI,
     PROP_IPC_CLIENT_ID,
     PROP_IPC_CLIENT_PROXY,
+    PROP_PAIR_TIMEOUT,
     PROP_LAST
 };
 
 #define INVALID_IPCC_PROXY  ((void *)(-1))
 #define TXT_BUFFER_SIZE_MAX 1024
+#define DEFAULT_PAIR_TIMEOUT 100
 
 static const char gst_ipc_bit_src_caps_str[] = "image/jpeg";
 static GstStaticPadTemplate gst_ipc_bit_src_factory =
@@ -78,118 +106,150 @@ static GstElementClass *parent_class = NULL;
 
 static void gst_ipc_sink_get_times (GstIpcSink * basesink, GstBuffer * buffer, GstClockTime * start);
 
-#define INVALID_BUFFER_TS (-1)
-// Get the bit buffer and txt buffer with the same ts
-// If not, find the earliest buffer as the output
-static gboolean get_buffers_with_same_ts(GstIpcSink * basesink, GstBuffer **bit_buf, GstBuffer **txt_buf)
+static void ipc_sink_pair_free(IpcSinkPair *pair)
 {
-    GstBuffer *bit_buf_temp, *txt_buf_temp;
-    GstClockTime bit_ts=INVALID_BUFFER_TS;
-    GstClockTime txt_ts=INVALID_BUFFER_TS;
-    GstIpcSinkPrivate *priv = basesink->priv;
+    if(pair->bit_buf)
+        gst_buffer_unref(pair->bit_buf);
+    if(pair->txt_buf)
+        gst_buffer_unref(pair->txt_buf);
+    g_free(pair);
+}
 
-    txt_buf_temp = NULL;
-    bit_buf_temp = NULL;
+// Move an unmatched pair into ready queue, with LOCK
+static void ipc_sink_pair_ready(GstIpcSink * basesink, IpcSinkPair *pair, gboolean expired)
+{
+    GstIpcSinkPrivate *priv = basesink->priv;
 
-    // Try to get a buffer of bitstream
-    GST_IPC_SINK_BIT_LOCK(basesink);
-    if(gst_buffer_list_length(basesink->bit_list)>0) {
-        bit_buf_temp = gst_buffer_list_get(basesink->bit_list,0);
-        gst_ipc_sink_get_times(basesink, bit_buf_temp, &bit_ts);
+    g_hash_table_remove(priv->pair_table, &pair->ts);
+    g_queue_remove(&priv->pair_queue, pair);
+    if(expired) {
+        if(!GST_CLOCK_TIME_IS_VALID(priv->expired_ts) || pair->ts > priv->expired_ts)
+            priv->expired_ts = pair->ts;
+        priv->expired_num++;
+        GST_LOG_OBJECT(basesink, "pair expired: ts = %" GST_TIME_FORMAT ", bit = %p, txt = %p",
+            GST_TIME_ARGS(pair->ts), pair->bit_buf, pair->txt_buf);
     }
-    GST_IPC_SINK_BIT_UNLOCK(basesink);
+    g_queue_push_tail(&priv->ready_queue, pair);
+}
 
-    // Try to get a buffer of txt data
-    GST_IPC_SINK_TXT_LOCK(basesink);
-    if(gst_buffer_list_length(basesink->txt_list)>0) {
-        txt_buf_temp = gst_buffer_list_get(basesink->txt_list,0);
-        gst_ipc_sink_get_times(basesink, txt_buf_temp, &txt_ts);
-    }
-    GST_IPC_SINK_TXT_UNLOCK(basesink);
-
-    // Improvement need: align bit buffer and txt buffer
-    // can not get any, return NULL
-    if(G_UNLIKELY((!bit_buf_temp && !txt_buf_temp))) {
-        *txt_buf = NULL;
-        *bit_buf = NULL;
-        return FALSE;
-    }
+// Give up the pairs waiting for a buffer from one pad with pts before ts, with LOCK
+// The pad has passed them, so their buffers will never arrive
+static void ipc_sink_pair_pass(GstIpcSink * basesink, GstClockTime ts, gboolean is_bit)
+{
+    GstIpcSinkPrivate *priv = basesink->priv;
+    GList *l = priv->pair_queue.head;
 
-    // If bit buffer is early, only return it
-    if(G_UNLIKELY(bit_ts < txt_ts)){
-        GST_IPC_SINK_BIT_LOCK(basesink);
-        gst_buffer_list_remove(basesink->bit_list, 0, 1);
-        GST_IPC_SINK_BIT_UNLOCK(basesink);
-        priv->bit_processed_num++;
-        *txt_buf = NULL;
-        *bit_buf = bit_buf_temp;
-        return TRUE;
+    while(l) {
+        IpcSinkPair *pair = (IpcSinkPair *)l->data;
+        l = l->next;
+        if(pair->ts < ts && !(is_bit ? pair->bit_buf : pair->txt_buf))
+            ipc_sink_pair_ready(basesink, pair, TRUE);
     }
+}
 
-    // If txt buffer is early, only return it
-    if(G_UNLIKELY(txt_ts < bit_ts)){
-        GST_IPC_SINK_TXT_LOCK(basesink);
-        gst_buffer_list_remove(basesink->txt_list, 0, 1);
-        GST_IPC_SINK_TXT_UNLOCK(basesink);
-        priv->txt_processed_num++;
-        *txt_buf = txt_buf_temp;
-        *bit_buf = NULL;
-        return TRUE;
+// Put a buffer into pair table, it will be ready to send if:
+//     1. the buffer with the same pts from other pad has been here
+//     2. other pad is not linked, or its buffer with the same pts has been given up
+//     3. other pad has passed this pts
+// Unmatched pairs are given up once this pad passes them, the pair timeout only
+// applies when the other pad stalls.
+static void ipc_sink_pair_add(GstIpcSink * basesink, GstBuffer *buf, gboolean is_bit)
+{
+    GstIpcSinkPrivate *priv = basesink->priv;
+    GstPad *other_pad = is_bit ? basesink->sinkpad_txt : basesink->sinkpad_bit;
+    GstClockTime *last_ts = is_bit ? &priv->bit_last_ts : &priv->txt_last_ts;
+    GstClockTime other_last_ts;
+    IpcSinkPair *pair = NULL;
+    GstClockTime ts;
+
+    gst_ipc_sink_get_times(basesink, buf, &ts);
+
+    GST_IPC_SINK_LOCK(basesink);
+    if(!GST_CLOCK_TIME_IS_VALID(*last_ts) || ts > *last_ts) {
+        *last_ts = ts;
+        ipc_sink_pair_pass(basesink, ts, is_bit);
     }
+    other_last_ts = is_bit ? priv->txt_last_ts : priv->bit_last_ts;
 
-    if(bit_buf_temp) {
-        GST_IPC_SINK_BIT_LOCK(basesink);
-        gst_buffer_list_remove(basesink->bit_list, 0, 1);
-        GST_IPC_SINK_BIT_UNLOCK(basesink);
-        priv->bit_processed_num++;
+    pair = (IpcSinkPair *)g_hash_table_lookup(priv->pair_table, &ts);
+    if(pair && (is_bit ? pair->bit_buf : pair->txt_buf)) {
+        // duplicated pts, send the old one alone
+        ipc_sink_pair_ready(basesink, pair, TRUE);
+        pair = NULL;
     }
 
-    if(txt_buf_temp) {
-        GST_IPC_SINK_TXT_LOCK(basesink);
-        gst_buffer_list_remove(basesink->txt_list, 0, 1);
-        GST_IPC_SINK_TXT_UNLOCK(basesink);
-        priv->txt_processed_num++;
+    if(!pair) {
+        pair = g_new0(IpcSinkPair, 1);
+        pair->ts = ts;
+        if(!gst_pad_is_linked(other_pad) || (GST_CLOCK_TIME_IS_VALID(priv->expired_ts)
+            && ts <= priv->expired_ts) || (GST_CLOCK_TIME_IS_VALID(other_last_ts)
+            && ts < other_last_ts)) {
+            // no need to wait
+            if(is_bit)
+                pair->bit_buf = buf;
+            else
+                pair->txt_buf = buf;
+            g_queue_push_tail(&priv->ready_queue, pair);
+            GST_IPC_SINK_BROADCAST(basesink);
+            GST_IPC_SINK_UNLOCK(basesink);
+            return;
+        }
+        pair->deadline = g_get_monotonic_time() + basesink->pair_timeout * G_TIME_SPAN_MILLISECOND;
+        g_hash_table_insert(priv->pair_table, &pair->ts, pair);
+        g_queue_push_tail(&priv->pair_queue, pair);
     }
 
-    *txt_buf = txt_buf_temp;
-    *bit_buf = bit_buf_temp;
-
-    return TRUE;
+    if(is_bit)
+        pair->bit_buf = buf;
+    else
+        pair->txt_buf = buf;
+    if(pair->bit_buf && pair->txt_buf)
+        ipc_sink_pair_ready(basesink, pair, FALSE);
+    GST_IPC_SINK_BROADCAST(basesink);
+    GST_IPC_SINK_UNLOCK(basesink);
 }
 
-
+// with LOCK
 static gboolean data_list_is_empty(GstIpcSink * basesink)
 {
-    int num = 0;
-    // try to get a buffer of bitstream
-    GST_IPC_SINK_BIT_LOCK(basesink);
-    num = gst_buffer_list_length(basesink->bit_list);
-    GST_IPC_SINK_BIT_UNLOCK(basesink);
-
-    // try to get a buffer of txt data
-    GST_IPC_SINK_TXT_LOCK(basesink);
-    num += gst_buffer_list_length(basesink->txt_list);
-    GST_IPC_SINK_TXT_UNLOCK(basesink);
-
-    return num<=0;
+    GstIpcSinkPrivate *priv = basesink->priv;
+    return g_queue_is_empty(&priv->pair_queue) && g_queue_is_empty(&priv->ready_queue);
 }
-// Main function to processed buffer into next filter
-//      1. package jpeg bitstream and inference result data
-//      2. send out by WebSocket
-static void process_sink_buffers(gpointer userData)
+
+// Wait until some pairs are ready or expired, and take all of them
+static gboolean get_ready_pairs(GstIpcSink * basesink, GQueue *pairs)
 {
-    GstIpcSink *basesink;
-    basesink = GST_IPC_SINK (userData);
-    GstBuffer *bit_buf = NULL, *txt_buf = NULL;
-    gboolean ret = FALSE;
-    int i = 0;
-    gsize data_len = 0, size = 0;
+    GstIpcSinkPrivate *priv = basesink->priv;
+    IpcSinkPair *pair = NULL;
 
-    ret = get_buffers_with_same_ts(basesink, &bit_buf, &txt_buf);
-    if(ret==FALSE) {
-        g_usleep(10000);
-        return;
+    GST_IPC_SINK_LOCK(basesink);
+    while(basesink->running) {
+        gint64 now = g_get_monotonic_time();
+        while((pair = (IpcSinkPair *)g_queue_peek_head(&priv->pair_queue))
+            && (priv->flushing || pair->deadline <= now))
+            ipc_sink_pair_ready(basesink, pair, TRUE);
+
+        if(!g_queue_is_empty(&priv->ready_queue))
+            break;
+
+        if(pair)
+            GST_IPC_SINK_WAIT_UNTIL(basesink, pair->deadline);
+        else
+            GST_IPC_SINK_WAIT(basesink);
     }
+    *pairs = priv->ready_queue;
+    g_queue_init(&priv->ready_queue);
+    GST_IPC_SINK_UNLOCK(basesink);
+
+    return !g_queue_is_empty(pairs);
+}
+
+// Package jpeg bitstream and inference result data, and send out
+static void send_sink_buffers(GstIpcSink * basesink, GstBuffer *bit_buf, GstBuffer *txt_buf)
+{
+    GstIpcSinkPrivate *priv = basesink->priv;
+    int i = 0;
+    gsize data_len = 0, size = 0;
 
     //setup ipcclient
     if(!basesink->ipc_handle) {
@@ -205,21 +265,21 @@ static void process_sink_buffers(gpointer userData)
     if(txt_buf) {
         ResMemory *txt_mem = NULL;
         txt_mem = RES_MEMORY_CAST(res_memory_acquire(txt_buf));
-        if(!txt_mem || !txt_mem->data || !txt_mem->data_count) {
+        if(!txt_mem || !txt_mem->result || !txt_mem->result->object_count) {
             g_print("Failed to get data from txt buffer!!!\n");
         }else{
             // Packaged txt data into json file and sent out
-            InferenceData *infer_data = txt_mem->data;
-            int count = txt_mem->data_count;
+            CvdlFrameResult *result = txt_mem->result;
+            int count = result->object_count;
             GST_LOG("object num = %d\n",count);
-            infer_data->frame_index = basesink->frame_index;
-            data_len = ipcclient_send_infer_data_full_frame(basesink->ipc_handle,
-                infer_data, count,txt_mem->pts,basesink->meta_data_index);
+            data_len = ipcclient_send_frame_result(basesink->ipc_handle,
+                result, basesink->frame_index, txt_mem->pts, basesink->meta_data_index);
             basesink->meta_data_index+=count;
             size += data_len;
             if(count>0)
                 basesink->frame_index++;
         }
+        priv->txt_processed_num++;
     }
     basesink->data_size += size;
 
@@ -246,14 +306,51 @@ static void process_sink_buffers(gpointer userData)
         basesink->data_size += size;
         for (i = 0; i < n; ++i)
             gst_memory_unmap (mapInfo[i].memory, &mapInfo[i]);
+        priv->bit_processed_num++;
     }
     basesink->duration += g_get_monotonic_time() - start_time;
+}
 
-    // release buffer
-    if(bit_buf)
-        gst_buffer_unref(bit_buf);
-    if(txt_buf)
-        gst_buffer_unref(txt_buf);
+// Main function to processed buffer into next filter
+//      1. wait bit buffer and txt buffer with the same pts, or they are expired
+//      2. send out by IPC
+static void process_sink_buffers(gpointer userData)
+{
+    GstIpcSink *basesink;
+    basesink = GST_IPC_SINK (userData);
+    IpcSinkPair *pair = NULL;
+    GQueue pairs;
+
+    if(!get_ready_pairs(basesink, &pairs))
+        return;
+
+    while((pair = (IpcSinkPair *)g_queue_pop_head(&pairs))) {
+        send_sink_buffers(basesink, pair->bit_buf, pair->txt_buf);
+        ipc_sink_pair_free(pair);
+    }
+
+    // wake up the draining in state change
+    GST_IPC_SINK_LOCK(basesink);
+    GST_IPC_SINK_BROADCAST(basesink);
+    GST_IPC_SINK_UNLOCK(basesink);
+}
+
+// Drop all pairs which have not been sent
+static void clear_sink_buffers(GstIpcSink * basesink)
+{
+    GstIpcSinkPrivate *priv = basesink->priv;
+    IpcSinkPair *pair = NULL;
+
+    GST_IPC_SINK_LOCK(basesink);
+    g_hash_table_remove_all(priv->pair_table);
+    while((pair = (IpcSinkPair *)g_queue_pop_head(&priv->pair_queue)))
+        ipc_sink_pair_free(pair);
+    while((pair = (IpcSinkPair *)g_queue_pop_head(&priv->ready_queue)))
+        ipc_sink_pair_free(pair);
+    priv->expired_ts = GST_CLOCK_TIME_NONE;
+    priv->bit_last_ts = GST_CLOCK_TIME_NONE;
+    priv->txt_last_ts = GST_CLOCK_TIME_NONE;
+    GST_IPC_SINK_UNLOCK(basesink);
 }
 
 static GstCaps *
@@ -315,6 +412,9 @@ gst_ipc_sink_set_property (GObject * object, guint prop_id,
      case PROP_IPC_CLIENT_PROXY:
         sink->ipc_handle_proxy=g_value_get_pointer(value);
         break;
+    case PROP_PAIR_TIMEOUT:
+        sink->pair_timeout = g_value_get_int(value);
+        break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -337,6 +437,9 @@ gst_ipc_sink_get_property (GObject * object, guint prop_id, GValue * value,
     case PROP_IPC_CLIENT_PROXY:
         g_value_set_pointer(value, sink->ipc_handle_proxy);
         break;
+    case PROP_PAIR_TIMEOUT:
+        g_value_set_int (value, sink->pair_timeout);
+        break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -378,6 +481,12 @@ gst_ipc_sink_event (GstPad * pad, GstObject * parent, GstEvent * event)
     }
     case GST_EVENT_EOS:
     {
+      // no more buffer will come to pair with the waiting ones
+      GST_IPC_SINK_LOCK(basesink);
+      basesink->priv->flushing = TRUE;
+      GST_IPC_SINK_BROADCAST(basesink);
+      GST_IPC_SINK_UNLOCK(basesink);
+
       // EOS message is used to trigger the state change
       GstMessage *message = gst_message_new_eos (GST_OBJECT_CAST (basesink));
       gst_element_post_message (GST_ELEMENT_CAST (basesink), message);
@@ -398,10 +507,10 @@ static void gst_ipc_sink_get_times (GstIpcSink * basesink, GstBuffer * buffer, G
 {
   GstClockTime timestamp;
 
-  /* first sync on DTS, else use PTS */
-  timestamp = GST_BUFFER_DTS (buffer);
+  /* first sync on PTS, else use DTS */
+  timestamp = GST_BUFFER_PTS (buffer);
   if (!GST_CLOCK_TIME_IS_VALID (timestamp))
-    timestamp = GST_BUFFER_PTS (buffer);
+    timestamp = GST_BUFFER_DTS (buffer);
 
   if (GST_CLOCK_TIME_IS_VALID (timestamp)) {
     *start = timestamp;
@@ -418,12 +527,9 @@ gst_ipc_sink_bit_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
     basesink = GST_IPC_SINK (parent);
     GstIpcSinkPrivate *priv = basesink->priv;
 
-    // put buffer into bufferlist
-    GST_IPC_SINK_BIT_LOCK(parent);
-    buf = gst_buffer_ref(buf);
-    gst_buffer_list_add(basesink->bit_list, buf);
+    // put buffer into pair table, the buffer is owned by it
     priv->bit_received_num++;
-    GST_IPC_SINK_BIT_UNLOCK(parent);
+    ipc_sink_pair_add(basesink, buf, TRUE);
 
     return GST_FLOW_OK;
 }
@@ -435,12 +541,9 @@ gst_ipc_sink_txt_chain (GstPad * pad, GstObject * parent, GstBuffer * buf)
     basesink = GST_IPC_SINK (parent);
     GstIpcSinkPrivate *priv = basesink->priv;
 
-    // put buffer into bufferlist
-    GST_IPC_SINK_TXT_LOCK(parent);
-    buf = gst_buffer_ref(buf);
-    gst_buffer_list_add(basesink->txt_list, buf);
+    // put buffer into pair table, the buffer is owned by it
     priv->txt_received_num++;
-    GST_IPC_SINK_TXT_UNLOCK(parent);
+    ipc_sink_pair_add(basesink, buf, FALSE);
 
     return GST_FLOW_OK;
 }
@@ -568,10 +671,17 @@ gst_ipc_sink_change_state (GstElement * element, GstStateChange transition)
             break;
         case GST_STATE_CHANGE_READY_TO_PAUSED:
             GST_DEBUG_OBJECT (basesink, "READY to PAUSED");
+            GST_IPC_SINK_LOCK(basesink);
+            basesink->priv->flushing = FALSE;
+            GST_IPC_SINK_UNLOCK(basesink);
             break;
          case GST_STATE_CHANGE_PAUSED_TO_PLAYING:
             GST_DEBUG_OBJECT (basesink, "PAUSED to PLAYING, don't need preroll");
 
+            GST_IPC_SINK_LOCK(basesink);
+            basesink->running = TRUE;
+            GST_IPC_SINK_UNLOCK(basesink);
+
             // create task for push data to next filter/element
             basesink->task = gst_task_new (process_sink_buffers, (gpointer)basesink, NULL);
             gst_task_set_lock (basesink->task, &basesink->task_lock);
@@ -597,14 +707,31 @@ gst_ipc_sink_change_state (GstElement * element, GstStateChange transition)
         case GST_STATE_CHANGE_PLAYING_TO_PAUSED:
             GST_DEBUG_OBJECT (basesink, "PLAYING to PAUSED");
             g_print("IPCSink: PLAYING to PAUSED\n");
-            int times = 20;
-            while(!data_list_is_empty(basesink) && times-->0) {
-                g_usleep(10000);
+            // send out the waiting buffers in 200ms
+            GST_IPC_SINK_LOCK(basesink);
+            basesink->priv->flushing = TRUE;
+            GST_IPC_SINK_BROADCAST(basesink);
+            gint64 end_time = g_get_monotonic_time() + 200 * G_TIME_SPAN_MILLISECOND;
+            while(!data_list_is_empty(basesink)) {
+                if(!GST_IPC_SINK_WAIT_UNTIL(basesink, end_time))
+                    break;
             }
-            // stop task
+            GST_IPC_SINK_UNLOCK(basesink);
+
+            // stop task, and wake it up if it is waiting
             gst_task_stop(basesink->task);
+            GST_IPC_SINK_LOCK(basesink);
+            basesink->running = FALSE;
+            GST_IPC_SINK_BROADCAST(basesink);
+            GST_IPC_SINK_UNLOCK(basesink);
             gst_task_join(basesink->task);
             gst_object_unref(basesink->task);
+            basesink->task = NULL;
+
+            if(basesink->priv->expired_num)
+                g_print("IPCSink: %ld frames were sent without jpeg or meta data\n",
+                    basesink->priv->expired_num);
+            clear_sink_buffers(basesink);
             break;
         case GST_STATE_CHANGE_PAUSED_TO_READY:
             GST_DEBUG_OBJECT (basesink, "PAUSED to READY");
@@ -663,6 +790,13 @@ gst_ipc_sink_class_init (GstIpcSinkClass * klass)
           "IPC(Socket) client proxy to connected to its server.",
           G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
 
+    g_object_class_install_property (G_OBJECT_CLASS (klass), PROP_PAIR_TIMEOUT,
+      g_param_spec_int ("pair-timeout", "Pair timeout",
+          "Max time(ms) to wait the jpeg and meta data with the same pts, "
+          "the one without its pair will be sent alone after it",
+          0, 10000, DEFAULT_PAIR_TIMEOUT,
+          G_PARAM_READWRITE | G_PARAM_STATIC_STRINGS));
+
     // 2 src pads
     gst_element_class_add_pad_template (gstelement_class,
       gst_static_pad_template_get (&gst_ipc_bit_src_factory));
@@ -709,10 +843,11 @@ gst_ipc_sink_init (GstIpcSink * basesink, gpointer g_class)
     priv->txt_received_num = 0;
     priv->txt_processed_num = 0;
 
+    basesink->running = FALSE;
+    basesink->task = NULL;
+    basesink->pair_timeout = DEFAULT_PAIR_TIMEOUT;
     g_mutex_init (&basesink->lock);
     g_cond_init (&basesink->cond);
-    g_mutex_init (&basesink->bit_lock);
-    g_mutex_init (&basesink->txt_lock);
 
     pad_template =
         gst_element_class_get_pad_template (GST_ELEMENT_CLASS (g_class), "sink_bit");
@@ -742,9 +877,15 @@ gst_ipc_sink_init (GstIpcSink * basesink, gpointer g_class)
 
     GST_OBJECT_FLAG_SET (basesink, GST_ELEMENT_FLAG_SINK);
 
-    // create buffer list
-    basesink->bit_list = gst_buffer_list_new ();
-    basesink->txt_list = gst_buffer_list_new ();
+    // create pair table
+    priv->pair_table = g_hash_table_new (g_int64_hash, g_int64_equal);
+    g_queue_init (&priv->pair_queue);
+    g_queue_init (&priv->ready_queue);
+    priv->expired_ts = GST_CLOCK_TIME_NONE;
+    priv->expired_num = 0;
+    priv->bit_last_ts = GST_CLOCK_TIME_NONE;
+    priv->txt_last_ts = GST_CLOCK_TIME_NONE;
+    priv->flushing = FALSE;
 
     g_rec_mutex_init (&basesink->task_lock);
 }
@@ -761,14 +902,12 @@ gst_ipc_sink_finalize (GObject * object)
         basesink->ipc_handle = NULL;
     }
 
+    clear_sink_buffers(basesink);
+    g_hash_table_destroy (basesink->priv->pair_table);
+
     g_mutex_clear (&basesink->lock);
     g_cond_clear (&basesink->cond);
 
-    gst_buffer_list_unref (basesink->bit_list);
-    gst_buffer_list_unref (basesink->txt_list);
-    //g_mutex_clear(&basesink->bit_lock);
-    //g_mutex_clear(&basesink->txt_lock);
-
     if(basesink->ipcs_uri)
         g_free (basesink->ipcs_uri);
     basesink->ipcs_uri=NULL;
@@ -45,23 +45,11 @@ G_BEGIN_DECLS
 #define GST_IPC_SINK_TRYLOCK(obj)    (g_mutex_trylock(GST_IPC_SINK_GET_LOCK(obj)))
 #define GST_IPC_SINK_UNLOCK(obj)     (g_mutex_unlock(GST_IPC_SINK_GET_LOCK(obj)))
 
-#define GST_IPC_SINK_BIT_GET_LOCK(obj)   (&GST_IPC_SINK_CAST(obj)->bit_lock)
-#define GST_IPC_SINK_BIT_LOCK(obj)       (g_mutex_lock(GST_IPC_SINK_BIT_GET_LOCK(obj)))
-#define GST_IPC_SINK_BIT_TRYLOCK(obj)    (g_mutex_trylock(GST_IPC_SINK_BIT_GET_LOCK(obj)))
-#define GST_IPC_SINK_BIT_UNLOCK(obj)     (g_mutex_unlock(GST_IPC_SINK_BIT_GET_LOCK(obj)))
-
-#define GST_IPC_SINK_TXT_GET_LOCK(obj)   (&GST_IPC_SINK_CAST(obj)->txt_lock)
-#define GST_IPC_SINK_TXT_LOCK(obj)       (g_mutex_lock(GST_IPC_SINK_TXT_GET_LOCK(obj)))
-#define GST_IPC_SINK_TXT_TRYLOCK(obj)    (g_mutex_trylock(GST_IPC_SINK_TXT_GET_LOCK(obj)))
-#define GST_IPC_SINK_TXT_UNLOCK(obj)     (g_mutex_unlock(GST_IPC_SINK_TXT_GET_LOCK(obj)))
-
-
-
 #define GST_IPC_SINK_GET_COND(obj)   (&GST_IPC_SINK_CAST(obj)->cond)
 #define GST_IPC_SINK_WAIT(obj)       \
-      g_cond_wait (GST_IPC_SINK_GET_PREROLL_COND (obj), GST_IPC_SINK_GET_COND (obj))
+      g_cond_wait (GST_IPC_SINK_GET_COND (obj), GST_IPC_SINK_GET_LOCK (obj))
 #define GST_IPC_SINK_WAIT_UNTIL(obj, end_time) \
-      g_cond_wait_until (GST_IPC_SINK_GET_COND (obj), GST_IPC_SINK_GET_COND (obj), end_time)
+      g_cond_wait_until (GST_IPC_SINK_GET_COND (obj), GST_IPC_SINK_GET_LOCK (obj), end_time)
 #define GST_IPC_SINK_SIGNAL(obj)     g_cond_signal (GST_IPC_SINK_GET_COND (obj));
 #define GST_IPC_SINK_BROADCAST(obj)  g_cond_broadcast (GST_IPC_SINK_GET_COND (obj));
 
@@ -86,11 +74,8 @@ struct _GstIpcSink {
   GMutex         lock;
   GCond          cond;
 
-  // bufferlist for sink pad data
-  GstBufferList *bit_list;
-  GMutex bit_lock;
-  GstBufferList *txt_list;
-  GMutex txt_lock;
+  // max time(ms) to wait the bit/txt buffer with the same pts
+  gint pair_timeout;
 
   // task for websock
   GstTask *task;
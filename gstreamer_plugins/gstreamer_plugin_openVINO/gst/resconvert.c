@@ -107,33 +107,11 @@ GST_STATIC_PAD_TEMPLATE (
 // static guint res_convert_signals[LAST_SIGNAL] = { 0 };
 extern VideoSurfaceID gst_get_mfx_surface(GstBuffer* inbuf, GstVideoInfo *info, VideoDisplayID *display);
 
+// txt buffer shares the frame result of cvdl_meta
 static GstFlowReturn
 res_convert_fill_txt_data(ResMemory *res_mem, CvdlMeta *cvdl_meta)
 {
-    InferenceData *dst ;
-    InferenceMeta *src = cvdl_meta->inference_result;
-    int count = cvdl_meta->meta_count;
-    size_t size = 0;
-
-    if(!src || !count)
-        return GST_FLOW_OK;
-
-    // count out the number of object inference and resize dat memory
-    res_memory_data_resize((GstMemory *)res_mem,count);
-
-    if(!res_mem->data)
-        return GST_FLOW_OK;
- 
-    dst = res_mem->data; 
-    for(int i=0; i<count; i++) {
-        dst[i].rect = src->rect;
-        dst[i].probility = src->probility;
-        strcpy_s(dst[i].label,128, src->label);
-        size = src->track_count*sizeof(VideoPoint);
-        memcpy_s(dst[i].track, size, src->track, size);
-        dst[i].track_num = src->track_count;
-        src = src->next;
-    }
+    res_memory_set_result((GstMemory *)res_mem, cvdl_meta->result);
     return GST_FLOW_OK;
 }
 
@@ -619,7 +597,7 @@ res_convert_init (ResConvert * convertor)
             "Convert inference result into OSD");
 
     GstCaps *caps = gst_caps_new_simple ("video/x-raw", "format", G_TYPE_STRING, "BGRA", NULL);
-    gst_caps_set_simple (caps, "width", G_TYPE_INT, sizeof(InferenceData), "height",
+    gst_caps_set_simple (caps, "width", G_TYPE_INT, sizeof(CvdlFrameResult), "height",
       G_TYPE_INT, 1, NULL);
 
     // Create sink pad
@@ -632,7 +610,7 @@ res_convert_init (ResConvert * convertor)
     gst_element_add_pad (GST_ELEMENT (convertor), convertor->sinkpad);
 
     // create a pool for src_txt buffer
-    convertor->src_pool = res_pool_create (caps, sizeof(InferenceData), 3, 10);
+    convertor->src_pool = res_pool_create (caps, sizeof(CvdlFrameResult), 3, 10);
     gst_caps_unref(caps);
 
     // create src pads
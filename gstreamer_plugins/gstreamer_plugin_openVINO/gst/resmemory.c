@@ -80,24 +80,12 @@ res_buffer_alloc (GstBufferPool* pool)
     return buffer;
 }
 
-void res_memory_data_resize(GstMemory *memory, int count)
+void res_memory_set_result(GstMemory *memory, CvdlFrameResult *result)
 {
-    if(count==0) {
-        RES_MEMORY_DATA_COUNT(memory) = 0;
-        g_free(RES_MEMORY_DATA(memory));
-        RES_MEMORY_DATA(memory) = NULL;
-        return;
-    }
+    CvdlFrameResult *old = RES_MEMORY_RESULT(memory);
 
-    if(RES_MEMORY_DATA_COUNT(memory) == count)
-        return;
-
-    if(RES_MEMORY_DATA_COUNT(memory)==0){
-        RES_MEMORY_DATA(memory) = g_new0(InferenceData, count);
-    } else {
-        RES_MEMORY_DATA(memory) = g_try_renew(InferenceData, RES_MEMORY_DATA(memory), count);
-    }
-    RES_MEMORY_DATA_COUNT(memory) = count;
+    RES_MEMORY_RESULT(memory) = cvdl_frame_result_ref(result);
+    cvdl_frame_result_unref(old);
 }
 
 // Called when gst_object_unref(memory)
@@ -107,13 +95,8 @@ res_memory_free (GstAllocator* allocator, GstMemory* memory)
     if (!allocator || !memory)
         return;
 
-    InferenceData *data = RES_MEMORY_DATA(memory);
-    //int count = RES_MEMORY_DATA_COUNT(memory);
-    // g_print("res_memory_free: res_mem = %p, res_mem->data=%p\n",memory, data );
-    if(data)
-        g_free(data);
-    RES_MEMORY_DATA(memory) = NULL;
-    RES_MEMORY_DATA_COUNT(memory) = 0;
+    cvdl_frame_result_unref(RES_MEMORY_RESULT(memory));
+    RES_MEMORY_RESULT(memory) = NULL;
 
     g_free (memory);
 }
@@ -124,7 +107,7 @@ res_memory_map (GstMemory* memory, gsize size, GstMapFlags flags)
     gpointer data = 0;
     ResMemory *res_mem = RES_MEMORY_CAST(memory);
 
-    data = (gpointer)res_mem->data;
+    data = (gpointer)res_mem->result;
     return data;
 }
 static void
@@ -21,6 +21,7 @@
 
 #include <gst/gst.h>
 #include <interface/videodefs.h>
+#include <ocl/metadata.h>
 
 G_BEGIN_DECLS
 
@@ -30,8 +31,8 @@ typedef struct _ResAllocatorClass ResAllocatorClass;
 
 struct _ResMemory {
     GstMemory   parent;
-    InferenceData *data;
-    int         data_count;
+    // shared with CvdlMeta of the video frame, not copied
+    CvdlFrameResult *result;
     guint64 pts;
 };
 
@@ -44,8 +45,7 @@ struct _ResAllocatorClass {
 };
 
 #define RES_MEMORY_CAST(memory)    ((ResMemory*)memory)
-#define RES_MEMORY_DATA(memory)    (RES_MEMORY_CAST (memory)->data)
-#define RES_MEMORY_DATA_COUNT(memory)    (RES_MEMORY_CAST (memory)->data_count)
+#define RES_MEMORY_RESULT(memory)  (RES_MEMORY_CAST (memory)->result)
 #define RES_MEMORY_PTS(memory)     (RES_MEMORY_CAST (memory)->pts)
 
 #define RES_MEMORY_QUARK            res_memory_quark()
@@ -67,7 +67,8 @@ ResMemory* res_memory_acquire (GstBuffer* buffer);
 GstBuffer* res_buffer_alloc (GstBufferPool* pool);
 GstAllocator* res_allocator_new (void);
 
-void res_memory_data_resize(GstMemory *memory, int count);
+// take a reference of result, and release the old one
+void res_memory_set_result(GstMemory *memory, CvdlFrameResult *result);
 
 G_END_DECLS
 
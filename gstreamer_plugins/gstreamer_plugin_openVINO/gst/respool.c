@@ -59,10 +59,8 @@ res_memory_alloc (ResPool* respool)
     ResMemory *res_mem = g_new0(ResMemory, 1);
     GstMemory *parent;
 
-    res_mem->data = g_new0(InferenceData, 1);
-    res_mem->data_count = 1;
+    res_mem->result = NULL;
     res_mem->pts  = 0;
-    //g_print("res_memory_alloc: res_mem = %p, res_mem->data=%p\n",res_mem, res_mem->data );
 
     // find the real parent
     if ((parent = res_mem->parent.parent) == NULL)
@@ -74,7 +72,7 @@ res_memory_alloc (ResPool* respool)
 
     GstMemory *memory = GST_MEMORY_CAST (res_mem);
     gst_memory_init (memory, GST_MEMORY_FLAG_NO_SHARE, priv->allocator, parent,
-         sizeof(InferenceData), 0, 0, sizeof(InferenceData));
+         sizeof(CvdlFrameResult), 0, 0, sizeof(CvdlFrameResult));
 
     return memory;
 }
@@ -97,7 +95,7 @@ res_pool_alloc (GstBufferPool* pool, GstBuffer** buffer,
         return GST_FLOW_ERROR;
     }
 
-    //GDestroyNotify need to release InferenceData?
+    //GDestroyNotify need to release CvdlFrameResult?
     // gst_mini_object_set_qdata (GST_MINI_OBJECT_CAST (res_mem),
     //     RES_MEMORY_QUARK, GST_MEMORY_CAST (res_mem),
     //     (GDestroyNotify) gst_memory_unref);